@@ -113,6 +113,7 @@ BuildRequires: gsettings-desktop-schemas-devel >= 3.15
 BuildRequires: gdb-headless
 #addon-kerneloops
 BuildRequires: systemd-devel
+BuildRequires: libzstd-devel
 BuildRequires: %{libjson_devel}
 %if %{with bodhi}
 # plugin-bodhi
@@ -247,6 +248,19 @@ Requires: abrt-libs = %{version}-%{release}
 This package contains plugin for collecting Xorg crash information from Xorg
 log.
 
+%package addon-journal
+Summary: %{name}'s combined systemd-journal watcher
+Requires: %{name} = %{version}-%{release}
+Requires: abrt-libs = %{version}-%{release}
+Requires: abrt-addon-ccpp
+Requires: abrt-addon-kerneloops
+Requires: abrt-addon-xorg
+
+%description addon-journal
+This package contains a service watching systemd-journal for core dumps,
+kernel oopses and Xorg crashes in one process. It replaces the journal
+services of the ccpp, kerneloops and xorg addons.
+
 %package addon-vmcore
 Summary: %{name}'s vmcore addon
 Requires: %{name} = %{version}-%{release}
@@ -513,6 +527,7 @@ find %{buildroot} -name "*.py[co]" -delete
 # remove all .la and .a files
 find %{buildroot} -name '*.la' -or -name '*.a' | xargs rm -f
 mkdir -p %{buildroot}%{_localstatedir}/cache/abrt-di
+mkdir -p %{buildroot}%{_localstatedir}/cache/abrt-symbols
 mkdir -p %{buildroot}%{_localstatedir}/lib/abrt
 mkdir -p %{buildroot}%{_localstatedir}/run/abrt
 mkdir -p %{buildroot}%{_localstatedir}/spool/abrt-upload
@@ -563,12 +578,16 @@ fi
 
 %post addon-kerneloops
 %systemd_post abrt-oops.service
+%systemd_post abrt-kmsg-oops.service
 %journal_catalog_update
 
 %post addon-xorg
 %systemd_post abrt-xorg.service
 %journal_catalog_update
 
+%post addon-journal
+%systemd_post abrt-journal.service
+
 %if %{with python3}
 %post -n python3-abrt-addon
 %journal_catalog_update
@@ -592,10 +611,14 @@ fi
 
 %preun addon-kerneloops
 %systemd_preun abrt-oops.service
+%systemd_preun abrt-kmsg-oops.service
 
 %preun addon-xorg
 %systemd_preun abrt-xorg.service
 
+%preun addon-journal
+%systemd_preun abrt-journal.service
+
 %preun addon-vmcore
 %systemd_preun abrt-vmcore.service
 
@@ -613,10 +636,14 @@ fi
 
 %postun addon-kerneloops
 %systemd_postun_with_restart abrt-oops.service
+%systemd_postun_with_restart abrt-kmsg-oops.service
 
 %postun addon-xorg
 %systemd_postun_with_restart abrt-xorg.service
 
+%postun addon-journal
+%systemd_postun_with_restart abrt-journal.service
+
 %postun addon-vmcore
 %systemd_postun_with_restart abrt-vmcore.service
 
@@ -791,9 +818,11 @@ killall abrt-dbus >/dev/null 2>&1 || :
 
 %files addon-ccpp
 %dir %attr(0775, abrt, abrt) %{_localstatedir}/cache/abrt-di
+%dir %attr(0770, abrt, abrt) %{_localstatedir}/cache/abrt-symbols
 %config(noreplace) %{_sysconfdir}/%{name}/plugins/CCpp.conf
 %{_mandir}/man5/abrt-CCpp.conf.5*
 %{_libexecdir}/abrt-gdb-exploitable
+%{_libexecdir}/abrt-unpack-coredump
 %config(noreplace) %{_sysconfdir}/libreport/plugins/catalog_journal_ccpp_format.conf
 %{_unitdir}/abrt-journal-core.service
 %{_journalcatalogdir}/abrt_ccpp.catalog
@@ -804,6 +833,7 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %attr(2755, abrt, abrt) %{_libexecdir}/abrt-action-install-debuginfo-to-abrt-cache
 
 %{_bindir}/abrt-action-analyze-c
+%{_bindir}/abrt-action-analyze-ccpp-core
 %{_bindir}/abrt-action-trim-files
 %{_bindir}/abrt-action-analyze-core
 %{_bindir}/abrt-action-analyze-vulnerability
@@ -830,6 +860,7 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %{_datadir}/libreport/events/collect_vimrc_system.xml
 %{_datadir}/libreport/events/post_report.xml
 %{_mandir}/man*/abrt-action-analyze-c.*
+%{_mandir}/man*/abrt-action-analyze-ccpp-core.*
 %{_mandir}/man*/abrt-action-trim-files.*
 %{_mandir}/man*/abrt-action-generate-backtrace.*
 %{_mandir}/man*/abrt-action-generate-core-backtrace.*
@@ -863,14 +894,17 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %{_mandir}/man5/koops_event.conf.5*
 %config(noreplace) %{_sysconfdir}/%{name}/plugins/oops.conf
 %{_unitdir}/abrt-oops.service
+%{_unitdir}/abrt-kmsg-oops.service
 
 %dir %{_localstatedir}/lib/abrt
 
 %{_bindir}/abrt-dump-oops
 %{_bindir}/abrt-dump-journal-oops
+%{_bindir}/abrt-dump-kmsg-oops
 %{_bindir}/abrt-action-analyze-oops
 %{_mandir}/man1/abrt-dump-oops.1*
 %{_mandir}/man1/abrt-dump-journal-oops.1*
+%{_mandir}/man1/abrt-dump-kmsg-oops.1*
 %{_mandir}/man1/abrt-action-analyze-oops.1*
 %{_mandir}/man5/abrt-oops.conf.5*
 
@@ -887,6 +921,11 @@ killall abrt-dbus >/dev/null 2>&1 || :
 %{_mandir}/man5/abrt-xorg.conf.5*
 %{_mandir}/man5/xorg_event.conf.5*
 
+%files addon-journal
+%{_unitdir}/abrt-journal.service
+%{_bindir}/abrt-dump-journal
+%{_mandir}/man1/abrt-dump-journal.1*
+
 %files addon-vmcore
 %config(noreplace) %{_sysconfdir}/libreport/events.d/vmcore_event.conf
 %{_mandir}/man5/vmcore_event.conf.5*
@@ -69,10 +69,16 @@ def match_lookup(patterns, authenticate=False, executables=None, components=None
     Return problems that match `in_arg` passed on command line
     '''
 
-    problems = problem.list(auth=authenticate)
-
     if not patterns:
-        return sort_problems(problems)[:1]
+        return sort_problems(problem.list(auth=authenticate))[:1]
+
+    # Let the service leave out problems that cannot match; the problems are
+    # filtered here again because not all proxies can filter them.
+    problems = problem.list(auth=authenticate,
+                            components=components,
+                            executables=executables,
+                            since=since,
+                            not_reported=not_reported)
 
     if '*' not in patterns:
         id_matches = filter_ids(problems, patterns)
@@ -196,6 +196,111 @@ static void dup_corebt_fini(void)
     corebt = NULL;
 }
 
+/* Checks whether the problem directory dump_dir_name2 is a duplicate of the
+ * currently processed problem. Returns 1 and sets crash_dump_dup_name if it
+ * is.
+ */
+static int is_dup_candidate_a_dup(const char *dump_dir_name, const char *dump_dir_name2,
+                                  const char *container_id)
+{
+    int retval = 0;
+    struct dump_dir *dd = NULL;
+    g_autofree char *dd_uid = NULL, *dd_type = NULL;
+    g_autofree char *dd_executable = NULL, *dd_container_id = NULL;
+
+    if (strcmp(dump_dir_name, dump_dir_name2) == 0)
+        goto next; /* we are never a dup of ourself */
+
+    int sv_logmode = libreport_logmode;
+    /* Silently ignore any error in the silent log level. */
+    libreport_logmode = libreport_g_verbose == 0 ? 0 : sv_logmode;
+    dd = dd_opendir(dump_dir_name2, /*flags:*/ DD_FAIL_QUIETLY_ENOENT | DD_OPEN_READONLY);
+    libreport_logmode = sv_logmode;
+    if (!dd)
+        goto next;
+
+    /* problems from different containers are not duplicates */
+    if (container_id != NULL)
+    {
+        dd_container_id = dd_load_text_ext(dd, FILENAME_CONTAINER_ID, DD_FAIL_QUIETLY_ENOENT);
+        if (dd_container_id != NULL && strcmp(container_id, dd_container_id) != 0)
+        {
+            goto next;
+        }
+    }
+
+    /* crashes of different users are not considered duplicates */
+    dd_uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
+    if (strcmp(uid, dd_uid))
+    {
+        goto next;
+    }
+
+    /* different crash types are not duplicates */
+    dd_type = dd_load_text_ext(dd, FILENAME_TYPE, DD_FAIL_QUIETLY_ENOENT);
+    if (strcmp(type, dd_type))
+    {
+        goto next;
+    }
+
+    /* different executables are not duplicates */
+    dd_executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, DD_FAIL_QUIETLY_ENOENT);
+    if (     (executable != NULL && dd_executable == NULL)
+         ||  (executable == NULL && dd_executable != NULL)
+         || ((executable != NULL && dd_executable != NULL)
+              && strcmp(executable, dd_executable) != 0))
+    {
+        goto next;
+    }
+
+    if (dup_uuid_compare(dd)
+     || dup_corebt_compare(dd)
+    ) {
+        crash_dump_dup_name = g_strdup(dump_dir_name2);
+        retval = 1; /* "run_event, please stop iterating" */
+    }
+
+next:
+    dd_close(dd);
+    return retval;
+}
+
+/* Looks for a duplicate among the problem directories of the same user, type
+ * and executable found in the dedup index maintained by abrtd.
+ */
+static int find_dup_in_dedup_index(const char *dump_dir_name, const char *container_id)
+{
+    int retval = 0;
+    GList *entries = abrt_dedup_index_lookup(abrt_g_settings_dump_location, uid, type, executable);
+    for (GList *iter = entries; iter != NULL && crash_dump_dup_name == NULL; iter = g_list_next(iter))
+    {
+        struct abrt_dedup_entry *entry = (struct abrt_dedup_entry *)iter->data;
+
+        /* problems from different containers are not duplicates */
+        if (container_id != NULL && entry->container_id != NULL
+            && strcmp(container_id, entry->container_id) != 0)
+            continue;
+
+        /* Don't open directories that cannot match, dup_uuid_compare() is
+         * used only if there is no core backtrace.
+         */
+        if (uuid != NULL && corebt == NULL
+            && entry->uuid != NULL && strcmp(uuid, entry->uuid) != 0)
+            continue;
+
+        char *tmp_concat_path = g_build_filename(abrt_g_settings_dump_location, entry->dirname, NULL);
+        g_autofree char *dump_dir_name2 = realpath(tmp_concat_path, NULL);
+        free(tmp_concat_path);
+        if (!dump_dir_name2)
+            continue;
+
+        retval = is_dup_candidate_a_dup(dump_dir_name, dump_dir_name2, container_id);
+    }
+    abrt_dedup_entry_list_free(entries);
+
+    return retval;
+}
+
 /* This function is run after each post-create event is finished (there may be
  * multiple such events).
  *
@@ -214,6 +319,9 @@ static void dup_corebt_fini(void)
  * iterates over all other dump directories and compares this UUID to their
  * UUID. If there is a match, the path to the duplicate is saved and 1 is returned.
  *
+ * If abrtd has indexed the dump location, only the directories of problems of
+ * the same user, type and executable are visited.
+ *
  * If duplicate is not found as described above, the function returns 0 and we
  * either process remaining events if there are any, or successfully terminate
  * processing of the current dump directory.
@@ -237,6 +345,12 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
     /* dump_dir_name can be relative */
     dump_dir_name = realpath(dump_dir_name, NULL);
 
+    if (abrt_dedup_index_is_ready())
+    {
+        retval = find_dup_in_dedup_index(dump_dir_name, container_id);
+        goto end;
+    }
+
     DIR *dir = opendir(abrt_g_settings_dump_location);
     if (dir == NULL)
         goto end;
@@ -252,8 +366,6 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         if (ext && strcmp(ext, ".new") == 0)
             continue; /* skip anything named "<dirname>.new" */
 
-        dd = NULL;
-
         char *tmp_concat_path = g_build_filename(abrt_g_settings_dump_location, dent->d_name, NULL);
 
         g_autofree char *dump_dir_name2 = realpath(tmp_concat_path, NULL);
@@ -265,65 +377,7 @@ static int is_crash_a_dup(const char *dump_dir_name, void *param)
         if (!dump_dir_name2)
             continue;
 
-        g_autofree char *dd_uid = NULL, *dd_type = NULL;
-        g_autofree char *dd_executable = NULL, *dd_container_id = NULL;
-
-        if (strcmp(dump_dir_name, dump_dir_name2) == 0)
-            goto next; /* we are never a dup of ourself */
-
-        int sv_logmode = libreport_logmode;
-        /* Silently ignore any error in the silent log level. */
-        libreport_logmode = libreport_g_verbose == 0 ? 0 : sv_logmode;
-        dd = dd_opendir(dump_dir_name2, /*flags:*/ DD_FAIL_QUIETLY_ENOENT | DD_OPEN_READONLY);
-        libreport_logmode = sv_logmode;
-        if (!dd)
-            goto next;
-
-        /* problems from different containers are not duplicates */
-        if (container_id != NULL)
-        {
-            dd_container_id = dd_load_text_ext(dd, FILENAME_CONTAINER_ID, DD_FAIL_QUIETLY_ENOENT);
-            if (dd_container_id != NULL && strcmp(container_id, dd_container_id) != 0)
-            {
-                goto next;
-            }
-        }
-
-        /* crashes of different users are not considered duplicates */
-        dd_uid = dd_load_text_ext(dd, FILENAME_UID, DD_FAIL_QUIETLY_ENOENT);
-        if (strcmp(uid, dd_uid))
-        {
-            goto next;
-        }
-
-        /* different crash types are not duplicates */
-        dd_type = dd_load_text_ext(dd, FILENAME_TYPE, DD_FAIL_QUIETLY_ENOENT);
-        if (strcmp(type, dd_type))
-        {
-            goto next;
-        }
-
-        /* different executables are not duplicates */
-        dd_executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, DD_FAIL_QUIETLY_ENOENT);
-        if (     (executable != NULL && dd_executable == NULL)
-             ||  (executable == NULL && dd_executable != NULL)
-             || ((executable != NULL && dd_executable != NULL)
-                  && strcmp(executable, dd_executable) != 0))
-        {
-            goto next;
-        }
-
-        if (dup_uuid_compare(dd)
-         || dup_corebt_compare(dd)
-        ) {
-            crash_dump_dup_name = dump_dir_name2;
-            dump_dir_name2 = NULL;
-            retval = 1; /* "run_event, please stop iterating" */
-            /* sonce crash_dump_dup_name != NULL now, we exit the loop */
-        }
-
-next:
-        dd_close(dd);
+        retval = is_dup_candidate_a_dup(dump_dir_name, dump_dir_name2, container_id);
     }
     closedir(dir);
 
@@ -453,6 +507,17 @@ int main(int argc, char **argv)
         if (r != 0)
             return r; /* yes */
 
+        /* The new problem is not a duplicate, let the next ones find it */
+        if (post_create)
+        {
+            dd = dd_opendir(dump_dir_name, DD_OPEN_READONLY);
+            if (dd)
+            {
+                abrt_dedup_index_add(dd);
+                dd_close(dd);
+            }
+        }
+
         dump_dir_name = NULL;
     }
 
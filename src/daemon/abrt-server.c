@@ -15,7 +15,9 @@
   with this program; if not, write to the Free Software Foundation, Inc.,
   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 */
+#include <poll.h>
 #include <glib-unix.h>
+#include <glib/gstdio.h>
 #include "problem_api.h"
 #include "abrt_glib.h"
 #include "libabrt.h"
@@ -26,6 +28,8 @@
 #define MAX_MESSAGE_SIZE (4*MAX_BACKTRACE_SIZE)
 /* Maximal number of characters read from socket at once. */
 #define INPUT_BUFFER_SIZE (8*1024)
+/* Longer values are written to the problem directory while they are received. */
+#define MAX_BUFFERED_VALUE_SIZE (64*1024)
 /* We exit after this many seconds */
 #define TIMEOUT 10
 
@@ -72,15 +76,47 @@ MANDATORY ITEMS:
    \0
 
 You can send more messages using the same KEY=value format.
+
+The server does not keep long values in memory. Once a value grows over
+MAX_BUFFERED_VALUE_SIZE, it is written to a temporary problem directory
+(abrt-server-*.new) while it is being received. The directory is renamed
+when the request is complete or deleted if the request is rejected. The
+values the server looks at (pid, executable, type, ...) are always kept in
+memory.
+
+** Protocol version 2
+
+A request starting with ABRT_SOCKET_V2_MAGIC (the first byte is NUL, so it
+can't be confused with the text protocol) creates a new problem from typed,
+length-prefixed elements described in libabrt.h (struct
+abrt_socket_v2_element). Values are binary safe and a value can be passed
+as a file descriptor of a regular file or a memfd (SCM_RIGHTS), which is
+copied to the problem directory without going through the socket. The
+request ends with an END element and the reply is the same as in the text
+protocol. The sizes of passed files count towards MAX_MESSAGE_SIZE and the
+whole request must arrive within TIMEOUT seconds. Use
+abrt_problem_socket_open() and friends to send it.
+
+** Worker mode
+
+With -w, abrt-server does not handle the client connected on its standard
+input. Instead, it is a long-lived worker started by abrtd: stdin is a control
+socket over which abrtd passes accepted client sockets (SCM_RIGHTS), one at
+a time. The worker handles the client exactly as a freshly executed
+abrt-server would and then writes "REQUEST_DONE" to stderr to let abrtd know
+it can take the next client. The worker exits when abrtd closes the control
+socket.
 */
 
-static int g_signal_pipe[2];
+static int g_signal_pipe[2] = { -1, -1 };
 static struct ns_ids g_ns_ids;
 
 struct waiting_context
 {
     GMainLoop *main_loop;
     const char *dirname;
+    /* Zero once the watch removes itself */
+    guint signal_watch;
     int retcode;
     enum abrt_daemon_reply
     {
@@ -89,17 +125,19 @@ struct waiting_context
     } reply;
 };
 
-static unsigned total_bytes_read = 0;
-
 static pid_t client_pid = (pid_t)-1L;
 static uid_t client_uid = (uid_t)-1L;
 
+/* The problem directory receiving long values of the current request */
+static struct dump_dir *g_staging_dd;
+
 static void
 handle_signal(int signo)
 {
     int save_errno = errno;
     uint8_t sig_caught = signo;
-    if (write(g_signal_pipe[1], &sig_caught, 1))
+    /* Late signals received after waiting for abrtd are not interesting */
+    if (g_signal_pipe[1] >= 0 && write(g_signal_pipe[1], &sig_caught, 1))
         /* we ignore result, if () shuts up stupid compiler */;
     errno = save_errno;
 }
@@ -118,7 +156,10 @@ handle_signal_pipe_cb(GIOChannel *gio, GIOCondition condition, gpointer user_dat
         if (stat == G_IO_STATUS_ERROR)
             error_msg_and_die(_("Can't read from gio channel: '%s'"), error ? error->message : "");
         if (stat == G_IO_STATUS_EOF)
+        {
+            ((struct waiting_context *)user_data)->signal_watch = 0;
             return G_SOURCE_REMOVE;
+        }
         if (stat == G_IO_STATUS_AGAIN)
             break;
 
@@ -143,6 +184,7 @@ handle_signal_pipe_cb(GIOChannel *gio, GIOCondition condition, gpointer user_dat
         }
 
         g_main_loop_quit(context->main_loop);
+        context->signal_watch = 0;
         return G_SOURCE_REMOVE;
     }
 
@@ -268,6 +310,8 @@ struct response
 {
     int code;
     char *message;
+    /* The client has already received the reply */
+    bool sent;
 };
 
 #define RESPONSE_SETTER(r, c, m) \
@@ -357,15 +401,21 @@ static int run_post_create(const char *dirname, struct response *resp)
     signal(SIGUSR1, handle_signal);
     signal(SIGINT, handle_signal);
     GIOChannel *channel_signal = abrt_gio_channel_unix_new(g_signal_pipe[0]);
-    g_io_add_watch(channel_signal, G_IO_IN | G_IO_PRI, handle_signal_pipe_cb, &context);
+    context.signal_watch = g_io_add_watch(channel_signal, G_IO_IN | G_IO_PRI, handle_signal_pipe_cb, &context);
 
     g_idle_add(emit_new_problem_signal, &context);
 
     g_main_loop_run(context.main_loop);
 
+    /* The worker takes next clients, the watch must not outlive the context */
+    if (context.signal_watch != 0)
+        g_source_remove(context.signal_watch);
+
     g_main_loop_unref(context.main_loop);
+    /* Closes the reading end of the pipe */
     g_io_channel_unref(channel_signal);
     close(g_signal_pipe[1]);
+    g_signal_pipe[0] = g_signal_pipe[1] = -1;
 
     log_notice("Waiting finished");
 
@@ -475,34 +525,51 @@ static int run_post_create(const char *dirname, struct response *resp)
      */
     if ((status != 0 && dup_of_dir) || count == 0)
     {
-        count++;
-        char new_count_str[sizeof(long)*3 + 2];
-        sprintf(new_count_str, "%lu", count);
-        dd_save_text(dd, FILENAME_COUNT, new_count_str);
+        /* The new directory can stand for more occurrences, e.g. a storm of
+         * the same kernel oops saved by abrt-dump-oops */
+        unsigned long occurrences = 1;
+        g_autofree char *last_ocr = NULL;
 
         /* This condition can be simplified to either
          * (status * != 0 && * dup_of_dir) or (count == 1). But the
          * chosen form is much more reliable and safe. We must not call
          * dd_opendir() to locked dd otherwise we go into a deadlock.
          */
-        if (strcmp(dd->dd_dirname, dirname) != 0)
+        const bool is_dup = strcmp(dd->dd_dirname, dirname) != 0;
+        if (is_dup)
         {
             /* Update the last occurrence file by the time file of the new problem */
             struct dump_dir *new_dd = dd_opendir(dirname, DD_OPEN_READONLY);
-            g_autofree char *last_ocr = NULL;
             if (new_dd)
             {
+                g_autofree char *new_count_str = dd_load_text_ext(new_dd, FILENAME_COUNT,
+                            DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT);
+                const unsigned long new_count = new_count_str ? strtoul(new_count_str, NULL, 10) : 0;
+                if (new_count > 1)
+                    occurrences = new_count;
+
+                last_ocr = dd_load_text_ext(new_dd, FILENAME_LAST_OCCURRENCE,
+                            DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT);
                 /* TIME must exists in a valid dump directory but we don't want to die
                  * due to broken duplicated dump directory */
-                last_ocr = dd_load_text_ext(new_dd, FILENAME_TIME,
-                            DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT);
+                if (!last_ocr)
+                    last_ocr = dd_load_text_ext(new_dd, FILENAME_TIME,
+                                DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT);
                 dd_close(new_dd);
             }
             else
             {   /* dd_opendir() already produced a message with good information about failure */
                 error_msg("Can't read the last occurrence file from the new dump directory.");
             }
+        }
+
+        count += occurrences;
+        char new_count_str[sizeof(long)*3 + 2];
+        sprintf(new_count_str, "%lu", count);
+        dd_save_text(dd, FILENAME_COUNT, new_count_str);
 
+        if (is_dup)
+        {
             if (!last_ocr)
             {   /* the new dump directory may lie in the dump location for some time */
                 log_warning("Using current time for the last occurrence file which may be incorrect.");
@@ -566,7 +633,7 @@ static int run_post_create(const char *dirname, struct response *resp)
  * Caller must ensure that all fields in struct client
  * are properly filled.
  */
-static int create_problem_dir(GHashTable *problem_info, unsigned pid)
+static void exit_if_low_free_space(void)
 {
     /* Exit if free space is less than 1/4 of MaxCrashReportsSize */
     if (abrt_g_settings_nMaxCrashReportsSize > 0)
@@ -574,6 +641,27 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
         if (abrt_low_free_space(abrt_g_settings_nMaxCrashReportsSize, abrt_g_settings_dump_location))
             exit(1);
     }
+}
+
+static void delete_staging_dir(void)
+{
+    if (g_staging_dd)
+    {
+        log_debug("Deleting unused problem directory '%s'", g_staging_dd->dd_dirname);
+        dd_delete(g_staging_dd);
+        g_staging_dd = NULL;
+    }
+}
+
+static int create_problem_dir(GHashTable *problem_info, unsigned pid)
+{
+    if (!g_staging_dd)
+        exit_if_low_free_space();
+
+    /* The process may be disappearing, read its /proc files first */
+    struct abrt_proc_snapshot *snapshot = abrt_proc_snapshot_new(pid);
+    if (!snapshot)
+        pwarn_msg("Cannot open /proc/%d:", pid);
 
     /* Create temp directory with the problem data.
      * This directory is renamed to final directory name after
@@ -596,29 +684,23 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
     /* No need to check the path length, as all variables used are limited,
      * and dd_create() fails if the path is too long.
      */
-    struct dump_dir *dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
-    if (!dd)
-    {
-        error_msg_and_die("Error creating problem directory '%s'", path);
-    }
-
-    const int proc_dir_fd = libreport_open_proc_pid_dir(pid);
-    g_autofree char *rootdir = NULL;
-
-    if (proc_dir_fd < 0)
+    struct dump_dir *dd = g_staging_dd;
+    if (dd)
     {
-        pwarn_msg("Cannot open /proc/%d:", pid);
+        /* Long values have already been saved */
+        if (dd_rename(dd, path) != 0)
+            error_msg_and_die("Error renaming problem directory '%s' to '%s'", dd->dd_dirname, path);
+        g_staging_dd = NULL;
     }
-    else if (libreport_process_has_own_root_at(proc_dir_fd))
+    else
+        dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
+    if (!dd)
     {
-        /* Obtain the root directory path only if process' root directory is
-         * not the same as the init's root directory
-         */
-        rootdir = libreport_get_rootdir_at(proc_dir_fd);
+        error_msg_and_die("Error creating problem directory '%s'", path);
     }
 
     /* Reading data from an arbitrary root directory is not secure. */
-    if (proc_dir_fd >= 0 && abrt_g_settings_explorechroots)
+    if (snapshot && abrt_g_settings_explorechroots)
     {
         char proc_pid_root[sizeof("/proc/[pid]/root") + sizeof(pid_t) * 3];
         const size_t w = snprintf(proc_pid_root, sizeof(proc_pid_root), "/proc/%d/root", pid);
@@ -626,77 +708,19 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
 
         /* Yes, test 'rootdir' but use 'source_filename' because 'rootdir' can
          * be '/' for a process with own namespace. 'source_filename' is /proc/[pid]/root. */
-        dd_create_basic_files(dd, client_uid, (rootdir != NULL) ? proc_pid_root : NULL);
+        dd_create_basic_files(dd, client_uid, (snapshot->rootdir != NULL) ? proc_pid_root : NULL);
     }
     else
     {
         dd_create_basic_files(dd, client_uid, NULL);
     }
 
-    if (proc_dir_fd >= 0)
+    if (snapshot)
     {
-        /* Obtain and save the command line. */
-        g_autofree char *cmdline = libreport_get_cmdline_at(proc_dir_fd);
-        if (cmdline)
-        {
-            dd_save_text(dd, FILENAME_CMDLINE, cmdline);
-        }
-
-        /* Obtain and save the environment variables. */
-        g_autofree char *environ = libreport_get_environ_at(proc_dir_fd);
-        if (environ)
-        {
-            dd_save_text(dd, FILENAME_ENVIRON, environ);
-        }
-
-        dd_copy_file_at(dd, FILENAME_CGROUP,    proc_dir_fd, "cgroup");
-        dd_copy_file_at(dd, FILENAME_MOUNTINFO, proc_dir_fd, "mountinfo");
-
-        FILE *open_fds = dd_open_item_file(dd, FILENAME_OPEN_FDS, O_RDWR);
-        if (open_fds)
-        {
-            if (libreport_dump_fd_info_at(proc_dir_fd, open_fds) < 0)
-                dd_delete_item(dd, FILENAME_OPEN_FDS);
-            fclose(open_fds);
-        }
-
-        const int init_proc_dir_fd = libreport_open_proc_pid_dir(1);
-        FILE *namespaces = dd_open_item_file(dd, FILENAME_NAMESPACES, O_RDWR);
-        if (namespaces && init_proc_dir_fd >= 0)
-        {
-            if (libreport_dump_namespace_diff_at(init_proc_dir_fd, proc_dir_fd, namespaces) < 0)
-                dd_delete_item(dd, FILENAME_NAMESPACES);
-        }
-        if (init_proc_dir_fd >= 0)
-            close(init_proc_dir_fd);
-        if (namespaces)
-            fclose(namespaces);
-
-        /* The process's root directory isn't the same as the init's root
-         * directory. */
-        if (rootdir)
-        {
-            if (strcmp(rootdir, "/") ==  0)
-            {   /* We are dealing containerized process because root's
-                 * directory path is '/' and that means that the process
-                 * has mounted its own root.
-                 * Seriously, it is possible if the process is running in its
-                 * own MOUNT namespaces.
-                 */
-                log_debug("Process %d is considered to be containerized", pid);
-                pid_t container_pid;
-                if (libreport_get_pid_of_container_at(proc_dir_fd, &container_pid) == 0)
-                {
-                    g_autofree char *container_cmdline = libreport_get_cmdline(container_pid);
-                    dd_save_text(dd, FILENAME_CONTAINER_CMDLINE, container_cmdline);
-                }
-            }
-            else
-            {   /* We are dealing chrooted process. */
-                dd_save_text(dd, FILENAME_ROOTDIR, rootdir);
-            }
-        }
-        close(proc_dir_fd);
+        /* cmdline, environ, cgroup, mountinfo, open fds, namespaces and the
+         * root directory or the container's cmdline */
+        abrt_proc_snapshot_save(snapshot, dd);
+        abrt_proc_snapshot_free(snapshot);
     }
 
     /* Store id of the user whose application crashed. */
@@ -717,9 +741,6 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
 
     dd_close(dd);
 
-    /* Not needing it anymore */
-    g_hash_table_destroy(problem_info);
-
     /* Move the completely created problem directory
      * to final directory.
      */
@@ -742,21 +763,19 @@ static int create_problem_dir(GHashTable *problem_info, unsigned pid)
     close(STDOUT_FILENO);
     libreport_xdup2(STDERR_FILENO, STDOUT_FILENO); /* paranoia: don't leave stdout fd closed */
 
-    /* Trim old problem directories if necessary */
-    if (abrt_g_settings_nMaxCrashReportsSize > 0)
-    {
-        abrt_trim_problem_dirs(abrt_g_settings_dump_location, abrt_g_settings_nMaxCrashReportsSize * (double)(1024*1024), path);
-    }
-
+    /* Old problem directories are trimmed by abrtd once it is notified about
+     * the new one in run_post_create(). abrtd keeps track of the sizes and
+     * doesn't have to walk the whole dump location.
+     */
     run_post_create(path, NULL);
 
-    /* free(path); */
-    exit(0);
+    g_free(path);
+    return 0;
 }
 
-static gboolean key_value_ok(gchar *key, gchar *value)
+static gboolean key_ok(const gchar *key)
 {
-    char *i;
+    const char *i;
 
     /* check key, it has to be valid filename and will end up in the
      * bugzilla */
@@ -766,6 +785,14 @@ static gboolean key_value_ok(gchar *key, gchar *value)
             return FALSE;
     }
 
+    return TRUE;
+}
+
+static gboolean key_value_ok(gchar *key, gchar *value)
+{
+    if (!key_ok(key))
+        return FALSE;
+
     /* check value of 'basename', it has to be valid non-hidden directory
      * name */
     if (strcmp(key, "basename") == 0
@@ -823,6 +850,145 @@ static void process_message(GHashTable *problem_info, char *message)
     }
 }
 
+/* The values the server looks at or checks are never written to disk
+ * before the request is complete.
+ */
+static bool value_must_be_buffered(const char *key)
+{
+    return strcmp(key, "basename") == 0
+        || strcmp(key, FILENAME_TYPE) == 0
+        || strcmp(key, FILENAME_PID) == 0
+        || strcmp(key, FILENAME_EXECUTABLE) == 0
+        || strcmp(key, FILENAME_REASON) == 0
+        || strcmp(key, FILENAME_UID) == 0
+        || problem_entry_is_post_create_condition(key);
+}
+
+/* Opens the element file for a value which is written to disk while it is
+ * being received.
+ */
+static FILE *open_streamed_value(GHashTable *problem_info, const char *key)
+{
+    if (!g_staging_dd)
+    {
+        exit_if_low_free_space();
+
+        g_autofree char *path = g_strdup_printf("%s/abrt-server-%s-%u.new",
+                                                abrt_g_settings_dump_location,
+                                                libreport_iso_date_string(NULL),
+                                                (unsigned)getpid());
+        g_staging_dd = dd_create(path, /*fs owner*/0, DEFAULT_DUMP_DIR_MODE);
+        if (!g_staging_dd)
+            error_msg_and_die("Error creating problem directory '%s'", path);
+    }
+
+    /* The last value of the key wins */
+    g_hash_table_remove(problem_info, key);
+    dd_delete_item(g_staging_dd, key);
+
+    FILE *value_file = dd_open_item_file(g_staging_dd, key, O_RDWR);
+    if (!value_file)
+        error_msg_and_die("Can't save '%s'", key);
+
+    return value_file;
+}
+
+/* Dies if any part of the value could not be written, the problem directory
+ * must not be processed with a truncated element.
+ */
+static void close_streamed_value(FILE *value_file, const char *key)
+{
+    if (fflush(value_file) != 0 || ferror(value_file))
+        perror_msg_and_die("Can't save '%s'", key);
+    if (fclose(value_file) != 0)
+        perror_msg_and_die("Can't save '%s'", key);
+}
+
+/* Parses KEY=value\0 records of a creation request as they arrive. */
+struct request_body
+{
+    GHashTable *problem_info;
+    /* The beginning of the record which has not been processed yet */
+    GString *record;
+    /* The element file the rest of the current value goes to */
+    FILE *value_file;
+    char *value_key;
+    /* The rest of the current record is invalid */
+    bool skip;
+};
+
+static void request_body_stream_value(struct request_body *body)
+{
+    char *value = strchr(body->record->str, '=');
+    if (!value)
+    {
+        error_msg("Invalid message format: '%.64s...'", body->record->str);
+        body->skip = true;
+        return;
+    }
+
+    g_autofree gchar *key = g_ascii_strdown(body->record->str, value - body->record->str);
+    if (value_must_be_buffered(key))
+        return;
+
+    if (!key_ok(key))
+    {
+        error_msg("Invalid key or value format: %.64s...", body->record->str);
+        body->skip = true;
+        return;
+    }
+
+    body->value_file = open_streamed_value(body->problem_info, key);
+    log_debug("Writing the value of '%s' to the problem directory", key);
+    value++;
+    const size_t len = body->record->len - (value - body->record->str);
+    if (fwrite(value, 1, len, body->value_file) != len)
+        perror_msg_and_die("Can't save '%s'", key);
+    g_string_truncate(body->record, 0);
+    body->value_key = g_steal_pointer(&key);
+}
+
+static void request_body_finish_value(struct request_body *body)
+{
+    close_streamed_value(body->value_file, body->value_key);
+    body->value_file = NULL;
+    g_free(body->value_key);
+    body->value_key = NULL;
+}
+
+static void request_body_feed(struct request_body *body, const char *data, size_t len)
+{
+    const char *const end = data + len;
+    while (data < end)
+    {
+        const char *nul = memchr(data, '\0', end - data);
+        const char *const record_end = nul ? nul : end;
+
+        if (body->value_file)
+        {
+            if (fwrite(data, 1, record_end - data, body->value_file) != (size_t)(record_end - data))
+                perror_msg_and_die("Can't save '%s'", body->value_key);
+            if (nul)
+                request_body_finish_value(body);
+        }
+        else if (!body->skip)
+        {
+            g_string_append_len(body->record, data, record_end - data);
+            if (nul)
+                process_message(body->problem_info, body->record->str);
+            else if (body->record->len > MAX_BUFFERED_VALUE_SIZE)
+                request_body_stream_value(body);
+        }
+
+        if (!nul)
+            break;
+
+        g_string_truncate(body->record, 0);
+        body->skip = false;
+        data = nul + 1;
+    }
+}
+
 static void die_if_data_is_missing(GHashTable *problem_info)
 {
     gboolean missing_data = FALSE;
@@ -870,17 +1036,310 @@ unsigned convert_pid(GHashTable *problem_info)
     return (unsigned) ret;
 }
 
+/* Saves the problem once the whole request has been received */
+static int save_problem(GHashTable *problem_info, struct response *rsp)
+{
+    int ret = 0;
+
+    die_if_data_is_missing(problem_info);
+
+    /* Save problem dir */
+    char *executable = g_hash_table_lookup(problem_info, FILENAME_EXECUTABLE);
+    if (executable)
+    {
+        g_autofree char *last_file = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", "last-via-server", NULL);
+        int repeating_crash = check_recent_crash_file(last_file, executable);
+        if (repeating_crash) /* Only pretend that we saved it */
+        {
+            error_msg("Not saving repeating crash in '%s'", executable);
+            return ret; /* ret is 0: "success" */
+        }
+    }
+
+    unsigned pid = convert_pid(problem_info);
+    struct ns_ids client_ids;
+    if (libreport_get_ns_ids(client_pid, &client_ids) < 0)
+        error_msg_and_die("Cannot get peer's Namespaces from /proc/%d/ns", client_pid);
+
+    if (client_ids.nsi_ids[PROC_NS_ID_PID] != g_ns_ids.nsi_ids[PROC_NS_ID_PID])
+    {
+        log_notice("Client is running in own PID Namespace, using PID %d instead of %d", client_pid, pid);
+        pid = client_pid;
+    }
+
+    create_problem_dir(problem_info, pid);
+    /* create_problem_dir() replied to the client before post-create */
+    rsp->sent = true;
+
+    return ret; /* Used as HTTP response code */
+}
+
+/* Monotonic time in microseconds by which the whole version 2 request must
+ * be received, a client sending a byte now and then can't hold the server */
+static gint64 g_v2_deadline;
+
+/* Receives exactly len bytes of a version 2 request. A file descriptor
+ * passed with the data is stored to *fd if fd is not NULL.
+ */
+static void v2_recv(void *buf, size_t len, int *fd)
+{
+    char *p = buf;
+    while (len != 0)
+    {
+        /* abrt_recv_fds() restarts interrupted calls, the alarm would not
+         * stop it, so it is called only when there are data */
+        const gint64 remaining_ms = (g_v2_deadline - g_get_monotonic_time()) / 1000;
+        struct pollfd pollfd = { .fd = STDIN_FILENO, .events = POLLIN };
+        const int ready = remaining_ms > 0 ? poll(&pollfd, 1, remaining_ms) : 0;
+        if (ready == 0)
+            error_msg_and_die("Timed out");
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror_msg_and_die("poll");
+        }
+
+        int passed_fd = -1;
+        unsigned fds_count = (fd != NULL && *fd < 0);
+        const ssize_t r = abrt_recv_fds(STDIN_FILENO, p, len, &passed_fd, &fds_count);
+        if (r < 0)
+        {
+            errno = -r;
+            perror_msg_and_die("recvmsg");
+        }
+        if (r == 0)
+            error_msg_and_die("Premature EOF detected, exiting");
+
+        if (fds_count != 0)
+            *fd = passed_fd;
+
+        p += r;
+        len -= r;
+    }
+}
+
+static void v2_receive_data(GHashTable *problem_info, const char *key, uint64_t size)
+{
+    char buf[INPUT_BUFFER_SIZE];
+
+    if (!key_ok(key))
+    {
+        error_msg("Invalid key format: %s", key);
+        for (; size != 0; size -= MIN(size, sizeof(buf)))
+            v2_recv(buf, MIN(size, sizeof(buf)), NULL);
+        return;
+    }
+
+    if (value_must_be_buffered(key))
+    {
+        if (size > MAX_BUFFERED_VALUE_SIZE)
+            error_msg_and_die("Value of '%s' is too long, aborting", key);
+
+        char *value = g_malloc(size + 1);
+        v2_recv(value, size, NULL);
+        value[size] = '\0';
+
+        if (strcmp(key, FILENAME_UID) == 0)
+        {
+            error_msg("Ignoring value of %s, will be determined later", FILENAME_UID);
+            free(value);
+        }
+        else if (strlen(value) != size || !key_value_ok((gchar *)key, value))
+        {
+            error_msg("Invalid key or value format: %s", key);
+            free(value);
+        }
+        else
+            g_hash_table_insert(problem_info, g_strdup(key), value);
+
+        return;
+    }
+
+    FILE *value_file = open_streamed_value(problem_info, key);
+    while (size != 0)
+    {
+        const size_t len = MIN(size, sizeof(buf));
+        v2_recv(buf, len, NULL);
+        if (fwrite(buf, 1, len, value_file) != len)
+            perror_msg_and_die("Can't save '%s'", key);
+        size -= len;
+    }
+
+    close_streamed_value(value_file, key);
+}
+
+/* Copies the passed file from its beginning without moving the file offset
+ * the client shares with us.
+ */
+static int copy_passed_file(int src_fd, int dst_fd, off_t size)
+{
+    char buf[INPUT_BUFFER_SIZE];
+    bool in_kernel = true;
+    off_t offset = 0;
+    while (offset < size)
+    {
+        ssize_t r;
+        if (in_kernel)
+        {
+            r = copy_file_range(src_fd, &offset, dst_fd, NULL, size - offset, 0);
+            if (r < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP))
+            {
+                /* Not possible between these files, copy them ourselves */
+                in_kernel = false;
+                continue;
+            }
+        }
+        else
+        {
+            r = pread(src_fd, buf, MIN(size - offset, (off_t)sizeof(buf)), offset);
+            if (r > 0)
+            {
+                if (libreport_full_write(dst_fd, buf, r) != r)
+                    return -1;
+                offset += r;
+            }
+        }
+
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        /* The client truncated the file */
+        if (r == 0)
+            break;
+    }
+
+    return 0;
+}
+
+static void v2_receive_fd(GHashTable *problem_info, const char *key, int data_fd)
+{
+    if (data_fd < 0)
+        error_msg_and_die("Element '%s' came without a file descriptor, aborting", key);
+
+    struct stat st;
+    if (!key_ok(key) || value_must_be_buffered(key))
+        error_msg("Element '%s' can't be passed as a file", key);
+    else if (fstat(data_fd, &st) != 0 || !S_ISREG(st.st_mode))
+        error_msg("Element '%s' is not passed as a regular file", key);
+    else if (abrt_g_settings_nMaxCrashReportsSize > 0
+          && st.st_size / (1024 * 1024) >= abrt_g_settings_nMaxCrashReportsSize)
+        error_msg("Element '%s' is bigger than MaxCrashReportsSize", key);
+    else
+    {
+        FILE *value_file = open_streamed_value(problem_info, key);
+        if (copy_passed_file(data_fd, fileno(value_file), st.st_size) != 0)
+            perror_msg_and_die("Can't save '%s'", key);
+        close_streamed_value(value_file, key);
+    }
+
+    close(data_fd);
+}
+
+/* Handles a creation request in the protocol version 2 */
+static int perform_v2_xact(struct response *rsp)
+{
+    /* The deadline replaces the alarm which has been running since the
+     * client connected */
+    const unsigned remaining = alarm(0);
+    g_v2_deadline = g_get_monotonic_time() + (gint64)(remaining ? remaining : 1) * G_USEC_PER_SEC;
+
+    char magic[ABRT_SOCKET_V2_MAGIC_LEN];
+    v2_recv(magic, sizeof(magic), NULL);
+    if (memcmp(magic, ABRT_SOCKET_V2_MAGIC, sizeof(magic)) != 0)
+        return 400; /* Bad Request */
+
+    /* use free instead of g_free so that we can use xstr* functions from
+     * libreport/lib/xfuncs.c
+     */
+    g_autoptr(GHashTable) problem_info = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                     free, free);
+    uint64_t total_bytes_read = 0;
+    while (1)
+    {
+        struct abrt_socket_v2_element element;
+        int data_fd = -1;
+        v2_recv(&element, sizeof(element), &data_fd);
+
+        if (element.type == ABRT_SOCKET_V2_END)
+        {
+            if (data_fd >= 0)
+                close(data_fd);
+            break;
+        }
+
+        if (element.name_len == 0 || element.name_len > ABRT_SOCKET_V2_NAME_MAX)
+            error_msg_and_die("Invalid element name length %u, aborting", element.name_len);
+
+        char name[ABRT_SOCKET_V2_NAME_MAX + 1];
+        v2_recv(name, element.name_len, NULL);
+        name[element.name_len] = '\0';
+        g_autofree gchar *key = g_ascii_strdown(name, -1);
+        if (strlen(key) != element.name_len)
+            error_msg_and_die("Invalid element name, aborting");
+
+        switch (element.type)
+        {
+            case ABRT_SOCKET_V2_DATA:
+                total_bytes_read += element.size;
+                if (total_bytes_read > MAX_MESSAGE_SIZE)
+                    error_msg_and_die("Message is too long, aborting");
+                log_debug("Receiving %llu bytes of '%s'", (unsigned long long)element.size, key);
+                v2_receive_data(problem_info, key, element.size);
+                break;
+            case ABRT_SOCKET_V2_FD:
+            {
+                /* The copy is not free either, passed files are counted
+                 * like inline data */
+                struct stat st;
+                if (data_fd >= 0 && fstat(data_fd, &st) == 0 && st.st_size > 0)
+                {
+                    total_bytes_read += st.st_size;
+                    if (total_bytes_read > MAX_MESSAGE_SIZE)
+                        error_msg_and_die("Message is too long, aborting");
+                }
+                log_debug("Receiving '%s' as a file", key);
+                v2_receive_fd(problem_info, key, data_fd);
+                data_fd = -1;
+                break;
+            }
+            default:
+                error_msg_and_die("Unknown element type %u, aborting", element.type);
+        }
+
+        if (data_fd >= 0)
+        {
+            log_warning("Closing unexpected file descriptor passed with '%s'", key);
+            close(data_fd);
+        }
+    }
+
+    return save_problem(problem_info, rsp);
+}
+
 static int perform_http_xact(struct response *rsp)
 {
     /* use free instead of g_free so that we can use xstr* functions from
      * libreport/lib/xfuncs.c
      */
+    /* A version 2 request starts with a NUL byte, a text one can't */
+    char first_byte;
+    const ssize_t peeked = recv(STDIN_FILENO, &first_byte, 1, MSG_PEEK);
+    if (peeked < 0 && errno == EINTR)
+        error_msg_and_die("Timed out");
+    if (peeked == 1 && first_byte == ABRT_SOCKET_V2_MAGIC[0])
+        return perform_v2_xact(rsp);
+
     g_autoptr(GHashTable) problem_info = g_hash_table_new_full(g_str_hash, g_str_equal,
                                      free, free);
     /* Read header */
     char *body_start = NULL;
-    char *messagebuf_data = NULL;
+    g_autofree char *messagebuf_data = NULL;
     unsigned messagebuf_len = 0;
+    unsigned total_bytes_read = 0;
     /* Loop until EOF/error/timeout/end_of_header */
     while (1)
     {
@@ -938,14 +1397,14 @@ static int perform_http_xact(struct response *rsp)
      */
     if (g_str_has_prefix(messagebuf_data, "DELETE "))
     {
-        messagebuf_data += strlen("DELETE ");
-        char *space = strchr(messagebuf_data, ' ');
+        char *dump_dir_name = messagebuf_data + strlen("DELETE ");
+        char *space = strchr(dump_dir_name, ' ');
         if (!space || !g_str_has_prefix(space+1, "HTTP/"))
             return 400; /* Bad Request */
         *space = '\0';
-        //decode_url(messagebuf_data); %20 => ' '
+        //decode_url(dump_dir_name); %20 => ' '
         alarm(0);
-        return delete_path(messagebuf_data);
+        return delete_path(dump_dir_name);
     }
 
     /* We erroneously used "PUT /" to create new problems.
@@ -980,28 +1439,28 @@ static int perform_http_xact(struct response *rsp)
     }
 
     messagebuf_len -= (body_start - messagebuf_data);
-    memmove(messagebuf_data, body_start, messagebuf_len);
-    log_debug("Body so far: %u bytes, '%s'", messagebuf_len, messagebuf_data);
+    log_debug("Body so far: %u bytes", messagebuf_len);
+
+    /* The notification body is a short path, a creation request is parsed
+     * while it is being received and long values do not stay in memory */
+    g_autoptr(GString) notification = g_string_new(NULL);
+    struct request_body body = {
+        .problem_info = problem_info,
+        .record = g_string_new(NULL),
+    };
 
     /* Loop until EOF/error/timeout */
+    char *data = body_start;
     while (1)
     {
         if (url_type == CREATION_REQUEST)
-        {
-            while (1)
-            {
-                unsigned len = strnlen(messagebuf_data, messagebuf_len);
-                if (len >= messagebuf_len)
-                    break;
-                /* messagebuf has at least one NUL - process the line */
-                process_message(problem_info, messagebuf_data);
-                messagebuf_len -= (len + 1);
-                memmove(messagebuf_data, messagebuf_data + len + 1, messagebuf_len);
-            }
-        }
+            request_body_feed(&body, data, messagebuf_len);
+        else
+            g_string_append_len(notification, data, messagebuf_len);
 
-        messagebuf_data = g_realloc(messagebuf_data, messagebuf_len + INPUT_BUFFER_SIZE + 1);
-        int rd = read(STDIN_FILENO, messagebuf_data + messagebuf_len, INPUT_BUFFER_SIZE);
+        /* The header buffer is not needed any more, reuse it */
+        data = messagebuf_data;
+        int rd = read(STDIN_FILENO, data, INPUT_BUFFER_SIZE);
         if (rd < 0)
         {
             if (errno == EINTR) /* SIGALRM? */
@@ -1012,7 +1471,7 @@ static int perform_http_xact(struct response *rsp)
             break;
 
         log_debug("Received %u bytes of data", rd);
-        messagebuf_len += rd;
+        messagebuf_len = rd;
         total_bytes_read += rd;
         if (total_bytes_read > MAX_MESSAGE_SIZE)
             error_msg_and_die("Message is too long, aborting");
@@ -1021,6 +1480,15 @@ static int perform_http_xact(struct response *rsp)
     /* Body received, EOF was seen. Don't let alarm to interrupt after this. */
     alarm(0);
 
+    /* A record without the terminating NUL is incomplete, drop it */
+    if (body.value_file)
+    {
+        g_autofree char *key = g_strdup(body.value_key);
+        request_body_finish_value(&body);
+        dd_delete_item(g_staging_dd, key);
+    }
+    g_string_free(body.record, TRUE);
+
     int ret = 0;
     if (url_type == CREATION_NOTIFICATION)
     {
@@ -1031,43 +1499,115 @@ static int perform_http_xact(struct response *rsp)
             return ret;
         }
 
-        messagebuf_data[messagebuf_len] = '\0';
-        return run_post_create(messagebuf_data, rsp);
+        return run_post_create(notification->str, rsp);
     }
 
-    die_if_data_is_missing(problem_info);
+    return save_problem(problem_info, rsp);
+}
 
-    /* Save problem dir */
-    char *executable = g_hash_table_lookup(problem_info, FILENAME_EXECUTABLE);
-    if (executable)
+static void dummy_handler(int sig_unused) {}
+
+/* Handles the client connected on STDIN_FILENO and STDOUT_FILENO.
+ * Returns the HTTP response code.
+ */
+static int serve_client(void)
+{
+    /* Set the timeout per se */
+    alarm(TIMEOUT);
+
+    /* Get uid of the connected client */
+    struct ucred cr;
+    socklen_t crlen = sizeof(cr);
+    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
+        perror_msg_and_die("getsockopt(SO_PEERCRED)");
+    if (crlen != sizeof(cr))
+        error_msg_and_die("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
+
+    if (client_uid == (uid_t)-1L)
+        client_uid = cr.uid;
+
+    client_pid = cr.pid;
+
+    struct response rsp = { 0 };
+    int r = perform_http_xact(&rsp);
+    alarm(0);
+
+    /* The request was rejected after its long values had been saved */
+    delete_staging_dir();
+
+    if (r == 0)
+        r = 200;
+
+    if (rsp.code == 0)
+        rsp.code = r;
+
+    if (!rsp.sent)
     {
-        g_autofree char *last_file = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", "last-via-server", NULL);
-        int repeating_crash = check_recent_crash_file(last_file, executable);
-        if (repeating_crash) /* Only pretend that we saved it */
-        {
-            error_msg("Not saving repeating crash in '%s'", executable);
-            return ret; /* ret is 0: "success" */
-        }
+        printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
+        if (rsp.message != NULL)
+            printf("%s", rsp.message);
+        fflush(stdout);
     }
+    free(rsp.message);
 
-    unsigned pid = convert_pid(problem_info);
-    struct ns_ids client_ids;
-    if (libreport_get_ns_ids(client_pid, &client_ids) < 0)
-        error_msg_and_die("Cannot get peer's Namespaces from /proc/%d/ns", client_pid);
+    return r;
+}
 
-    if (client_ids.nsi_ids[PROC_NS_ID_PID] != g_ns_ids.nsi_ids[PROC_NS_ID_PID])
+/* Serves clients passed by abrtd over the control socket on STDIN_FILENO
+ * until abrtd closes it.
+ */
+static void run_worker(void)
+{
+    const int control_fd = dup(STDIN_FILENO);
+    if (control_fd < 0)
+        perror_msg_and_die("dup");
+    libreport_close_on_exec_on(control_fd);
+
+    /* Do not leave stdin and stdout pointing to the control socket */
+    libreport_xmove_fd(g_open("/dev/null", O_RDWR), STDIN_FILENO);
+    libreport_xdup2(STDERR_FILENO, STDOUT_FILENO);
+
+    const uid_t opt_client_uid = client_uid;
+    for (;;)
     {
-        log_notice("Client is running in own PID Namespace, using PID %d instead of %d", client_pid, pid);
-        pid = client_pid;
-    }
+        char command;
+        int client_fd = -1;
+        unsigned fds_count = 1;
+        const ssize_t r = abrt_recv_fds(control_fd, &command, sizeof(command), &client_fd, &fds_count);
+        if (r < 0)
+        {
+            errno = -r;
+            perror_msg_and_die("Can't receive a client socket from abrtd");
+        }
+        if (r == 0)
+        {
+            log_debug("abrtd closed the control socket, exiting");
+            break;
+        }
+        if (fds_count == 0)
+            error_msg_and_die("abrtd sent a message without a client socket");
 
-    create_problem_dir(problem_info, pid);
-    /* does not return */
+        log_debug("Handling a new client");
 
-    return ret; /* Used as HTTP response code */
-}
+        libreport_xdup2(client_fd, STDIN_FILENO);
+        libreport_xdup2(client_fd, STDOUT_FILENO);
+        close(client_fd);
 
-static void dummy_handler(int sig_unused) {}
+        client_uid = opt_client_uid;
+        client_pid = (pid_t)-1L;
+
+        serve_client();
+
+        /* Disconnect the client, create_problem_dir() might have done it already */
+        libreport_xmove_fd(g_open("/dev/null", O_RDWR), STDIN_FILENO);
+        libreport_xdup2(STDERR_FILENO, STDOUT_FILENO);
+
+        fprintf(stderr, "REQUEST_DONE\n");
+        fflush(stderr);
+    }
+
+    close(control_fd);
+}
 
 int main(int argc, char **argv)
 {
@@ -1089,6 +1629,7 @@ int main(int argc, char **argv)
         OPT_u = 1 << 1,
         OPT_s = 1 << 2,
         OPT_p = 1 << 3,
+        OPT_w = 1 << 4,
     };
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
@@ -1096,6 +1637,7 @@ int main(int argc, char **argv)
         OPT_INTEGER('u', NULL, &client_uid, _("Use NUM as client uid")),
         OPT_BOOL(   's', NULL, NULL       , _("Log to syslog")),
         OPT_BOOL(   'p', NULL, NULL       , _("Add program names to log")),
+        OPT_BOOL(   'w', NULL, NULL       , _("Serve client sockets passed by abrtd over stdin")),
         OPT_END()
     };
     unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
@@ -1117,45 +1659,27 @@ int main(int argc, char **argv)
     memset(&sa, 0, sizeof(sa));
     sa.sa_handler = dummy_handler; /* pity, SIG_DFL won't do */
     sigaction(SIGALRM, &sa, NULL);
-    /* Part 2 - set the timeout per se */
-    alarm(TIMEOUT);
-
-    /* Get uid of the connected client */
-    struct ucred cr;
-    socklen_t crlen = sizeof(cr);
-    if (0 != getsockopt(STDIN_FILENO, SOL_SOCKET, SO_PEERCRED, &cr, &crlen))
-        perror_msg_and_die("getsockopt(SO_PEERCRED)");
-    if (crlen != sizeof(cr))
-        error_msg_and_die("%s: bad crlen %d", "getsockopt(SO_PEERCRED)", (int)crlen);
-
-    if (client_uid == (uid_t)-1L)
-        client_uid = cr.uid;
-
-    client_pid = cr.pid;
+    /* Part 2 - the timeout is set per client in serve_client() */
 
     pid_t pid = getpid();
     if (libreport_get_ns_ids(getpid(), &g_ns_ids) < 0)
         error_msg_and_die("Cannot get own Namespaces from /proc/%d/ns", pid);
 
+    /* Workers load the configuration only once, abrtd recycles them after
+     * ServerWorkerMaxRequests clients.
+     */
     abrt_load_abrt_conf();
 
-    struct response rsp = { 0 };
-    int r = perform_http_xact(&rsp);
-    if (r == 0)
-        r = 200;
+    /* Do not leave a half-received problem behind if we die */
+    atexit(delete_staging_dir);
 
-    if (rsp.code == 0)
-        rsp.code = r;
+    int r = 0;
+    if (opts & OPT_w)
+        run_worker();
+    else
+        r = serve_client();
 
     abrt_free_abrt_conf_data();
 
-    printf("HTTP/1.1 %u \r\n\r\n", rsp.code);
-    if (rsp.message != NULL)
-    {
-        printf("%s", rsp.message);
-        fflush(stdout);
-        free(rsp.message);
-    }
-
     return (r >= 400); /* Error if 400+ */
 }
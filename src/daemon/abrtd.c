@@ -43,7 +43,11 @@
 /* Maximum number of simultaneously opened client connections. */
 #define MAX_CLIENT_COUNT  10
 
-#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF)
+/* A worker which exits before its first client is replaced after this delay */
+#define WORKER_RESPAWN_DELAY_SEC 5
+
+#define IN_DUMP_LOCATION_FLAGS (IN_DELETE_SELF | IN_MOVE_SELF \
+        | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO)
 
 #define ABRTD_DBUS_NAME ABRT_DBUS_NAME".daemon"
 
@@ -52,6 +56,10 @@
  * - inotify: something new appeared under /var/tmp/abrt or /var/spool/abrt-upload
  * - signal: we got SIGTERM, SIGINT, SIGALRM or SIGCHLD
  * - new socket connection
+ *
+ * New socket connections are handled by abrt-server. Either a long-lived
+ * worker (see ServerWorkers in abrt.conf) gets the accepted socket over its
+ * control socket, or a new abrt-server process is spawned for the connection.
  */
 static volatile sig_atomic_t s_sig_caught;
 static int s_signal_pipe[2];
@@ -59,10 +67,17 @@ static int s_signal_pipe_write = -1;
 static unsigned s_timeout;
 static int s_timeout_src;
 static GMainLoop *s_main_loop;
+/* Pending respawn of workers which exited prematurely */
+static guint s_worker_respawn_src;
 
 GList *s_processes;
 GList *s_dir_queue;
 
+/* Sizes of the problem directories in the dump location. Directories are
+ * measured when they appear and when their post-create processing is done.
+ */
+static struct abrt_size_ledger *s_dump_location_ledger;
+
 static GIOChannel *channel_socket = NULL;
 static guint channel_id_socket = 0;
 
@@ -71,12 +86,19 @@ struct abrt_server_proc
     pid_t pid;
     int fdout;
     char *dirname;
+    /* Dedup bucket of dirname, see abrt_dedup_bucket_name() */
+    char *bucket;
     GIOChannel *channel;
     guint watch_id;
     enum {
         AS_UKNOWN,
         AS_POST_CREATE,
     } type;
+    /* Long-lived workers get client sockets over control_fd */
+    bool worker;
+    bool busy;
+    int control_fd;
+    unsigned requests;
 };
 
 /* Returns 0 if proc's pid equals the the given pid */
@@ -112,9 +134,23 @@ static void stop_abrt_server(struct abrt_server_proc *proc)
     kill(proc->pid, SIGINT);
 }
 
+/* The worker exits once it handles the current client */
+static void retire_abrt_server_worker(struct abrt_server_proc *proc)
+{
+    if (proc->control_fd < 0)
+        return;
+
+    close(proc->control_fd);
+    proc->control_fd = -1;
+}
+
 static void dispose_abrt_server(struct abrt_server_proc *proc)
 {
     free(proc->dirname);
+    free(proc->bucket);
+
+    if (proc->worker)
+        retire_abrt_server_worker(proc);
 
     if (proc->watch_id > 0)
         g_source_remove(proc->watch_id);
@@ -123,21 +159,93 @@ static void dispose_abrt_server(struct abrt_server_proc *proc)
         g_io_channel_unref(proc->channel);
 }
 
+/* Problems in the same dedup bucket can be duplicates of each other, hence
+ * they must not be processed by post-create at the same time. Otherwise, they
+ * could mark each other as duplicates. If the bucket is not known, the problem
+ * is considered to be in conflict with all others.
+ */
+static char *load_dedup_bucket(const char *dirname)
+{
+    struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT);
+    if (dd == NULL)
+        return NULL;
+
+    const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+    g_autofree char *uid = dd_load_text_ext(dd, FILENAME_UID, flags);
+    g_autofree char *type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+    g_autofree char *executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, flags);
+    dd_close(dd);
+
+    if (type == NULL)
+        return NULL;
+
+    return abrt_dedup_bucket_name(uid, type, executable);
+}
+
+static bool dedup_buckets_conflict(const char *bucket1, const char *bucket2)
+{
+    return bucket1 == NULL || bucket2 == NULL || strcmp(bucket1, bucket2) == 0;
+}
+
+/* Returns true if a process queued before the given one handles a problem
+ * which can be a duplicate of the given one's problem.
+ */
+static bool post_create_process_is_blocked(GList *item)
+{
+    const struct abrt_server_proc *proc = (struct abrt_server_proc *)item->data;
+    for (GList *iter = s_dir_queue; iter != item; iter = g_list_next(iter))
+    {
+        const struct abrt_server_proc *prev = (struct abrt_server_proc *)iter->data;
+        if (dedup_buckets_conflict(prev->bucket, proc->bucket))
+            return true;
+    }
+
+    return false;
+}
+
+static unsigned max_parallel_post_create_processes(void)
+{
+    if (abrt_g_settings_max_parallel_post_create != 0)
+        return abrt_g_settings_max_parallel_post_create;
+
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (unsigned)cpus : 1;
+}
+
+/* Starts post-create processing of the queued problems which are not blocked
+ * by a problem from the same dedup bucket queued earlier, up to
+ * MaxParallelPostCreate processes.
+ */
 static void notify_next_post_create_process(struct abrt_server_proc *finished)
 {
     if (finished != NULL)
         s_dir_queue = g_list_remove(s_dir_queue, finished);
 
-    while (s_dir_queue != NULL)
+    const unsigned max_running = max_parallel_post_create_processes();
+    unsigned running = 0;
+    for (GList *iter = s_dir_queue; iter != NULL; iter = g_list_next(iter))
     {
-        struct abrt_server_proc *n = (struct abrt_server_proc *)s_dir_queue->data;
-        if (n->type == AS_POST_CREATE)
-            break;
+        if (((struct abrt_server_proc *)iter->data)->type == AS_POST_CREATE)
+            ++running;
+    }
+
+    GList *iter = s_dir_queue;
+    while (iter != NULL && running < max_running)
+    {
+        GList *next = g_list_next(iter);
+        struct abrt_server_proc *n = (struct abrt_server_proc *)iter->data;
+        if (n->type == AS_POST_CREATE || post_create_process_is_blocked(iter))
+        {
+            iter = next;
+            continue;
+        }
 
         if (kill(n->pid, SIGUSR1) >= 0)
         {
             n->type = AS_POST_CREATE;
-            break;
+            ++running;
+            iter = next;
+            continue;
         }
 
         /* This could happen only if the notified process disappeared - crashed?
@@ -148,34 +256,73 @@ static void notify_next_post_create_process(struct abrt_server_proc *finished)
         /* Remove the problematic process from the post-crate directory queue
          * and go to try to notify another process.
          */
-        s_dir_queue = g_list_delete_link(s_dir_queue, s_dir_queue);
+        s_dir_queue = g_list_delete_link(s_dir_queue, iter);
+        iter = next;
     }
 }
 
+static const char *dump_dir_basename(const char *dirname)
+{
+    const char *base = strrchr(dirname, '/');
+    return base != NULL ? base + 1 : dirname;
+}
+
+/* Measures the problem directory again, or forgets it if it is gone */
+static void update_dump_location_ledger(const char *dirname)
+{
+    if (s_dump_location_ledger != NULL && dirname != NULL)
+        abrt_size_ledger_update(s_dump_location_ledger, dump_dir_basename(dirname));
+}
+
+/* Post-create has finished: the directory was deleted as a duplicate or its
+ * analyzers have (re)written UUID and DUPHASH. Must be called before the next
+ * problem of the same bucket is processed.
+ */
+static void refresh_dedup_index(const char *dirname)
+{
+    if (dirname == NULL)
+        return;
+
+    struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT);
+    if (dd == NULL)
+    {
+        abrt_dedup_index_remove(dirname);
+        return;
+    }
+
+    abrt_dedup_index_add(dd);
+    dd_close(dd);
+}
+
 /* Queueing the process will also lead to cleaning up the dump location.
  */
 static void queue_post_create_process(struct abrt_server_proc *proc)
 {
     abrt_load_abrt_conf();
-    struct abrt_server_proc *running = s_dir_queue == NULL ? NULL
-                                                           : (struct abrt_server_proc *)s_dir_queue->data;
+    update_dump_location_ledger(proc->dirname);
+
     if (abrt_g_settings_nMaxCrashReportsSize == 0)
         goto consider_processing;
 
-    const char *full_path_ignored = running != NULL ? running->dirname
-                                                    : proc->dirname;
-    const char *ignored = strrchr(full_path_ignored, '/');
-    if (NULL == ignored)
-        /* Paranoia, this should not happen. */
-        ignored = full_path_ignored;
-    else
-        /* Move behind '/' */
-        ++ignored;
+    /* Reporting events might have enlarged the problem directories */
+    abrt_size_ledger_refresh(s_dump_location_ledger);
+
+    /* Neither the problems being processed nor the new one are deleted */
+    GPtrArray *ignored = g_ptr_array_new();
+    for (GList *iter = s_dir_queue; iter != NULL; iter = g_list_next(iter))
+    {
+        struct abrt_server_proc *running = (struct abrt_server_proc *)iter->data;
+        if (running->type == AS_POST_CREATE)
+            g_ptr_array_add(ignored, (gpointer)dump_dir_basename(running->dirname));
+    }
+    g_ptr_array_add(ignored, (gpointer)dump_dir_basename(proc->dirname));
+    g_ptr_array_add(ignored, NULL);
 
     char *worst_dir = NULL;
     const double max_size = 1024 * 1024 * abrt_g_settings_nMaxCrashReportsSize;
-    while (libreport_get_dirsize_find_largest_dir(abrt_g_settings_dump_location, &worst_dir, ignored, proc->dirname) >= max_size
-           && worst_dir)
+    while (abrt_size_ledger_get_total(s_dump_location_ledger) >= max_size
+           && (worst_dir = abrt_size_ledger_find_worst_dir(s_dump_location_ledger,
+                                                          (const char *const *)ignored->pdata)) != NULL)
     {
         const char *kind = "old";
 
@@ -192,13 +339,23 @@ static void queue_post_create_process(struct abrt_server_proc *proc)
                 abrt_g_settings_dump_location, abrt_g_settings_nMaxCrashReportsSize,
                 kind, worst_dir);
 
-        g_autofree char *deleted = g_build_filename(abrt_g_settings_dump_location ? abrt_g_settings_dump_location : "", worst_dir, NULL);
+        g_autofree char *deleted = g_build_filename(abrt_size_ledger_get_path(s_dump_location_ledger), worst_dir, NULL);
         g_clear_pointer(&worst_dir, free);
 
         struct dump_dir *dd = dd_opendir(deleted, DD_FAIL_QUIETLY_ENOENT);
         if (dd != NULL)
             dd_delete(dd);
+        abrt_dedup_index_remove(deleted);
+        /* Don't wait for inotify, the directory could be picked again */
+        update_dump_location_ledger(deleted);
+        if (access(deleted, F_OK) == 0)
+        {
+            error_msg("Failed to delete '%s', not trimming '%s' anymore",
+                    deleted, abrt_g_settings_dump_location);
+            break;
+        }
     }
+    g_ptr_array_free(ignored, TRUE);
 
 consider_processing:
     /* If the process survived cleaning up the dump location, append it to the
@@ -207,12 +364,103 @@ consider_processing:
     if (proc != NULL)
         s_dir_queue = g_list_append(s_dir_queue, proc);
 
-    /* If there were no running post-crate process before we added the
-     * currently handled process to the post-create queue, start processing of
-     * the currently handled process.
+    /* Start processing of the currently handled process unless there is
+     * a possible duplicate queued before it or too many post-create processes
+     * are running.
      */
-    if (running == NULL)
-        notify_next_post_create_process(NULL/*finished*/);
+    notify_next_post_create_process(NULL/*finished*/);
+}
+
+static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused);
+
+/* Returns the number of abrt-server processes handling a client */
+static unsigned count_busy_abrt_servers(void)
+{
+    unsigned count = 0;
+    for (GList *iter = s_processes; iter != NULL; iter = g_list_next(iter))
+    {
+        struct abrt_server_proc *proc = (struct abrt_server_proc *)iter->data;
+        if (!proc->worker || proc->busy)
+            ++count;
+    }
+
+    return count;
+}
+
+static unsigned count_abrt_server_workers(void)
+{
+    unsigned count = 0;
+    for (GList *iter = s_processes; iter != NULL; iter = g_list_next(iter))
+    {
+        struct abrt_server_proc *proc = (struct abrt_server_proc *)iter->data;
+        if (proc->worker && proc->control_fd >= 0)
+            ++count;
+    }
+
+    return count;
+}
+
+/* Stops accepting connections if there are too many clients being handled
+ * and starts accepting them again once some of the clients are done.
+ */
+static void update_socket_watch(void)
+{
+    if (channel_socket == NULL)
+        return;
+
+    const unsigned busy = count_busy_abrt_servers();
+    if (busy >= MAX_CLIENT_COUNT && channel_id_socket)
+    {
+        error_msg("Too many clients, refusing connections to '%s'", SOCKET_FILE);
+        /* To avoid infinite loop caused by the descriptor in "ready" state,
+         * the callback must be disabled.
+         */
+        g_source_remove(channel_id_socket);
+        channel_id_socket = 0;
+    }
+    else if (busy < MAX_CLIENT_COUNT && !channel_id_socket)
+    {
+        log_info("Accepting connections on '%s'", SOCKET_FILE);
+        channel_id_socket = add_watch_or_die(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, server_socket_cb);
+    }
+}
+
+/* The worker has finished handling of its client, including the post-create
+ * processing, and is ready to get another one.
+ */
+static void abrt_server_worker_done(struct abrt_server_proc *proc)
+{
+    if (!proc->worker || !proc->busy)
+    {
+        log_warning("abrt-server(%d) is not handling any client", proc->pid);
+        return;
+    }
+
+    if (proc->type == AS_POST_CREATE)
+    {
+        refresh_dedup_index(proc->dirname);
+        notify_next_post_create_process(proc);
+    }
+    else
+        s_dir_queue = g_list_remove(s_dir_queue, proc);
+
+    /* Post-create added files to the directory or deleted it as a dup */
+    update_dump_location_ledger(proc->dirname);
+
+    proc->type = AS_UKNOWN;
+    g_clear_pointer(&proc->dirname, free);
+    g_clear_pointer(&proc->bucket, free);
+    proc->busy = false;
+    ++proc->requests;
+
+    if (abrt_g_settings_server_worker_max_requests != 0
+        && proc->requests >= abrt_g_settings_server_worker_max_requests)
+    {
+        log_info("abrt-server(%d) handled %u clients, replacing it", proc->pid, proc->requests);
+        retire_abrt_server_worker(proc);
+    }
+
+    update_socket_watch();
 }
 
 static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition condition, gpointer user_data)
@@ -257,7 +505,9 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
 
         /* G_IO_STATUS_NORMAL) */
         line[pos] = '\0';
-        if (g_str_has_prefix(line, "NEW_PROBLEM_DETECTED: "))
+        if (strcmp(line, "REQUEST_DONE") == 0)
+            abrt_server_worker_done(proc);
+        else if (g_str_has_prefix(line, "NEW_PROBLEM_DETECTED: "))
         {
             if (proc->dirname != NULL)
             {
@@ -268,6 +518,8 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
             }
 
             proc->dirname = g_strdup(line + strlen("NEW_PROBLEM_DETECTED: "));
+            free(proc->bucket);
+            proc->bucket = load_dedup_bucket(proc->dirname);
             log_notice("abrt-server(%d): handling new problem: %s", proc->pid, proc->dirname);
             queue_post_create_process(proc);
         }
@@ -278,13 +530,18 @@ static gboolean abrt_server_output_cb(GIOChannel *channel, GIOCondition conditio
     return TRUE; /* Keep this event */
 }
 
-static void add_abrt_server_proc(const pid_t pid, int fdout)
+static struct abrt_server_proc *add_abrt_server_proc(const pid_t pid, int fdout)
 {
     struct abrt_server_proc *proc = g_new(struct abrt_server_proc, 1);
     proc->pid = pid;
     proc->fdout = fdout;
     proc->dirname = NULL;
+    proc->bucket = NULL;
     proc->type = AS_UKNOWN;
+    proc->worker = false;
+    proc->busy = false;
+    proc->control_fd = -1;
+    proc->requests = 0;
     proc->channel = abrt_gio_channel_unix_new(proc->fdout);
     proc->watch_id = g_io_add_watch(proc->channel,
                                     G_IO_IN | G_IO_HUP,
@@ -299,15 +556,122 @@ static void add_abrt_server_proc(const pid_t pid, int fdout)
     g_io_channel_set_buffered(proc->channel, TRUE);
 
     s_processes = g_list_append(s_processes, proc);
-    if (g_list_length(s_processes) >= MAX_CLIENT_COUNT)
+    update_socket_watch();
+
+    return proc;
+}
+
+static struct abrt_server_proc *spawn_abrt_server_worker(void)
+{
+    /* Both ends must be closed in the other abrt-server processes, otherwise
+     * the worker would not see EOF when abrtd closes its end.
+     */
+    int control[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, control) < 0)
     {
-        error_msg("Too many clients, refusing connections to '%s'", SOCKET_FILE);
-        /* To avoid infinite loop caused by the descriptor in "ready" state,
-         * the callback must be disabled.
-         */
-        g_source_remove(channel_id_socket);
-        channel_id_socket = 0;
+        perror_msg("socketpair");
+        return NULL;
+    }
+
+    int pipefd[2];
+    if (!g_unix_open_pipe(pipefd, FD_CLOEXEC, NULL))
+    {
+        perror_msg("pipe");
+        close(control[0]);
+        close(control[1]);
+        return NULL;
+    }
+
+    fflush(NULL); /* paranoia */
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        perror_msg("fork");
+        close(control[0]);
+        close(control[1]);
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return NULL;
     }
+    if (pid == 0) /* child */
+    {
+        libreport_xmove_fd(control[1], STDIN_FILENO);
+        libreport_xdup2(pipefd[1], STDOUT_FILENO);
+        libreport_xmove_fd(pipefd[1], STDERR_FILENO);
+
+        char *argv[4];  /* abrt-server -w [-s] NULL */
+        char **pp = argv;
+        *pp++ = (char*)"abrt-server";
+        *pp++ = (char*)"-w";
+        if (libreport_logmode & LOGMODE_JOURNAL)
+            *pp++ = (char*)"-s";
+        *pp = NULL;
+
+        execvp(argv[0], argv);
+        perror_msg_and_die("Can't execute '%s'", argv[0]);
+    }
+
+    /* parent */
+    close(control[1]);
+    close(pipefd[1]);
+
+    log_info("Started abrt-server worker (%d)", pid);
+    struct abrt_server_proc *proc = add_abrt_server_proc(pid, pipefd[0]);
+    proc->worker = true;
+    proc->control_fd = control[0];
+
+    return proc;
+}
+
+static void start_abrt_server_workers(void)
+{
+    while (count_abrt_server_workers() < abrt_g_settings_server_workers)
+    {
+        if (spawn_abrt_server_worker() == NULL)
+            break;
+    }
+}
+
+static gboolean respawn_abrt_server_workers_cb(gpointer unused)
+{
+    s_worker_respawn_src = 0;
+    start_abrt_server_workers();
+    return G_SOURCE_REMOVE;
+}
+
+static void schedule_abrt_server_workers_respawn(void)
+{
+    if (s_worker_respawn_src == 0)
+        s_worker_respawn_src = g_timeout_add_seconds(WORKER_RESPAWN_DELAY_SEC,
+                                                     respawn_abrt_server_workers_cb, NULL);
+}
+
+/* Returns true if an idle worker has taken over the client socket */
+static bool pass_client_to_worker(int socket)
+{
+    for (GList *iter = s_processes; iter != NULL; iter = g_list_next(iter))
+    {
+        struct abrt_server_proc *proc = (struct abrt_server_proc *)iter->data;
+        if (!proc->worker || proc->busy || proc->control_fd < 0)
+            continue;
+
+        const char command = 'C';
+        const int r = abrt_send_fds(proc->control_fd, &command, sizeof(command), &socket, 1);
+        if (r < 0)
+        {
+            errno = -r;
+            perror_msg("Can't pass the client socket to abrt-server(%d)", proc->pid);
+            retire_abrt_server_worker(proc);
+            continue;
+        }
+
+        log_debug("Client passed to abrt-server(%d)", proc->pid);
+        proc->busy = true;
+        update_socket_watch();
+        return true;
+    }
+
+    return false;
 }
 
 static void start_idle_timeout(void)
@@ -330,8 +694,6 @@ static void kill_idle_timeout(void)
 }
 
 
-static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpointer ptr_unused);
-
 static void remove_abrt_server_proc(pid_t pid, int status)
 {
     GList *item = g_list_find_custom(s_processes, &pid, (GCompareFunc)abrt_server_compare_pid);
@@ -343,7 +705,10 @@ static void remove_abrt_server_proc(pid_t pid, int status)
     s_processes = g_list_delete_link(s_processes, item);
 
     if (proc->type == AS_POST_CREATE)
+    {
+        refresh_dedup_index(proc->dirname);
         notify_next_post_create_process(proc);
+    }
     else
     {   /* Make sure out-of-order exited abrt-server post-create processes do
          * not stay in the post-create queue.
@@ -351,14 +716,35 @@ static void remove_abrt_server_proc(pid_t pid, int status)
         s_dir_queue = g_list_remove(s_dir_queue, proc);
     }
 
+    update_dump_location_ledger(proc->dirname);
+
+    /* Replace every worker which exited. Workers that died before they could
+     * handle anything are most likely broken, so they are replaced after
+     * a delay to not fork them in a loop; the fall-back path handles the
+     * connections meanwhile.
+     */
+    const bool worker = proc->worker;
+    const bool premature = worker && !proc->busy && proc->requests == 0;
+    if (premature)
+        log_warning("abrt-server worker (%d) exited prematurely", pid);
+    /* Typically invalid data from the client, which a worker treats in the
+     * same way as a process executed for the client: it dies */
+    else if (worker && proc->busy && WIFSIGNALED(status))
+        log_warning("abrt-server worker (%d) was killed by signal %d while handling a client",
+                    pid, WTERMSIG(status));
+    else if (worker && proc->busy && WEXITSTATUS(status) != 0)
+        log_warning("abrt-server worker (%d) exited with %d while handling a client",
+                    pid, WEXITSTATUS(status));
+
     dispose_abrt_server(proc);
     free(proc);
 
-    if (g_list_length(s_processes) < MAX_CLIENT_COUNT && !channel_id_socket)
-    {
-        log_info("Accepting connections on '%s'", SOCKET_FILE);
-        channel_id_socket = add_watch_or_die(channel_socket, G_IO_IN | G_IO_PRI | G_IO_HUP, server_socket_cb);
-    }
+    if (premature)
+        schedule_abrt_server_workers_respawn();
+    else if (worker && count_abrt_server_workers() < abrt_g_settings_server_workers)
+        spawn_abrt_server_worker();
+
+    update_socket_watch();
 }
 
 /* Callback called by glib main loop when a client connects to ABRT's socket. */
@@ -375,6 +761,19 @@ static gboolean server_socket_cb(GIOChannel *source, GIOCondition condition, gpo
     }
 
     log_notice("New client connected");
+
+    if (pass_client_to_worker(socket))
+    {
+        close(socket);
+        goto server_socket_finitio;
+    }
+
+    /* No idle worker, grow the pool for the next clients if it is not full
+     * and handle this one the old way.
+     */
+    if (count_abrt_server_workers() < abrt_g_settings_server_workers)
+        spawn_abrt_server_worker();
+
     fflush(NULL); /* paranoia */
 
     int pipefd[2];
@@ -497,7 +896,19 @@ static void handle_inotify_cb(struct abrt_inotify_watch *watch, struct inotify_e
 
         sanitize_dump_dir_rights();
         abrt_inotify_watch_reset(watch, abrt_g_settings_dump_location, IN_DUMP_LOCATION_FLAGS);
+
+        abrt_size_ledger_free(s_dump_location_ledger);
+        s_dump_location_ledger = abrt_size_ledger_new(abrt_g_settings_dump_location);
     }
+    else if (event->mask & IN_Q_OVERFLOW)
+    {
+        log_info("Too many inotify events, measuring '%s' again", abrt_g_settings_dump_location);
+        abrt_size_ledger_reset(s_dump_location_ledger);
+    }
+    else if (event->len > 0 && (event->mask & (IN_CREATE | IN_MOVED_TO)))
+        abrt_size_ledger_update(s_dump_location_ledger, event->name);
+    else if (event->len > 0 && (event->mask & (IN_DELETE | IN_MOVED_FROM)))
+        abrt_size_ledger_remove(s_dump_location_ledger, event->name);
 
     start_idle_timeout();
 }
@@ -642,6 +1053,13 @@ static void mark_unprocessed_dump_dirs_not_reportable(const char *path)
         return;
     }
 
+    /* The dump location is scanned anyway, so (re)build the index used by
+     * abrt-handle-event to find duplicates without opening every problem
+     * directory. If the index cannot be created, abrt-handle-event falls back
+     * to scanning the dump location.
+     */
+    const bool index_dirs = abrt_dedup_index_rebuild_begin() == 0;
+
     struct dirent *dent;
     while ((dent = readdir(dp)) != NULL)
     {
@@ -678,10 +1096,15 @@ static void mark_unprocessed_dump_dirs_not_reportable(const char *path)
                             "sort out this problem, please contact them directly."));
 
             }
+            if (index_dirs)
+                abrt_dedup_index_add(dd);
             dd_close(dd);
         }
     }
     closedir(dp);
+
+    if (index_dirs)
+        abrt_dedup_index_rebuild_end();
 }
 
 static void on_bus_acquired(GDBusConnection *connection,
@@ -824,6 +1247,11 @@ int main(int argc, char** argv)
     aiw = abrt_inotify_watch_init(abrt_g_settings_dump_location,
             IN_DUMP_LOCATION_FLAGS, handle_inotify_cb, /*user data*/NULL);
 
+    /* Measure the dump location once, inotify and post-create processing
+     * keep the sizes up-to-date afterwards.
+     */
+    s_dump_location_ledger = abrt_size_ledger_new(abrt_g_settings_dump_location);
+
     /* Add an event source which waits for INT/TERM signal */
     log_notice("Adding signal pipe watch to glib main loop");
     channel_signal = abrt_gio_channel_unix_new(s_signal_pipe[0]);
@@ -854,6 +1282,11 @@ int main(int argc, char** argv)
     /* Only now we want signal pipe to work */
     s_signal_pipe_write = s_signal_pipe[1];
 
+    /* Workers must be started after the signal pipe so that we do not miss
+     * SIGCHLD of a worker that failed to start.
+     */
+    start_abrt_server_workers();
+
     /* Own a name on D-Bus */
     name_id = g_bus_own_name(G_BUS_TYPE_SYSTEM,
                              ABRTD_DBUS_NAME,
@@ -899,6 +1332,7 @@ int main(int argc, char** argv)
         g_io_channel_unref(channel_signal);
 
     abrt_inotify_watch_destroy(aiw);
+    abrt_size_ledger_free(s_dump_location_ledger);
 
     if (s_main_loop)
         g_main_loop_unref(s_main_loop);
@@ -300,8 +300,8 @@ struct field_and_time_range {
     GList *list;
     const char *element;
     const char *value;
-    unsigned long timestamp_from;
-    unsigned long timestamp_to;
+    time_t timestamp_from;
+    time_t timestamp_to;
 };
 
 static int add_dirname_to_GList_if_matches(struct dump_dir *dd, void *arg)
@@ -322,15 +322,301 @@ static int add_dirname_to_GList_if_matches(struct dump_dir *dd, void *arg)
     return 0;
 }
 
+/*
+ * In-memory indexes of problem directories by values of commonly queried
+ * elements. Directories with the same value are kept sorted by their last
+ * occurrence, so a query reads only the directories in the requested time
+ * range.
+ *
+ * abrt-dbus is activated by the bus and exits after a period of inactivity
+ * (-t, 133 seconds in the service file), so an index lives only as long as
+ * the process and many calls have to build it anew. Hence each element has
+ * its own index built by the first query for that element. The build loads
+ * only the element and the last occurrence of every directory, the same as
+ * the unindexed search, so the first query costs no more than without the
+ * index and the following queries in the same activation are cheaper.
+ *
+ * A built index is kept current from ImportProblem and ReloadProblem
+ * signals and from the modifications done through this interface and
+ * through Problems2 ("problem-modified" signal of AbrtP2Service).
+ * Directories removed behind our back are dropped when a query finds them
+ * missing. The indexed elements are not expected to change once abrtd has
+ * processed the problem.
+ */
+static const char *const s_indexed_elements[] = {
+    FILENAME_COMPONENT,
+    FILENAME_EXECUTABLE,
+    FILENAME_PACKAGE,
+    FILENAME_PKG_NAME,
+    FILENAME_TYPE,
+    FILENAME_UUID,
+    FILENAME_DUPHASH,
+};
+
+struct indexed_problem
+{
+    char *dirname; ///< NULL in search keys
+    time_t last_occurrence;
+    char *value;
+    GSequenceIter *position;
+};
+
+struct element_index
+{
+    /* dirname -> struct indexed_problem */
+    GHashTable *problems;
+    /* value -> GSequence of struct indexed_problem ordered by last occurrence */
+    GHashTable *values;
+};
+
+/* Indexes of s_indexed_elements, NULL until the first query */
+static struct element_index *s_element_indexes[ARRAY_SIZE(s_indexed_elements)];
+
+static int element_index_position(const char *element)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_indexed_elements); ++i)
+    {
+        if (strcmp(s_indexed_elements[i], element) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+static bool element_index_any_built(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_indexed_elements); ++i)
+    {
+        if (s_element_indexes[i] != NULL)
+            return true;
+    }
+
+    return false;
+}
+
+static void indexed_problem_free(struct indexed_problem *problem)
+{
+    if (problem == NULL)
+        return;
+
+    free(problem->value);
+    free(problem->dirname);
+    free(problem);
+}
+
+static gint indexed_problem_cmp(gconstpointer a, gconstpointer b, gpointer unused)
+{
+    const struct indexed_problem *lhs = a;
+    const struct indexed_problem *rhs = b;
+
+    if (lhs->last_occurrence != rhs->last_occurrence)
+        return lhs->last_occurrence < rhs->last_occurrence ? -1 : 1;
+
+    /* A search key precedes all problems with the same last occurrence */
+    if (lhs->dirname == NULL || rhs->dirname == NULL)
+        return (lhs->dirname != NULL) - (rhs->dirname != NULL);
+
+    return strcmp(lhs->dirname, rhs->dirname);
+}
+
+static void element_index_remove_from(struct element_index *index, const char *dirname)
+{
+    struct indexed_problem *problem = g_hash_table_lookup(index->problems, dirname);
+    if (problem == NULL)
+        return;
+
+    GSequence *same_value = g_sequence_iter_get_sequence(problem->position);
+    g_sequence_remove(problem->position);
+
+    if (g_sequence_is_empty(same_value))
+        g_hash_table_remove(index->values, problem->value);
+
+    g_hash_table_remove(index->problems, dirname);
+}
+
+static void element_index_remove(const char *dirname)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_indexed_elements); ++i)
+    {
+        if (s_element_indexes[i] != NULL)
+            element_index_remove_from(s_element_indexes[i], dirname);
+    }
+
+    log_debug("Removed '%s' from element indexes", dirname);
+}
+
+static void element_index_add_to(struct element_index *index,
+                int position,
+                struct dump_dir *dd,
+                time_t last_occurrence)
+{
+    element_index_remove_from(index, dd->dd_dirname);
+
+    struct indexed_problem *problem = g_new0(struct indexed_problem, 1);
+    problem->dirname = g_strdup(dd->dd_dirname);
+    problem->last_occurrence = last_occurrence;
+    /* Missing elements are empty, the same as in dd_load_text() */
+    problem->value = dd_load_text_ext(dd, s_indexed_elements[position], DD_FAIL_QUIETLY_ENOENT);
+
+    GSequence *same_value = g_hash_table_lookup(index->values, problem->value);
+    if (same_value == NULL)
+    {
+        same_value = g_sequence_new(NULL);
+        g_hash_table_insert(index->values, g_strdup(problem->value), same_value);
+    }
+
+    problem->position = g_sequence_insert_sorted(same_value, problem, indexed_problem_cmp, NULL);
+    g_hash_table_insert(index->problems, problem->dirname, problem);
+}
+
+static int element_index_add_cb(struct dump_dir *dd, void *position)
+{
+    const int i = GPOINTER_TO_INT(position);
+    element_index_add_to(s_element_indexes[i], i, dd, dd_get_last_occurrence(dd));
+    return 0;
+}
+
+static struct element_index *element_index_build(int position)
+{
+    if (s_element_indexes[position] != NULL)
+        return s_element_indexes[position];
+
+    struct element_index *index = g_new0(struct element_index, 1);
+    index->problems = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                            NULL, (GDestroyNotify)indexed_problem_free);
+    index->values = g_hash_table_new_full(g_str_hash, g_str_equal,
+                                          free, (GDestroyNotify)g_sequence_free);
+    s_element_indexes[position] = index;
+
+    for_each_problem_in_dir(abrt_g_settings_dump_location, (uid_t)-1,
+                            element_index_add_cb, GINT_TO_POINTER(position));
+
+    log_info("Indexed %u problem directories by '%s'",
+             g_hash_table_size(index->problems), s_indexed_elements[position]);
+
+    return index;
+}
+
+static void element_index_destroy(void)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_indexed_elements); ++i)
+    {
+        struct element_index *index = s_element_indexes[i];
+        if (index == NULL)
+            continue;
+
+        /* Sequences do not own the problems */
+        g_hash_table_destroy(index->values);
+        g_hash_table_destroy(index->problems);
+        free(index);
+        s_element_indexes[i] = NULL;
+    }
+}
+
+/* Re-reads the directory into the indexes that have been built already */
+static void element_index_update(const char *dirname)
+{
+    if (!element_index_any_built())
+        return;
+
+    struct dump_dir *dd = dd_opendir(dirname, DD_OPEN_READONLY | DD_FAIL_QUIETLY_ENOENT);
+    if (dd == NULL)
+    {
+        if (errno == ENOENT)
+            element_index_remove(dirname);
+
+        return;
+    }
+
+    const time_t last_occurrence = dd_get_last_occurrence(dd);
+    for (size_t i = 0; i < ARRAY_SIZE(s_indexed_elements); ++i)
+    {
+        if (s_element_indexes[i] != NULL)
+            element_index_add_to(s_element_indexes[i], i, dd, last_occurrence);
+    }
+
+    dd_close(dd);
+}
+
+static void element_index_problem_modified(AbrtP2Service *service,
+                const char *dirname,
+                gpointer unused)
+{
+    element_index_update(dirname);
+}
+
+static GList *element_index_find(uid_t uid,
+                int position,
+                const char *value,
+                time_t timestamp_from,
+                time_t timestamp_to)
+{
+    struct element_index *index = element_index_build(position);
+
+    GSequence *same_value = g_hash_table_lookup(index->values, value);
+    if (same_value == NULL)
+        return NULL;
+
+    struct indexed_problem key = {
+        .dirname = NULL,
+        .last_occurrence = timestamp_from,
+    };
+
+    GList *candidates = NULL;
+    for (GSequenceIter *iter = g_sequence_search(same_value, &key, indexed_problem_cmp, NULL);
+         !g_sequence_iter_is_end(iter);
+         iter = g_sequence_iter_next(iter))
+    {
+        const struct indexed_problem *problem = g_sequence_get(iter);
+        if (problem->last_occurrence > timestamp_to)
+            break;
+
+        candidates = g_list_prepend(candidates, g_strdup(problem->dirname));
+    }
+
+    /* The candidates are verified after the walk because removing stale
+     * directories modifies the sequence. */
+    GList *list = NULL;
+    for (GList *iter = candidates; iter != NULL; iter = g_list_next(iter))
+    {
+        char *dirname = iter->data;
+        struct dump_dir *dd = dd_opendir(dirname,   DD_OPEN_FD_ONLY
+                                                  | DD_FAIL_QUIETLY_ENOENT
+                                                  | DD_FAIL_QUIETLY_EACCES);
+        if (dd == NULL)
+        {
+            if (errno == ENOENT)
+                element_index_remove(dirname);
+
+            free(dirname);
+            continue;
+        }
+
+        if (uid == (uid_t)-1 || dd_accessible_by_uid(dd, uid))
+            list = g_list_prepend(list, dirname);
+        else
+            free(dirname);
+
+        dd_close(dd);
+    }
+    g_list_free(candidates);
+
+    return list;
+}
+
 static GList *get_problem_dirs_for_element_in_time(uid_t uid,
                 const char *element,
                 const char *value,
-                unsigned long timestamp_from,
-                unsigned long timestamp_to)
+                time_t timestamp_from,
+                time_t timestamp_to)
 {
     if (timestamp_to == 0) /* not sure this is possible, but... */
         timestamp_to = time(NULL);
 
+    const int position = element_index_position(element);
+    if (position >= 0)
+        return element_index_find(uid, position, value, timestamp_from, timestamp_to);
+
     struct field_and_time_range me = {
         .list = NULL,
         .element = element,
@@ -648,6 +934,9 @@ static void handle_method_call(GDBusConnection *connection,
 
         dd_close(dd);
 
+        if (element_index_position(element) >= 0)
+            element_index_update(problem_id);
+
         return;
     }
 
@@ -670,6 +959,9 @@ static void handle_method_call(GDBusConnection *connection,
         const int res = dd_delete_item(dd, element);
         dd_close(dd);
 
+        if (element_index_position(element) >= 0)
+            element_index_update(problem_id);
+
         if (res != 0)
         {
             log_notice("Can't delete the element '%s' from the problem directory '%s'", element, problem_id);
@@ -744,6 +1036,8 @@ static void handle_method_call(GDBusConnection *connection,
                     error_msg("Failed to delete problem directory '%s'", dir_name);
                     dd_close(dd);
                 }
+                else
+                    element_index_remove(dir_name);
             }
         }
 
@@ -804,6 +1098,9 @@ static void handle_abrtd_problem_signals(GDBusConnection *connection,
     log_debug("Caught '%s' signal from abrtd: '%s'", signal_name, dir);
     AbrtP2Service *service = ABRT_P2_SERVICE(user_data);
 
+    /* ReloadProblem means that LastOccurrence of the problem changed */
+    element_index_update(dir);
+
     GError *error = NULL;
     AbrtP2Object *obj = abrt_p2_service_get_entry_for_problem(service,
                                                               dir,
@@ -835,6 +1132,9 @@ static void handle_abrtd_problem_signals(GDBusConnection *connection,
     }
 
     AbrtP2Entry *entry = ABRT_P2_ENTRY(abrt_p2_object_get_node(obj));
+    /* DupCrash means that Count and LastOccurrence of the entry changed */
+    abrt_p2_entry_invalidate_snapshot(entry);
+
     if (abrt_p2_entry_state(entry) != ABRT_P2_ENTRY_STATE_COMPLETE)
     {
         log_debug("Not notifying temporary/deleted problem directory: %s", dir);
@@ -1047,6 +1347,7 @@ int main(int argc, char *argv[])
 
     g_signal_connect(p2_service, "new-client-connected", G_CALLBACK(kill_timeout), NULL);
     g_signal_connect(p2_service, "all-clients-disconnected", G_CALLBACK(run_timeout), NULL);
+    g_signal_connect(p2_service, "problem-modified", G_CALLBACK(element_index_problem_modified), NULL);
 
     DBusConnection *con = dbus_connection_open("org.freedesktop.DBus", NULL);
 
@@ -1089,6 +1390,8 @@ int main(int argc, char *argv[])
 
     g_dbus_node_info_unref(introspection_data);
 
+    element_index_destroy();
+
     abrt_free_abrt_conf_data();
 
     return 0;
@@ -26,8 +26,52 @@ typedef struct
 {
     char *p2e_dirname;
     AbrtP2EntryState p2e_state;
+
+    /* Snapshot of frequently read elements: element name -> text or NULL if
+     * the element does not exist. The snapshot is valid if not NULL. */
+    GHashTable *p2e_snapshot;
+    time_t p2e_first_occurrence;
+    time_t p2e_last_occurrence;
+    /* Results of access checks: uid -> accessible; valid with the snapshot */
+    GHashTable *p2e_snapshot_access;
+    /* Change time of the problem directory the snapshot was loaded from.
+     * Zero if the snapshot must be loaded again by the next request. */
+    struct timespec p2e_snapshot_ctime;
 } AbrtP2EntryPrivate;
 
+/* Elements served from the snapshot */
+static const char *const s_snapshot_elements[] = {
+    FILENAME_USERNAME,
+    FILENAME_HOSTNAME,
+    FILENAME_TYPE,
+    FILENAME_EXECUTABLE,
+    FILENAME_CMDLINE,
+    FILENAME_COMPONENT,
+    FILENAME_UUID,
+    FILENAME_DUPHASH,
+    FILENAME_REASON,
+    FILENAME_NOT_REPORTABLE,
+    FILENAME_UID,
+    FILENAME_COUNT,
+    FILENAME_PACKAGE,
+    FILENAME_PKG_EPOCH,
+    FILENAME_PKG_NAME,
+    FILENAME_PKG_VERSION,
+    FILENAME_PKG_RELEASE,
+};
+
+/* Elements whose existence only is remembered in the snapshot */
+static const char *const s_snapshot_flag_elements[] = {
+    FILENAME_REPORTED_TO,
+    FILENAME_REMOTE,
+};
+
+enum {
+    ENTRY_SIGNALS_SNAPSHOT_INVALIDATED,
+    ENTRY_SIGNALS_NUM,
+};
+static guint entry_signals[ENTRY_SIGNALS_NUM] = { 0 };
+
 struct _AbrtP2Entry
 {
     GObject parent_instance;
@@ -36,9 +80,13 @@ struct _AbrtP2Entry
 
 G_DEFINE_TYPE_WITH_PRIVATE(AbrtP2Entry, abrt_p2_entry, G_TYPE_OBJECT)
 
+static bool entry_drop_snapshot(AbrtP2Entry *entry);
+
 static void abrt_p2_entry_finalize(GObject *gobject)
 {
     AbrtP2EntryPrivate *pv = abrt_p2_entry_get_instance_private(ABRT_P2_ENTRY(gobject));
+    entry_drop_snapshot(ABRT_P2_ENTRY(gobject));
+
     free(pv->p2e_dirname);
 }
 
@@ -46,6 +94,18 @@ static void abrt_p2_entry_class_init(AbrtP2EntryClass *klass)
 {
     GObjectClass *object_class = G_OBJECT_CLASS(klass);
     object_class->finalize = abrt_p2_entry_finalize;
+
+    entry_signals[ENTRY_SIGNALS_SNAPSHOT_INVALIDATED] =
+        g_signal_newv("snapshot-invalidated",
+                     G_TYPE_FROM_CLASS(klass),
+                     G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                     NULL /* closure */,
+                     NULL /* accumulator */,
+                     NULL /* accumulator data */,
+                     NULL /* C marshaller */,
+                     G_TYPE_NONE /* return_type */,
+                     0     /* n_params */,
+                     NULL  /* param_types */);
 }
 
 static void abrt_p2_entry_init(AbrtP2Entry *self)
@@ -76,6 +136,7 @@ AbrtP2EntryState abrt_p2_entry_state(AbrtP2Entry *entry)
 void abrt_p2_entry_set_state(AbrtP2Entry *entry, AbrtP2EntryState state)
 {
     entry->pv->p2e_state = state;
+    abrt_p2_entry_invalidate_snapshot(entry);
 }
 
 const char *abrt_p2_entry_problem_id(AbrtP2Entry *entry)
@@ -907,6 +968,10 @@ GVariant *abrt_p2_entry_save_elements_finish(AbrtP2Entry *entry,
 {
     g_return_val_if_fail(g_task_is_valid(result, entry), NULL);
 
+    /* The elements were saved in a worker thread, the snapshot can be
+     * touched only from the main loop thread. */
+    abrt_p2_entry_invalidate_snapshot(entry);
+
     return g_task_propagate_pointer(G_TASK(result), error);
 }
 
@@ -941,6 +1006,7 @@ GVariant *abrt_p2_entry_delete_elements(AbrtP2Entry *entry,
     }
 
     dd_close(dd);
+    abrt_p2_entry_invalidate_snapshot(entry);
 
     return NULL;
 }
@@ -970,3 +1036,325 @@ uid_t abrt_p2_entry_get_owner(AbrtP2Entry *entry,
 
     return uid;
 }
+
+/*
+ * Snapshot
+ */
+static bool entry_drop_snapshot(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+    const bool dropped = pv->p2e_snapshot != NULL;
+
+    if (pv->p2e_snapshot != NULL)
+    {
+        g_hash_table_destroy(pv->p2e_snapshot);
+        pv->p2e_snapshot = NULL;
+    }
+
+    if (pv->p2e_snapshot_access != NULL)
+    {
+        g_hash_table_destroy(pv->p2e_snapshot_access);
+        pv->p2e_snapshot_access = NULL;
+    }
+
+    return dropped;
+}
+
+void abrt_p2_entry_invalidate_snapshot(AbrtP2Entry *entry)
+{
+    if (entry_drop_snapshot(entry))
+        g_signal_emit(entry, entry_signals[ENTRY_SIGNALS_SNAPSHOT_INVALIDATED], 0);
+}
+
+/* Every modification of the problem directory changes its ctime: elements
+ * are saved as new files, the lock is a symbolic link and changes of the
+ * owner or of the mode are recorded too. One stat is much cheaper than an
+ * inotify watch per problem directory, the number of watches is limited.
+ */
+static bool entry_snapshot_is_current(AbrtP2Entry *entry)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+    if (pv->p2e_snapshot == NULL)
+        return false;
+
+    if (pv->p2e_snapshot_ctime.tv_sec == 0 && pv->p2e_snapshot_ctime.tv_nsec == 0)
+        return false;
+
+    struct stat statbuf;
+    if (stat(pv->p2e_dirname, &statbuf) != 0)
+        return false;
+
+    return statbuf.st_ctim.tv_sec == pv->p2e_snapshot_ctime.tv_sec
+        && statbuf.st_ctim.tv_nsec == pv->p2e_snapshot_ctime.tv_nsec;
+}
+
+static bool entry_dump_dir_is_locked(AbrtP2Entry *entry)
+{
+    g_autofree char *lock_path = g_build_filename(entry->pv->p2e_dirname, ".lock", NULL);
+    struct stat statbuf;
+    return lstat(lock_path, &statbuf) == 0;
+}
+
+int abrt_p2_entry_load_snapshot(AbrtP2Entry *entry,
+            uid_t caller_uid,
+            GError **error)
+{
+    AbrtP2EntryPrivate *pv = entry->pv;
+
+    const bool current = entry_snapshot_is_current(entry);
+
+    /* The owner might have changed together with the directory */
+    if (!current && pv->p2e_snapshot_access != NULL)
+        g_hash_table_remove_all(pv->p2e_snapshot_access);
+
+    gpointer accessible = NULL;
+    if (current
+        && g_hash_table_lookup_extended(pv->p2e_snapshot_access,
+                                        GUINT_TO_POINTER(caller_uid),
+                                        NULL,
+                                        &accessible))
+    {
+        if (GPOINTER_TO_INT(accessible))
+            return 0;
+
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to access the problem");
+
+        return -EACCES;
+    }
+
+    struct dump_dir *dd = NULL;
+    const int access_r = abrt_p2_entry_accessible_by_uid(entry, caller_uid, &dd);
+
+    if (pv->p2e_snapshot != NULL)
+        g_hash_table_insert(pv->p2e_snapshot_access,
+                            GUINT_TO_POINTER(caller_uid),
+                            GINT_TO_POINTER(access_r == 0));
+
+    if (access_r != 0)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_ACCESS_DENIED,
+                    "You are not authorized to access the problem");
+
+        return access_r;
+    }
+
+    if (current)
+    {
+        dd_close(dd);
+        return 0;
+    }
+
+    /* The elements are read without taking the lock, like libreport readers
+     * of directories they cannot write to do, because the lock would change
+     * the directory and the snapshot would never be current. A writer
+     * running in the meantime is detected by the change time or its lock.
+     */
+    const time_t started = time(NULL);
+    struct stat before;
+    if (stat(pv->p2e_dirname, &before) != 0)
+    {
+        g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_IO_ERROR,
+                    "Failed reopen dump directory");
+
+        dd_close(dd);
+        return -EIO;
+    }
+
+    GHashTable *snapshot = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, free);
+    for (size_t i = 0; i < ARRAY_SIZE(s_snapshot_elements); ++i)
+    {
+        char *data = dd_load_text_ext(dd, s_snapshot_elements[i], DD_FAIL_QUIETLY_ENOENT);
+        g_hash_table_insert(snapshot, (gpointer)s_snapshot_elements[i], data);
+    }
+
+    for (size_t i = 0; i < ARRAY_SIZE(s_snapshot_flag_elements); ++i)
+    {
+        char *data = dd_exist(dd, s_snapshot_flag_elements[i]) ? g_strdup("") : NULL;
+        g_hash_table_insert(snapshot, (gpointer)s_snapshot_flag_elements[i], data);
+    }
+
+    const time_t first_occurrence = dd_get_first_occurrence(dd);
+    const time_t last_occurrence = dd_get_last_occurrence(dd);
+
+    dd_close(dd);
+
+    struct stat after;
+    const bool consistent = stat(pv->p2e_dirname, &after) == 0
+                            && after.st_ctim.tv_sec == before.st_ctim.tv_sec
+                            && after.st_ctim.tv_nsec == before.st_ctim.tv_nsec
+                            && !entry_dump_dir_is_locked(entry);
+
+    pv->p2e_snapshot_ctime = (struct timespec){ 0, 0 };
+
+    if (!consistent && pv->p2e_snapshot != NULL)
+    {
+        log_debug("Problem directory '%s' is being modified, serving the last snapshot",
+                  pv->p2e_dirname);
+
+        g_hash_table_destroy(snapshot);
+        return 0;
+    }
+
+    abrt_p2_entry_invalidate_snapshot(entry);
+    pv->p2e_snapshot = snapshot;
+    pv->p2e_first_occurrence = first_occurrence;
+    pv->p2e_last_occurrence = last_occurrence;
+    pv->p2e_snapshot_access = g_hash_table_new(g_direct_hash, g_direct_equal);
+    g_hash_table_insert(pv->p2e_snapshot_access,
+                        GUINT_TO_POINTER(caller_uid),
+                        GINT_TO_POINTER(TRUE));
+
+    /* A change made in the second the directory was last changed might not
+     * change the time stamp again, such a snapshot is loaded again.
+     */
+    if (consistent && after.st_ctim.tv_sec < started)
+        pv->p2e_snapshot_ctime = after.st_ctim;
+
+    return 0;
+}
+
+const char *abrt_p2_entry_snapshot_text(AbrtP2Entry *entry,
+            const char *element_name)
+{
+    g_return_val_if_fail(entry->pv->p2e_snapshot != NULL, NULL);
+
+    return g_hash_table_lookup(entry->pv->p2e_snapshot, element_name);
+}
+
+bool abrt_p2_entry_snapshot_has(AbrtP2Entry *entry,
+            const char *element_name)
+{
+    return abrt_p2_entry_snapshot_text(entry, element_name) != NULL;
+}
+
+uint32_t abrt_p2_entry_snapshot_uint32(AbrtP2Entry *entry,
+            const char *element_name,
+            uint32_t def)
+{
+    const char *text = abrt_p2_entry_snapshot_text(entry, element_name);
+    if (text == NULL)
+        return def;
+
+    /* The same rules as in dd_load_uint32() */
+    char *end = NULL;
+    errno = 0;
+    const unsigned long long value = g_ascii_strtoull(text, &end, 10);
+    if (errno != 0 || end == text || *end != '\0' || value > UINT32_MAX)
+        return def;
+
+    return (uint32_t)value;
+}
+
+time_t abrt_p2_entry_snapshot_first_occurrence(AbrtP2Entry *entry)
+{
+    return entry->pv->p2e_first_occurrence;
+}
+
+time_t abrt_p2_entry_snapshot_last_occurrence(AbrtP2Entry *entry)
+{
+    return entry->pv->p2e_last_occurrence;
+}
+
+static bool is_snapshot_element(const char *element_name)
+{
+    for (size_t i = 0; i < ARRAY_SIZE(s_snapshot_elements); ++i)
+    {
+        if (strcmp(s_snapshot_elements[i], element_name) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+GVariant *abrt_p2_entry_get_info(AbrtP2Entry *entry,
+            GVariant *elements,
+            uid_t caller_uid,
+            long max_size,
+            size_t *loaded_size,
+            GError **error)
+{
+    if (abrt_p2_entry_load_snapshot(entry, caller_uid, error) != 0)
+        return NULL;
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{sv}"));
+
+    /* Opened only if an element is not in the snapshot */
+    struct dump_dir *dd = NULL;
+
+    const gchar *name = NULL;
+    GVariantIter iter;
+    g_variant_iter_init(&iter, elements);
+    while (g_variant_iter_next(&iter, "&s", &name))
+    {
+        g_autofree char *loaded = NULL;
+        const char *data = NULL;
+
+        if (strcmp(name, CD_DUMPDIR) == 0)
+            data = entry->pv->p2e_dirname;
+        else if (is_snapshot_element(name))
+            data = abrt_p2_entry_snapshot_text(entry, name);
+        else
+        {
+            if (dd == NULL)
+            {
+                dd = abrt_p2_entry_open_dump_dir(entry,
+                                                 caller_uid,
+                                                 DD_OPEN_READONLY | DD_DONT_WAIT_FOR_LOCK,
+                                                 error);
+                if (dd == NULL)
+                {
+                    g_variant_builder_clear(&builder);
+                    return NULL;
+                }
+            }
+
+            int elem_type = 0;
+            int fd = -1;
+            const int r = problem_data_load_dump_dir_element(dd,
+                                                             name,
+                                                             &loaded,
+                                                             &elem_type,
+                                                             &fd);
+            if (r < 0)
+            {
+                if (r == -EINVAL)
+                    error_msg("Attempt to read prohibited data: '%s'", name);
+                else if (r != -ENOENT)
+                    error_msg("Failed to open %s: %s", name, strerror(-r));
+
+                continue;
+            }
+            close(fd);
+
+            if (!(elem_type & CD_FLAG_TXT))
+            {
+                log_debug("Element is not text: %s", name);
+                continue;
+            }
+
+            data = loaded;
+        }
+
+        if (data == NULL)
+            continue;
+
+        const size_t data_size = strlen(data);
+        if (data_size > max_size || *loaded_size > max_size - data_size)
+        {
+            error_msg("With element '%s', reached runtime data size limit: %ld",
+                      name,
+                      max_size);
+
+            continue;
+        }
+
+        *loaded_size += data_size;
+        g_variant_builder_add(&builder, "{sv}", name, g_variant_new_string(data));
+    }
+
+    dd_close(dd);
+
+    return g_variant_builder_end(&builder);
+}
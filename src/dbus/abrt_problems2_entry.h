@@ -84,6 +84,53 @@ GVariant *abrt_p2_entry_delete_elements(AbrtP2Entry *entry,
  */
 uid_t abrt_p2_entry_get_owner(AbrtP2Entry *entry, GError **error);
 
+/*
+ * Snapshot of frequently read elements
+ *
+ * Property getters are served from the snapshot without opening and locking
+ * the problem directory. abrt_p2_entry_load_snapshot() loads the snapshot
+ * again when the change time of the directory differs from the loaded one;
+ * while the directory is being modified, the last snapshot is served. The
+ * functions must be called from the main loop thread.
+ *
+ * The "snapshot-invalidated" signal is emitted when a loaded snapshot is
+ * dropped or replaced, so cached copies of the snapshot values can be
+ * refreshed.
+ */
+int abrt_p2_entry_load_snapshot(AbrtP2Entry *entry,
+            uid_t caller_uid,
+            GError **error);
+
+void abrt_p2_entry_invalidate_snapshot(AbrtP2Entry *entry);
+
+const char *abrt_p2_entry_snapshot_text(AbrtP2Entry *entry,
+            const char *element_name);
+
+bool abrt_p2_entry_snapshot_has(AbrtP2Entry *entry,
+            const char *element_name);
+
+uint32_t abrt_p2_entry_snapshot_uint32(AbrtP2Entry *entry,
+            const char *element_name,
+            uint32_t def);
+
+time_t abrt_p2_entry_snapshot_first_occurrence(AbrtP2Entry *entry);
+
+time_t abrt_p2_entry_snapshot_last_occurrence(AbrtP2Entry *entry);
+
+/*
+ * Returns text values of the requested elements as a{sv}. Elements from the
+ * snapshot are served without opening the problem directory. CD_DUMPDIR
+ * stands for the problem directory path. Missing and non-text elements are
+ * omitted. The size of the values is added to loaded_size and no value is
+ * added once it would exceed max_size.
+ */
+GVariant *abrt_p2_entry_get_info(AbrtP2Entry *entry,
+            GVariant *elements,
+            uid_t caller_uid,
+            long max_size,
+            size_t *loaded_size,
+            GError **error);
+
 /*
  * Read elements
  */
@@ -135,6 +135,7 @@ static void user_info_free(struct user_info *info)
 enum {
     SERVICE_SIGNALS_NEW_CLIENT_CONNECTED,
     SERVICE_SIGNALS_ALL_CLIENTS_DISCONNECTED,
+    SERVICE_SIGNALS_PROBLEM_MODIFIED,
     SERVICE_SIGNALS_NUM,
 };
 static guint service_signals[SERVICE_SIGNALS_NUM] = { 0 };
@@ -161,6 +162,13 @@ typedef struct
     unsigned p2srv_limit_new_problems_batch;
 
     AbrtP2Object *p2srv_p2_object;
+
+    /* Sorted indexes of Entry objects, see entry_index_refresh() */
+    GHashTable *p2srv_entry_index;
+    GHashTable *p2srv_entry_index_dirty;
+    gint64      p2srv_entry_index_validated;
+    GSequence  *p2srv_entries_by_time;
+    GSequence  *p2srv_entries_by_count;
 } AbrtP2ServicePrivate;
 
 struct _AbrtP2Service
@@ -741,10 +749,23 @@ void abrt_p2_service_notify_entry_object(AbrtP2Service *service,
 
 struct entry_object_save_elements_context
 {
+    AbrtP2Service *service;
     GDBusMethodInvocation *invocation;
     GVariant *elements;
 };
 
+/* Lets other users of the problem directories (e.g. indexes kept by
+ * abrt-dbus) know that a client has changed or removed the directory.
+ */
+static void service_notify_problem_modified(AbrtP2Service *service,
+            AbrtP2Entry *entry)
+{
+    g_signal_emit(service,
+                  service_signals[SERVICE_SIGNALS_PROBLEM_MODIFIED],
+                  0,
+                  abrt_p2_entry_problem_id(entry));
+}
+
 static void entry_object_save_elements_cb(GObject *source_object,
             GAsyncResult *result,
             gpointer user_data)
@@ -759,6 +780,9 @@ static void entry_object_save_elements_cb(GObject *source_object,
                                                             result,
                                                             &error);
 
+    /* Even a failed request might have saved some elements */
+    service_notify_problem_modified(context->service, entry);
+
     if (error == NULL)
     {
         g_dbus_method_invocation_return_value(context->invocation, response);
@@ -872,6 +896,7 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 
         struct entry_object_save_elements_context *context = g_new(struct entry_object_save_elements_context, 1);
 
+        context->service = service;
         context->invocation = g_object_ref(invocation);
         context->elements = g_variant_get_child_value(parameters, 0);
 
@@ -905,6 +930,8 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
                                                  elements,
                                                  &error);
 
+        service_notify_problem_modified(service, entry);
+
         g_variant_unref(elements);
     }
     else
@@ -927,25 +954,26 @@ static void entry_object_dbus_method_call(GDBusConnection *connection,
 }
 
 
+/* The following properties are served from the entry's snapshot */
 #define GET_PLAIN_TEXT_PROPERTY(name, element) \
         if (strcmp(name, property_name) == 0) \
         { \
-            char *tmp_value = dd_load_text_ext(dd, element, DD_FAIL_QUIETLY_ENOENT); \
-            retval = g_variant_new_string(tmp_value ? tmp_value : ""); \
-            free(tmp_value); \
-            goto return_property_value; \
+            const char *tmp_value = abrt_p2_entry_snapshot_text(entry, element); \
+            return g_variant_new_string(tmp_value ? tmp_value : ""); \
         }
 
-#define GET_INTEGER_PROPERTY(name, element, S, def) \
+#define GET_UINT32_PROPERTY(name, element, def) \
         if (strcmp(name, property_name) == 0) \
         { \
-            uint##S##_t tmp_value = def; \
-            dd_load_uint##S (dd, element, &tmp_value); \
-            retval = g_variant_new_uint##S ((guint##S)tmp_value); \
-            goto return_property_value; \
+            const uint32_t tmp_value = abrt_p2_entry_snapshot_uint32(entry, element, def); \
+            return g_variant_new_uint32((guint32)tmp_value); \
         }
 
-#define GET_UINT32_PROPERTY(name, element, def) GET_INTEGER_PROPERTY(name, element, 32, def)
+#define GET_EXISTS_PROPERTY(name, element, exists) \
+        if (strcmp(name, property_name) == 0) \
+        { \
+            return g_variant_new_boolean(abrt_p2_entry_snapshot_has(entry, element) == exists); \
+        }
 
 static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
             const gchar *caller,
@@ -962,20 +990,12 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
     if (caller_uid == (uid_t)-1)
         return NULL;
 
-    GVariant *retval;
     AbrtP2Entry *entry = abrt_p2_object_get_node(user_data);
-    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
-                                                      caller_uid,
-                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
-                                                      error);
-    if (dd == NULL)
+    if (abrt_p2_entry_load_snapshot(entry, caller_uid, error) != 0)
         return NULL;
 
     if (strcmp("ID", property_name) == 0)
-    {
-        retval = g_variant_new_string(dd->dd_dirname);
-        goto return_property_value;
-    }
+        return g_variant_new_string(abrt_p2_entry_problem_id(entry));
 
     GET_PLAIN_TEXT_PROPERTY("User", FILENAME_USERNAME)
     GET_PLAIN_TEXT_PROPERTY("Hostname", FILENAME_HOSTNAME)
@@ -993,32 +1013,28 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
 
     if (strcmp("FirstOccurrence", property_name) == 0)
     {
-        time_t tm = dd_get_first_occurrence(dd);
+        time_t tm = abrt_p2_entry_snapshot_first_occurrence(entry);
         if (tm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: FirstOccurrence cannot be returned");
             return NULL;
         }
 
-        retval = g_variant_new_uint64((guint64)tm);
-        goto return_property_value;
+        return g_variant_new_uint64((guint64)tm);
     }
 
     if (strcmp("LastOccurrence", property_name) == 0)
     {
-        time_t ltm = dd_get_last_occurrence(dd);
+        time_t ltm = abrt_p2_entry_snapshot_last_occurrence(entry);
         if (ltm == (time_t) -1)
         {
-            dd_close(dd);
             g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_FAILED,
                         "Invalid problem data: LastOccurrence cannot be returned");
             return NULL;
         }
 
-        retval = g_variant_new_uint64((guint64)ltm);
-        goto return_property_value;
+        return g_variant_new_uint64((guint64)ltm);
     }
 
     if (strcmp("Package", property_name) == 0)
@@ -1033,14 +1049,26 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         g_variant_builder_init(&builder, G_VARIANT_TYPE("(sssss)"));
         for (size_t i = 0; i < ARRAY_SIZE(elements); ++i)
         {
-            g_autofree char *data = dd_load_text_ext(dd, elements[i], DD_FAIL_QUIETLY_ENOENT);
+            const char *data = abrt_p2_entry_snapshot_text(entry, elements[i]);
             g_variant_builder_add(&builder, "s", data);
         }
 
-        retval = g_variant_builder_end(&builder);
-        goto return_property_value;
+        return g_variant_builder_end(&builder);
     }
 
+    GET_EXISTS_PROPERTY("IsReported", FILENAME_REPORTED_TO, true)
+    GET_EXISTS_PROPERTY("CanBeReported", FILENAME_NOT_REPORTABLE, false)
+    GET_EXISTS_PROPERTY("IsRemote", FILENAME_REMOTE, true)
+
+    /* The remaining properties are read from the problem directory */
+    GVariant *retval;
+    struct dump_dir *dd = abrt_p2_entry_open_dump_dir(entry,
+                                                      caller_uid,
+                                                      DD_DONT_WAIT_FOR_LOCK | DD_OPEN_READONLY,
+                                                      error);
+    if (dd == NULL)
+        return NULL;
+
     if (strcmp("Reports", property_name) == 0)
     {
         GVariantBuilder top_builder;
@@ -1149,24 +1177,6 @@ static GVariant *entry_object_dbus_get_property(GDBusConnection *connection,
         goto return_property_value;
     }
 
-    if (strcmp("IsReported", property_name) == 0)
-    {
-       retval = g_variant_new_boolean(dd_exist(dd, FILENAME_REPORTED_TO));
-       goto return_property_value;
-    }
-
-    if (strcmp("CanBeReported", property_name) == 0)
-    {
-       retval = g_variant_new_boolean(!dd_exist(dd, FILENAME_NOT_REPORTABLE));
-       goto return_property_value;
-    }
-
-    if (strcmp("IsRemote", property_name) == 0)
-    {
-       retval = g_variant_new_boolean(dd_exist(dd, FILENAME_REMOTE));
-       goto return_property_value;
-    }
-
     dd_close(dd);
     error_msg("Unknown property %s", property_name);
     g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_UNKNOWN_PROPERTY,
@@ -1325,9 +1335,254 @@ static gboolean entry_object_dbus_set_property(GDBusConnection *connection,
 }
 #endif/*PROBLEMS2_PROPERTY_SET*/
 
+/*
+ * Sorted indexes of Entry objects
+ *
+ * GetProblems selects a range of last occurrences and a page of entries
+ * without opening all problem directories. The keys are copied from the
+ * entries' snapshots. An entry whose snapshot has been invalidated is marked
+ * dirty and re-indexed before the next query.
+ */
+struct entry_index_node
+{
+    AbrtP2Object *obj; ///< NULL in search keys
+    time_t last_occurrence;
+    uint32_t count;
+    char *component;
+    char *executable;
+    bool reported;
+    GSequenceIter *by_time;
+    GSequenceIter *by_count;
+    gulong invalidated_handler;
+    /* Change time of the problem directory whose snapshot could not be
+     * loaded, the entry is indexed again once the directory changes. */
+    bool load_failed;
+    struct timespec failed_ctime;
+};
+
+/* abrt-dbus runs as root and root can read all problem directories */
+#define ENTRY_INDEX_LOADER_UID 0
+
+/* Minimal time between two validations of all snapshots */
+#define ENTRY_INDEX_VALIDATION_INTERVAL_USEC (5 * G_USEC_PER_SEC)
+
+static void entry_index_node_free(struct entry_index_node *node)
+{
+    if (node == NULL)
+        return;
+
+    free(node->component);
+    free(node->executable);
+    free(node);
+}
+
+static gint entry_index_cmp_time(gconstpointer a, gconstpointer b, gpointer unused)
+{
+    const struct entry_index_node *lhs = a;
+    const struct entry_index_node *rhs = b;
+
+    if (lhs->last_occurrence != rhs->last_occurrence)
+        return lhs->last_occurrence < rhs->last_occurrence ? -1 : 1;
+
+    /* A search key precedes all entries with the same keys */
+    if (lhs->obj == rhs->obj)
+        return 0;
+    if (lhs->obj == NULL)
+        return -1;
+    if (rhs->obj == NULL)
+        return 1;
+
+    return strcmp(lhs->obj->p2o_path, rhs->obj->p2o_path);
+}
+
+static gint entry_index_cmp_count(gconstpointer a, gconstpointer b, gpointer unused)
+{
+    const struct entry_index_node *lhs = a;
+    const struct entry_index_node *rhs = b;
+
+    if (lhs->count != rhs->count)
+        return lhs->count < rhs->count ? -1 : 1;
+
+    return entry_index_cmp_time(a, b, unused);
+}
+
+static void entry_index_snapshot_invalidated(AbrtP2Entry *entry,
+            gpointer user_data)
+{
+    AbrtP2Object *obj = user_data;
+    g_hash_table_add(obj->p2o_service->pv->p2srv_entry_index_dirty, obj);
+}
+
+static void entry_index_unlink(struct entry_index_node *node)
+{
+    if (node->by_time != NULL)
+    {
+        g_sequence_remove(node->by_time);
+        node->by_time = NULL;
+    }
+
+    if (node->by_count != NULL)
+    {
+        g_sequence_remove(node->by_count);
+        node->by_count = NULL;
+    }
+}
+
+static void entry_index_insert(AbrtP2Service *service,
+            AbrtP2Object *obj)
+{
+    struct entry_index_node *node = g_new0(struct entry_index_node, 1);
+    node->obj = obj;
+    node->invalidated_handler = g_signal_connect(obj->node,
+                                                 "snapshot-invalidated",
+                                                 G_CALLBACK(entry_index_snapshot_invalidated),
+                                                 obj);
+
+    g_hash_table_insert(service->pv->p2srv_entry_index, obj, node);
+    /* Keys are loaded lazily by the first query */
+    g_hash_table_add(service->pv->p2srv_entry_index_dirty, obj);
+}
+
+static void entry_index_remove(AbrtP2Service *service,
+            AbrtP2Object *obj)
+{
+    /* Objects can outlive the service when D-Bus unregisters them late */
+    if (service->pv->p2srv_entry_index == NULL)
+        return;
+
+    struct entry_index_node *node = g_hash_table_lookup(service->pv->p2srv_entry_index, obj);
+    if (node == NULL)
+        return;
+
+    g_signal_handler_disconnect(obj->node, node->invalidated_handler);
+    entry_index_unlink(node);
+
+    g_hash_table_remove(service->pv->p2srv_entry_index_dirty, obj);
+    g_hash_table_remove(service->pv->p2srv_entry_index, obj);
+}
+
+static void entry_index_refresh(AbrtP2Service *service)
+{
+    AbrtP2ServicePrivate *pv = service->pv;
+
+    /* Snapshots are validated when they are loaded, an entry whose problem
+     * directory has changed emits "snapshot-invalidated" and becomes dirty.
+     * Costs one stat per current entry, so it is done at most once per
+     * interval. Changes announced by signals (DupCrash, ReloadProblem, and
+     * the modifications done through Problems2) invalidate the snapshots
+     * right away; only changes done behind our back may be seen late.
+     */
+    GHashTableIter iter;
+    gpointer obj;
+    gpointer value;
+    const gint64 now = g_get_monotonic_time();
+    const bool validate = pv->p2srv_entry_index_validated == 0
+                          || now - pv->p2srv_entry_index_validated >= ENTRY_INDEX_VALIDATION_INTERVAL_USEC;
+    if (validate)
+        pv->p2srv_entry_index_validated = now;
+
+    g_hash_table_iter_init(&iter, pv->p2srv_entry_index);
+    while (validate && g_hash_table_iter_next(&iter, &obj, &value))
+    {
+        if (g_hash_table_contains(pv->p2srv_entry_index_dirty, obj))
+            continue;
+
+        AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+        if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED)
+            continue;
+
+        struct entry_index_node *node = value;
+        if (node->load_failed)
+        {
+            struct stat statbuf;
+            if (stat(abrt_p2_entry_problem_id(entry), &statbuf) != 0
+                || (statbuf.st_ctim.tv_sec == node->failed_ctime.tv_sec
+                    && statbuf.st_ctim.tv_nsec == node->failed_ctime.tv_nsec))
+                continue;
+
+            g_hash_table_add(pv->p2srv_entry_index_dirty, obj);
+            continue;
+        }
+
+        GError *error = NULL;
+        if (abrt_p2_entry_load_snapshot(entry, ENTRY_INDEX_LOADER_UID, &error) != 0)
+        {
+            g_error_free(error);
+            g_hash_table_add(pv->p2srv_entry_index_dirty, obj);
+        }
+    }
+
+    if (g_hash_table_size(pv->p2srv_entry_index_dirty) == 0)
+        return;
+
+    /* Loading of a snapshot can emit "snapshot-invalidated", such entries
+     * are collected in a new set.
+     */
+    GHashTable *dirty = pv->p2srv_entry_index_dirty;
+    pv->p2srv_entry_index_dirty = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+    log_debug("Re-indexing %u entries", g_hash_table_size(dirty));
+
+    g_hash_table_iter_init(&iter, dirty);
+    while (g_hash_table_iter_next(&iter, &obj, NULL))
+    {
+        struct entry_index_node *node = g_hash_table_lookup(pv->p2srv_entry_index, obj);
+        if (node == NULL)
+            continue;
+
+        entry_index_unlink(node);
+
+        AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+        if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED)
+            continue;
+
+        GError *error = NULL;
+        node->load_failed = abrt_p2_entry_load_snapshot(entry, ENTRY_INDEX_LOADER_UID, &error) != 0;
+        if (node->load_failed)
+        {
+            /* Listed with the last known keys; loaded again only after the
+             * directory changes, not by every query.
+             */
+            log_debug("Cannot load entry '%s': %s",
+                      abrt_p2_object_path(obj), error->message);
+            g_error_free(error);
+
+            struct stat statbuf;
+            node->failed_ctime = stat(abrt_p2_entry_problem_id(entry), &statbuf) == 0
+                                 ? statbuf.st_ctim
+                                 : (struct timespec){ 0, 0 };
+        }
+        else
+        {
+            free(node->component);
+            node->component = g_strdup(abrt_p2_entry_snapshot_text(entry, FILENAME_COMPONENT));
+            free(node->executable);
+            node->executable = g_strdup(abrt_p2_entry_snapshot_text(entry, FILENAME_EXECUTABLE));
+            node->reported = abrt_p2_entry_snapshot_has(entry, FILENAME_REPORTED_TO);
+            node->count = abrt_p2_entry_snapshot_uint32(entry, FILENAME_COUNT, 1);
+            node->last_occurrence = abrt_p2_entry_snapshot_last_occurrence(entry);
+        }
+
+        /* The keys are as fresh as they can be */
+        g_hash_table_remove(pv->p2srv_entry_index_dirty, obj);
+
+        node->by_time = g_sequence_insert_sorted(pv->p2srv_entries_by_time,
+                                                 node,
+                                                 entry_index_cmp_time,
+                                                 NULL);
+        node->by_count = g_sequence_insert_sorted(pv->p2srv_entries_by_count,
+                                                  node,
+                                                  entry_index_cmp_count,
+                                                  NULL);
+    }
+
+    g_hash_table_destroy(dirty);
+}
+
 static void entry_object_destructor(AbrtP2Object *obj)
 {
     AbrtP2Entry *entry = (AbrtP2Entry *)obj->node;
+    entry_index_remove(obj->p2o_service, obj);
     g_object_unref(entry);
 }
 
@@ -1395,6 +1650,8 @@ AbrtP2Object *abrt_p2_service_register_entry(AbrtP2Service *service,
 
     user->problems++;
 
+    entry_index_insert(service, obj);
+
     return obj;
 }
 
@@ -1640,6 +1897,8 @@ int abrt_p2_service_remove_problem(AbrtP2Service *service,
         return ret;
     }
 
+    service_notify_problem_modified(service, entry);
+
     abrt_p2_object_destroy(obj);
     return 0;
 }
@@ -2068,34 +2327,237 @@ GVariant *abrt_p2_service_callers_session(AbrtP2Service *service,
     return g_variant_new("(o)", session_path);
 }
 
+/*
+ * Options of GetProblems
+ */
+struct entry_query
+{
+    const gchar **components;
+    const gchar **executables;
+    gint64 since;
+    gint64 until;
+    gboolean not_reported;
+    gboolean by_count;
+    gboolean reverse;
+    guint32 offset;
+    guint32 limit;
+};
+
+static void entry_query_destroy(struct entry_query *query)
+{
+    g_free(query->components);
+    g_free(query->executables);
+}
+
+static bool entry_query_option_type(const char *name,
+            GVariant *value,
+            const GVariantType *type,
+            GError **error)
+{
+    if (g_variant_is_of_type(value, type))
+        return true;
+
+    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                "Option '%s' must be of type '%s'",
+                name, g_variant_type_peek_string(type));
+    return false;
+}
+
+static int entry_query_init(struct entry_query *query,
+            GVariant *options,
+            GError **error)
+{
+    memset(query, 0, sizeof(*query));
+    query->since = G_MININT64;
+    query->until = G_MAXINT64;
+
+    int r = 0;
+    GVariantIter iter;
+    const gchar *name;
+    GVariant *value;
+    g_variant_iter_init(&iter, options);
+    while (r == 0 && g_variant_iter_next(&iter, "{&sv}", &name, &value))
+    {
+        if (strcmp(name, "components") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_STRING_ARRAY, error))
+                r = -EINVAL;
+            else
+            {
+                g_free(query->components);
+                query->components = g_variant_get_strv(value, NULL);
+            }
+        }
+        else if (strcmp(name, "executables") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_STRING_ARRAY, error))
+                r = -EINVAL;
+            else
+            {
+                g_free(query->executables);
+                query->executables = g_variant_get_strv(value, NULL);
+            }
+        }
+        else if (strcmp(name, "since") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_INT64, error))
+                r = -EINVAL;
+            else
+                query->since = g_variant_get_int64(value);
+        }
+        else if (strcmp(name, "until") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_INT64, error))
+                r = -EINVAL;
+            else
+                query->until = g_variant_get_int64(value);
+        }
+        else if (strcmp(name, "not-reported") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_BOOLEAN, error))
+                r = -EINVAL;
+            else
+                query->not_reported = g_variant_get_boolean(value);
+        }
+        else if (strcmp(name, "reverse") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_BOOLEAN, error))
+                r = -EINVAL;
+            else
+                query->reverse = g_variant_get_boolean(value);
+        }
+        else if (strcmp(name, "offset") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_UINT32, error))
+                r = -EINVAL;
+            else
+                query->offset = g_variant_get_uint32(value);
+        }
+        else if (strcmp(name, "limit") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_UINT32, error))
+                r = -EINVAL;
+            else
+                query->limit = g_variant_get_uint32(value);
+        }
+        else if (strcmp(name, "sort") == 0)
+        {
+            if (!entry_query_option_type(name, value, G_VARIANT_TYPE_STRING, error))
+                r = -EINVAL;
+            else
+            {
+                const gchar *sort = g_variant_get_string(value, NULL);
+                if (strcmp(sort, "count") == 0)
+                    query->by_count = TRUE;
+                else if (strcmp(sort, "last-occurrence") == 0)
+                    query->by_count = FALSE;
+                else
+                {
+                    g_set_error(error, G_DBUS_ERROR, G_DBUS_ERROR_INVALID_ARGS,
+                                "Unknown sort order '%s'", sort);
+                    r = -EINVAL;
+                }
+            }
+        }
+        /* Unknown options are ignored for the sake of forward compatibility */
+
+        g_variant_unref(value);
+    }
+
+    if (r != 0)
+        entry_query_destroy(query);
+
+    return r;
+}
+
+static bool strv_contains_or_empty(const gchar *const *strv, const char *str)
+{
+    if (strv == NULL || strv[0] == NULL)
+        return true;
+
+    return str != NULL && g_strv_contains(strv, str);
+}
+
+static bool entry_query_match(const struct entry_query *query,
+            const struct entry_index_node *node)
+{
+    return node->last_occurrence >= query->since
+        && node->last_occurrence <= query->until
+        && !(query->not_reported && node->reported)
+        && strv_contains_or_empty(query->components, node->component)
+        && strv_contains_or_empty(query->executables, node->executable);
+}
+
 GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
                 uid_t caller_uid,
                 AbrtP2ServiceGetProblemsFlags flags,
                 GVariant *options,
                 GError **error)
 {
-    unsigned int size;
-    GVariantBuilder builder;
-    GHashTableIter iter;
+    struct entry_query query;
+    if (entry_query_init(&query, options, error) != 0)
+        return NULL;
 
-    size = g_hash_table_size(service->pv->p2srv_p2_entry_type.objects);
-    if (size > 100)
+    entry_index_refresh(service);
+
+    /* The time index yields the requested range directly; the count index
+     * is walked whole and the range is checked for every entry.
+     */
+    GSequenceIter *begin;
+    GSequenceIter *end;
+    if (query.by_count)
+    {
+        begin = g_sequence_get_begin_iter(service->pv->p2srv_entries_by_count);
+        end = g_sequence_get_end_iter(service->pv->p2srv_entries_by_count);
+    }
+    else
     {
-        log_warning("Large numbers of problems may result in degraded performance, consider cleaning some up (currently %u)",
-                    size);
+        struct entry_index_node key = { .obj = NULL };
+
+        key.last_occurrence = query.since;
+        begin = g_sequence_search(service->pv->p2srv_entries_by_time,
+                                  &key, entry_index_cmp_time, NULL);
+
+        if (query.until == G_MAXINT64)
+            end = g_sequence_get_end_iter(service->pv->p2srv_entries_by_time);
+        else
+        {
+            key.last_occurrence = query.until + 1;
+            end = g_sequence_search(service->pv->p2srv_entries_by_time,
+                                    &key, entry_index_cmp_time, NULL);
+        }
     }
 
+    GVariantBuilder builder;
     g_variant_builder_init(&builder, G_VARIANT_TYPE("ao"));
-    g_hash_table_iter_init(&iter, service->pv->p2srv_p2_entry_type.objects);
+
+    /* The most recent or the most frequent problems come first */
+    const bool descending = !query.reverse;
+    GSequenceIter *iter = descending ? end : begin;
+    guint32 skipped = 0;
+    guint32 added = 0;
 
     log_debug("Going through entries");
-    const char *entry_path;
-    AbrtP2Object *entry_obj;
-    while(g_hash_table_iter_next(&iter, (gpointer)&entry_path, (gpointer)&entry_obj))
+    while (descending ? iter != begin : iter != end)
     {
+        if (query.limit != 0 && added >= query.limit)
+            break;
+
+        if (descending)
+            iter = g_sequence_iter_prev(iter);
+
+        struct entry_index_node *node = g_sequence_get(iter);
+
+        if (!descending)
+            iter = g_sequence_iter_next(iter);
+
+        if (!entry_query_match(&query, node))
+            continue;
+
+        const char *entry_path = node->obj->p2o_path;
         bool singleout = flags == 0;
 
-        AbrtP2Entry *entry = abrt_p2_object_get_node(entry_obj);
+        AbrtP2Entry *entry = abrt_p2_object_get_node(node->obj);
         int state = abrt_p2_entry_state(entry);
 
         log_debug("Entry: %s", entry_path);
@@ -2120,19 +2582,107 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             singleout = singleout || (flags & ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_FOREIGN);
         }
 
-        if (singleout)
+        if (!singleout)
+            continue;
+
+        if (skipped < query.offset)
         {
-            log_debug("Adding entry: %s", entry_path);
-            g_variant_builder_add(&builder, "o", entry_path);
+            ++skipped;
+            continue;
         }
+
+        log_debug("Adding entry: %s", entry_path);
+        g_variant_builder_add(&builder, "o", entry_path);
+        ++added;
     }
 
+    entry_query_destroy(&query);
 
     GVariant *retval_body[1];
     retval_body[0] = g_variant_builder_end(&builder);
     return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
 }
 
+GVariant *abrt_p2_service_get_problems_info(AbrtP2Service *service,
+                uid_t caller_uid,
+                GVariant *entries,
+                GVariant *elements,
+                GVariant *options,
+                GError **error)
+{
+    GVariant *found_entries = NULL;
+    if (g_variant_n_children(entries) == 0)
+    {
+        gint32 flags = ABRT_P2_SERVICE_GET_PROBLEM_FLAGS_NONE;
+        g_variant_lookup(options, "flags", "i", &flags);
+
+        GVariant *problems = abrt_p2_service_get_problems(service,
+                                                          caller_uid,
+                                                          flags,
+                                                          options,
+                                                          error);
+        if (problems == NULL)
+            return NULL;
+
+        g_variant_ref_sink(problems);
+        found_entries = g_variant_get_child_value(problems, 0);
+        g_variant_unref(problems);
+
+        entries = found_entries;
+    }
+
+    const long max_size = abrt_p2_service_max_message_size(service);
+    size_t loaded_size = 0;
+
+    GVariantBuilder builder;
+    g_variant_builder_init(&builder, G_VARIANT_TYPE("a{oa{sv}}"));
+
+    const gchar *entry_path = NULL;
+    GVariantIter iter;
+    g_variant_iter_init(&iter, entries);
+    while (g_variant_iter_next(&iter, "&o", &entry_path))
+    {
+        GError *local_error = NULL;
+        AbrtP2Object *obj = abrt_p2_service_get_entry_object(service,
+                                                             entry_path,
+                                                             ABRT_P2_SERVICE_ENTRY_LOOKUP_NOFLAGS,
+                                                             &local_error);
+        GVariant *info = NULL;
+        if (obj != NULL)
+        {
+            AbrtP2Entry *entry = abrt_p2_object_get_node(obj);
+            if (abrt_p2_entry_state(entry) == ABRT_P2_ENTRY_STATE_DELETED)
+                continue;
+
+            info = abrt_p2_entry_get_info(entry,
+                                          elements,
+                                          caller_uid,
+                                          max_size,
+                                          &loaded_size,
+                                          &local_error);
+        }
+
+        /* Entries that do not exist or are not accessible are left out */
+        if (info == NULL)
+        {
+            log_debug("Skipping entry '%s': %s",
+                      entry_path,
+                      local_error ? local_error->message : "unknown error");
+
+            g_clear_error(&local_error);
+            continue;
+        }
+
+        g_variant_builder_add(&builder, "{o@a{sv}}", entry_path, info);
+    }
+
+    if (found_entries != NULL)
+        g_variant_unref(found_entries);
+
+    GVariant *retval_body[1];
+    retval_body[0] = g_variant_builder_end(&builder);
+    return  g_variant_new_tuple(retval_body, ARRAY_SIZE(retval_body));
+}
 
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
                 GVariant *entries,
@@ -2234,6 +2784,23 @@ static void p2_object_dbus_method_call(GDBusConnection *connection,
         g_variant_unref(options_param);
         g_variant_unref(flags_param);
     }
+    else if (strcmp("GetProblemsInfo", method_name) == 0)
+    {
+        GVariant *entries_param = g_variant_get_child_value(parameters, 0);
+        GVariant *elements_param = g_variant_get_child_value(parameters, 1);
+        GVariant *options_param = g_variant_get_child_value(parameters, 2);
+
+        response = abrt_p2_service_get_problems_info(service,
+                                                     caller_uid,
+                                                     entries_param,
+                                                     elements_param,
+                                                     options_param,
+                                                     &error);
+
+        g_variant_unref(options_param);
+        g_variant_unref(elements_param);
+        g_variant_unref(entries_param);
+    }
     else if (strcmp("GetProblemData", method_name) == 0)
     {
         /* Parameter tuple is (0) */
@@ -2284,6 +2851,38 @@ static void abrt_p2_service_private_destroy(AbrtP2ServicePrivate *pv)
         pv->p2srv_connected_users = NULL;
     }
 
+    if (pv->p2srv_entries_by_time != NULL)
+    {
+        g_sequence_free(pv->p2srv_entries_by_time);
+        pv->p2srv_entries_by_time = NULL;
+    }
+
+    if (pv->p2srv_entries_by_count != NULL)
+    {
+        g_sequence_free(pv->p2srv_entries_by_count);
+        pv->p2srv_entries_by_count = NULL;
+    }
+
+    if (pv->p2srv_entry_index_dirty != NULL)
+    {
+        g_hash_table_destroy(pv->p2srv_entry_index_dirty);
+        pv->p2srv_entry_index_dirty = NULL;
+    }
+
+    if (pv->p2srv_entry_index != NULL)
+    {
+        GHashTableIter iter;
+        gpointer obj;
+        struct entry_index_node *node;
+        g_hash_table_iter_init(&iter, pv->p2srv_entry_index);
+        while (g_hash_table_iter_next(&iter, &obj, (gpointer *)&node))
+            g_signal_handler_disconnect(((AbrtP2Object *)obj)->node,
+                                        node->invalidated_handler);
+
+        g_hash_table_destroy(pv->p2srv_entry_index);
+        pv->p2srv_entry_index = NULL;
+    }
+
     problems2_object_type_destroy(&(pv->p2srv_p2_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_session_type));
     problems2_object_type_destroy(&(pv->p2srv_p2_entry_type));
@@ -2401,6 +3000,14 @@ static int abrt_p2_service_private_init(AbrtP2ServicePrivate *pv,
                                                       NULL,
                                                       (GDestroyNotify)user_info_free);
 
+    pv->p2srv_entry_index = g_hash_table_new_full(g_direct_hash,
+                                                  g_direct_equal,
+                                                  NULL,
+                                                  (GDestroyNotify)entry_index_node_free);
+    pv->p2srv_entry_index_dirty = g_hash_table_new(g_direct_hash, g_direct_equal);
+    pv->p2srv_entries_by_time = g_sequence_new(NULL);
+    pv->p2srv_entries_by_count = g_sequence_new(NULL);
+
     if (g_polkit_authority != NULL)
     {
         ++g_polkit_authority_refs;
@@ -2464,6 +3071,20 @@ static void abrt_p2_service_class_init(AbrtP2ServiceClass *klass)
                      G_TYPE_NONE /* return_type */,
                      0     /* n_params */,
                      NULL  /* param_types */);
+
+    /* The parameter is the problem directory */
+    GType problem_modified_params[] = { G_TYPE_STRING };
+    service_signals[SERVICE_SIGNALS_PROBLEM_MODIFIED] =
+        g_signal_newv("problem-modified",
+                     G_TYPE_FROM_CLASS(klass),
+                     G_SIGNAL_RUN_LAST | G_SIGNAL_NO_RECURSE | G_SIGNAL_NO_HOOKS,
+                     NULL /* closure */,
+                     NULL /* accumulator */,
+                     NULL /* accumulator data */,
+                     NULL /* C marshaller */,
+                     G_TYPE_NONE /* return_type */,
+                     1     /* n_params */,
+                     problem_modified_params);
 }
 
 static void abrt_p2_service_init(AbrtP2Service *self)
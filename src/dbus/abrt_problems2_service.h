@@ -149,6 +149,13 @@ GVariant *abrt_p2_service_get_problems(AbrtP2Service *service,
             GVariant *options,
             GError **error);
 
+GVariant *abrt_p2_service_get_problems_info(AbrtP2Service *service,
+            uid_t caller_uid,
+            GVariant *entries,
+            GVariant *elements,
+            GVariant *options,
+            GError **error);
+
 GVariant *abrt_p2_service_delete_problems(AbrtP2Service *service,
             GVariant *entries,
             uid_t caller_uid,
@@ -27,18 +27,18 @@ struct oops_text {
 static
 struct oops_text *parse_file(const char *filename)
 {
-    FILE *fp = fopen(filename, "r");
-    if (!fp)
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
         return NULL;
 
-    char buffer[16 * 1024];
-
+    struct abrt_line_reader *reader = abrt_line_reader_new(fd);
     struct oops_text *ot = NULL;
 
-    if (!fgets(buffer, sizeof(buffer), fp))
+    const char *line = abrt_line_reader_next_str(reader, NULL);
+    if (!line)
         goto ret;
     unsigned n1, n2;
-    int n = sscanf(buffer, "Panic#%u Part%u\n", &n1, &n2);
+    int n = sscanf(line, "Panic#%u Part%u", &n1, &n2);
     if (n != 2)
         goto ret;
 
@@ -47,11 +47,16 @@ struct oops_text *parse_file(const char *filename)
     ot->panic_no = n1;
     ot->part_no = n2;
 
-    size_t sz = fread(buffer, 1, sizeof(buffer), fp);
-    ot->text = strndup(buffer, sz);
+    /* Copy the rest of the record as it is, the parts are merged later */
+    GString *text = g_string_new(NULL);
+    size_t len;
+    while ((line = abrt_line_reader_next(reader, &len)) != NULL)
+        g_string_append_len(text, line, len);
+    ot->text = g_string_free(text, FALSE);
 
  ret:
-    fclose(fp);
+    abrt_line_reader_free(reader);
+    close(fd);
     return ot;
 }
 
@@ -24,6 +24,9 @@
 extern "C" {
 #endif
 
+/* systemd-coredump's zstd compressed core stored as is */
+#define FILENAME_COREDUMP_ZST "coredump.zst"
+
 /* Some libc's forget to declare these, do it ourself */
 extern char **environ;
 #if defined(__GLIBC__) && __GLIBC__ < 2
@@ -43,7 +46,49 @@ void abrt_trim_problem_dirs(const char *dirname, double cap_size, const char *ex
 void abrt_ensure_writable_dir_uid_gid(const char *dir, mode_t mode, uid_t uid, gid_t gid);
 void abrt_ensure_writable_dir(const char *dir, mode_t mode, const char *user);
 void abrt_ensure_writable_dir_group(const char *dir, mode_t mode, const char *user, const char *group);
+/**
+@brief Lists the modules of a coredump in the format of 'eu-unstrip -n'
+
+Reads the modules from the core of the problem directory in-process and
+runs eu-unstrip only if the core can't be parsed.
+
+@return Malloc'ed string, NULL on failure
+*/
 char *abrt_run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec);
+/**
+@brief Lists the modules mapped in a coredump with their build ids
+
+Only the program headers and the notes of the core and the ELF headers of the
+mapped files are read, i.e. a few pages regardless of the size of the core.
+Each line has the format of 'eu-unstrip -n':
+"START+SIZE BUILD_ID@ADDRESS - - NAME", BUILD_ID@ADDRESS is "-" if the module
+does not have a build id.
+
+@return Malloc'ed string, NULL if the file is not a core of the native
+architecture or if the ELF header of a mapped module is missing in the core,
+eu-unstrip reads such modules from the disk
+*/
+char *abrt_core_list_modules(const char *core_path);
+/**
+@brief Returns the path of the uncompressed coredump of a problem directory
+
+If the problem directory holds only FILENAME_COREDUMP_ZST, it is decompressed
+by streaming into a sparse file named FILENAME_COREDUMP in a new directory in
+LARGE_DATA_TMP_DIR. Nested calls for the same problem directory get the same
+file, so a process decompresses the core once. Decompression fails if the core
+is bigger than its frames declare or than MaxCrashReportsSize.
+
+@return Malloc'ed path which must be passed to abrt_coredump_release(), the
+path of FILENAME_COREDUMP in the problem directory if there is no compressed
+core, NULL if the core can't be decompressed
+*/
+char *abrt_coredump_acquire(const char *dump_dir_name);
+/**
+@brief Frees the path returned by abrt_coredump_acquire()
+
+The decompressed core is removed when its last user releases it.
+*/
+void abrt_coredump_release(const char *dump_dir_name, char *core_path);
 char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *debuginfo_dirs);
 
 bool abrt_dir_is_in_dump_location(const char *dir_name);
@@ -64,6 +109,12 @@ extern char *        abrt_g_settings_autoreporting_event;
 extern bool          abrt_g_settings_shortenedreporting;
 extern bool          abrt_g_settings_explorechroots;
 extern unsigned int  abrt_g_settings_debug_level;
+extern unsigned int  abrt_g_settings_server_workers;
+extern unsigned int  abrt_g_settings_server_worker_max_requests;
+extern unsigned int  abrt_g_settings_max_parallel_post_create;
+extern unsigned int  abrt_g_settings_journal_checkpoint_messages;
+extern unsigned int  abrt_g_settings_journal_checkpoint_interval;
+extern unsigned int  abrt_g_settings_symbol_cache_size;
 
 
 int abrt_load_abrt_conf(void);
@@ -102,6 +153,356 @@ wait for the reply
 */
 int abrt_notify_new_path_with_response(const char *path, char **message);
 
+/* abrt.socket protocol version 2
+ *
+ * The client sends ABRT_SOCKET_V2_MAGIC followed by elements and waits for
+ * the same reply as in the text protocol. Every element starts with
+ * struct abrt_socket_v2_element in the host byte order followed by the
+ * element name. DATA elements continue with 'size' bytes of the value. FD
+ * elements have one file descriptor of a regular file (or a memfd) attached
+ * to the header and abrtd reads the value from the file. The request ends
+ * with an END element, so the client does not have to shut the socket down.
+ * The whole request, passed files included, must fit into the request size
+ * limit of abrt-server and arrive within its timeout.
+ */
+#define ABRT_SOCKET_V2_MAGIC "\0ABRTv2\n"
+#define ABRT_SOCKET_V2_MAGIC_LEN 8
+/* Longest element name */
+#define ABRT_SOCKET_V2_NAME_MAX 255
+
+enum abrt_socket_v2_type
+{
+    ABRT_SOCKET_V2_END  = 0,
+    ABRT_SOCKET_V2_DATA = 1,
+    ABRT_SOCKET_V2_FD   = 2,
+};
+
+struct abrt_socket_v2_element
+{
+    uint32_t type;
+    uint32_t name_len;
+    uint64_t size;
+};
+
+/**
+@brief Connects to abrtd and starts a new problem in the protocol version 2
+
+@return Socket for abrt_problem_socket_add_*(), -errno on error
+*/
+int abrt_problem_socket_open(void);
+
+/**
+@brief Sends an element with an inline value, the value may be binary
+@return 0 on success, -errno on error
+*/
+int abrt_problem_socket_add_data(int sockfd, const char *name, const void *data, size_t size);
+
+/**
+@brief Passes a file descriptor of a regular file or a memfd holding the
+value of the element
+
+abrtd reads the whole file from its beginning, the data are not copied
+through the socket. The descriptor can be closed right after the call.
+@return 0 on success, -errno on error
+*/
+int abrt_problem_socket_add_fd(int sockfd, const char *name, int data_fd);
+
+/**
+@brief Finishes the problem, waits for the reply and closes the socket
+
+@param message The abrtd reply, can be NULL
+@return -errno on error otherwise return value of abrtd
+*/
+int abrt_problem_socket_close(int sockfd, char **message);
+
+/* Deduplication index */
+
+/* A problem directory which might be a duplicate of a new problem */
+struct abrt_dedup_entry
+{
+    char *dirname;      /* basename of the problem directory */
+    char *uuid;         /* NULL if unknown */
+    char *duphash;      /* NULL if unknown */
+    char *container_id; /* NULL if not containerized */
+};
+
+/**
+@brief Computes the name of the bucket of problems that can be duplicates
+
+Problems of different users, types or executables are never duplicates.
+*/
+char *abrt_dedup_bucket_name(const char *uid, const char *type, const char *executable);
+
+/**
+@brief Returns true if abrtd has indexed all problem directories
+*/
+bool abrt_dedup_index_is_ready(void);
+
+/**
+@brief Adds the problem directory to the deduplication index
+
+Replaces the entry of an already indexed directory. Directories named
+"*.new" are not complete yet and are never indexed.
+
+@return 0 on success, -EINVAL for unindexable directories, -errno on error
+*/
+int abrt_dedup_index_add(struct dump_dir *dd);
+
+/**
+@brief Removes the problem directory from the deduplication index
+
+Missing entries are silently ignored.
+*/
+void abrt_dedup_index_remove(const char *dump_dir_name);
+
+/**
+@brief Returns the list of indexed problems of the given user, type and executable
+
+Entries of directories which no longer exist are dropped. UUID and DUPHASH
+are NULL (unknown) if they have changed since the directory was indexed. The
+caller must verify the returned directories anyway because they can be
+removed any time.
+
+@return List of struct abrt_dedup_entry, use abrt_dedup_entry_list_free()
+*/
+GList *abrt_dedup_index_lookup(const char *dump_location,
+        const char *uid, const char *type, const char *executable);
+void abrt_dedup_entry_list_free(GList *entries);
+
+/**
+@brief Drops the deduplication index and prepares an empty one
+
+Call abrt_dedup_index_add() for all problem directories and then
+abrt_dedup_index_rebuild_end() to mark the index complete.
+
+@return 0 on success, -errno on error
+*/
+int abrt_dedup_index_rebuild_begin(void);
+void abrt_dedup_index_rebuild_end(void);
+
+/**
+@brief Sizes of all entries of a directory kept in memory
+
+The ledger is used to enforce a size limit on a directory (e.g.
+MaxCrashReportsSize) without walking the whole directory tree every time.
+*/
+struct abrt_size_ledger;
+
+/**
+@brief Creates a ledger of the directory and measures all its entries
+*/
+struct abrt_size_ledger *abrt_size_ledger_new(const char *path);
+void abrt_size_ledger_free(struct abrt_size_ledger *ledger);
+
+/**
+@brief Forgets all entries and measures the directory again
+*/
+void abrt_size_ledger_reset(struct abrt_size_ledger *ledger);
+
+/**
+@brief Measures the entry again or forgets it if it no longer exists
+
+@param name Base name of the entry
+*/
+void abrt_size_ledger_update(struct abrt_size_ledger *ledger, const char *name);
+void abrt_size_ledger_remove(struct abrt_size_ledger *ledger, const char *name);
+
+/**
+@brief Measures again all entries modified since they were last measured
+
+Events run outside of abrtd change sizes of problem directories without
+notice; this costs one lstat per entry.
+*/
+void abrt_size_ledger_refresh(struct abrt_size_ledger *ledger);
+
+const char *abrt_size_ledger_get_path(const struct abrt_size_ledger *ledger);
+double abrt_size_ledger_get_total(const struct abrt_size_ledger *ledger);
+
+/**
+@brief Finds the sub-directory which should be deleted first
+
+Uses the same weight as libreport_get_dirsize_find_largest_dir(), size in
+KiB multiplied by age in minutes.
+
+Directories with the ".new" suffix are still being created and are never
+returned.
+
+@param excluded NULL terminated list of base names which must not be
+returned, can be NULL
+@return Malloc'ed base name or NULL if there is no candidate
+*/
+char *abrt_size_ledger_find_worst_dir(const struct abrt_size_ledger *ledger,
+        const char *const *excluded);
+
+/**
+@brief Returns the directory where gdb caches symbols of files by build-id
+
+@return NULL if the cache is disabled (SymbolCacheSize = 0) or the current
+user can't use it
+*/
+const char *abrt_symbol_cache_dir(void);
+
+/**
+@brief Removes the least recently used files until the size of the cache is
+at most cap_size bytes
+*/
+void abrt_symbol_cache_trim(const char *dirname, off_t cap_size);
+
+/**
+@brief Compiled set of strings searched for in a single pass
+
+Finds any of many fixed strings in a buffer at the cost of one table lookup
+per byte, used to look for kernel oops markers in logs.
+*/
+struct abrt_string_matcher;
+
+/**
+@brief Compiles the patterns
+
+@param patterns Array of count NUL terminated strings, the strings are not
+referenced after the function returns
+*/
+struct abrt_string_matcher *abrt_string_matcher_new(const char *const *patterns, size_t count);
+struct abrt_string_matcher *abrt_string_matcher_new_from_list(GList *patterns);
+void abrt_string_matcher_free(struct abrt_string_matcher *matcher);
+
+/**
+@brief Searches the buffer for any of the patterns
+
+@return Index of the pattern which was found first, i.e. whose occurrence ends
+at the lowest position, or -1 if none of the patterns occurs in the buffer
+*/
+int abrt_string_matcher_find(const struct abrt_string_matcher *matcher,
+        const char *buf, size_t size);
+/**
+@brief The same as abrt_string_matcher_find() for a NUL terminated string
+*/
+int abrt_string_matcher_find_str(const struct abrt_string_matcher *matcher, const char *str);
+
+/**
+@brief Reads a log file line by line without allocating memory for each line
+
+The file is read into a buffer from its current position; a regular file is
+read only up to its size at the time the reader is created. If the file is
+truncated while it is being read, the reading ends before the missing data.
+*/
+struct abrt_line_reader;
+
+/**
+@param fd The reader does not take ownership of fd
+*/
+struct abrt_line_reader *abrt_line_reader_new(int fd);
+/**
+@brief Moves the file position right after the last returned line
+*/
+void abrt_line_reader_free(struct abrt_line_reader *reader);
+/**
+@brief Returns the next line including its terminating '\n', if any
+
+The line is not NUL terminated and it is valid until the next call.
+
+@return NULL at the end of the file
+*/
+const char *abrt_line_reader_next(struct abrt_line_reader *reader, size_t *len);
+/**
+@brief Returns the next line without '\n' as a NUL terminated string
+
+The string may be modified and it is valid until the next call.
+
+@param len Where to store the length of the string, may be NULL
+@return NULL at the end of the file
+*/
+char *abrt_line_reader_next_str(struct abrt_line_reader *reader, size_t *len);
+
+/**
+@brief Replaces the file with data atomically and durably
+
+The data is written to FILE_NAME.tmp which is synced and renamed over the
+file, then the directory is synced too. After a crash, the file holds either
+the old or the new data.
+
+@return 0 on success, -1 on error (the error is logged)
+*/
+int abrt_save_state_file(const char *file_name, const char *data, mode_t mode);
+
+/* Maximum number of file descriptors passed in one message */
+#define ABRT_PASS_FD_MAX 16
+
+/**
+@brief Sends data together with file descriptors over a UNIX domain socket
+
+@param sockfd Connected AF_UNIX socket
+@param buf Data to send, must not be empty
+@param len Length of the data
+@param fds File descriptors to pass (SCM_RIGHTS)
+@param fds_count Number of the descriptors, at most ABRT_PASS_FD_MAX
+@return 0 on success, -errno on error
+*/
+int abrt_send_fds(int sockfd, const void *buf, size_t len, const int *fds, unsigned fds_count);
+
+/**
+@brief Receives data and file descriptors sent by abrt_send_fds()
+
+The received descriptors have FD_CLOEXEC set.
+
+@param sockfd Connected AF_UNIX socket
+@param buf Buffer for the data
+@param len Size of the buffer
+@param fds Array for the received descriptors
+@param fds_count In: size of the array, out: number of received descriptors
+@return Number of received bytes, 0 on EOF, -errno on error
+*/
+ssize_t abrt_recv_fds(int sockfd, void *buf, size_t len, int *fds, unsigned *fds_count);
+
+/**
+@brief Crash context read from /proc/[pid] of a crashed process
+
+All files are read at once while the process may still exist, the snapshot
+is saved to the problem directory later. Missing items are NULL.
+*/
+struct abrt_proc_snapshot
+{
+    pid_t pid;
+    char *cmdline;
+    char *environ;
+    char *cgroup;
+    char *mountinfo;
+    char *open_fds;
+    /* The namespaces compared with the init's ones */
+    char *namespaces;
+    /* Set only if the process' root differs from the init's root */
+    char *rootdir;
+    /* Set only for a process with its own root '/' (a container) */
+    char *container_cmdline;
+};
+
+/**
+@brief Reads the crash context of the process
+
+/proc/[pid] is opened once, /proc/1 once per process.
+@return NULL if /proc/[pid] can't be opened
+*/
+struct abrt_proc_snapshot *abrt_proc_snapshot_new(pid_t pid);
+/**
+@brief Saves all items of the snapshot to the problem directory
+*/
+void abrt_proc_snapshot_save(const struct abrt_proc_snapshot *snapshot, struct dump_dir *dd);
+void abrt_proc_snapshot_free(struct abrt_proc_snapshot *snapshot);
+
+/**
+@brief Compiled patterns used to parse kernel oopses
+
+Create the parser once and pass it to all the calls in order to avoid
+compiling the patterns again. The functions without the parser argument
+use a parser shared by the whole process.
+*/
+struct abrt_koops_parser;
+
+struct abrt_koops_parser *abrt_koops_parser_new(void);
+void abrt_koops_parser_free(struct abrt_koops_parser *parser);
+
+char *abrt_koops_parser_extract_version(const struct abrt_koops_parser *parser, const char *line);
+
 /* Note: should be public since unit tests need to call it */
 char *abrt_koops_extract_version(const char *line);
 char *abrt_kernel_tainted_short(const char *kernel_bt);
@@ -121,8 +522,73 @@ struct abrt_koops_line_info {
     int level;
 };
 
+void abrt_koops_parser_extract_oopses_from_lines(const struct abrt_koops_parser *parser, GList **oops_list,
+        const struct abrt_koops_line_info *lines_info, int lines_info_size);
 void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size);
+void abrt_koops_parser_extract_oopses(const struct abrt_koops_parser *parser, GList **oops_list,
+        char *buffer, size_t buflen);
 void abrt_koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen);
+
+/**
+@brief Extracts oopses from a log read in chunks of any size
+
+The extractor keeps the state of the oops in progress across the chunks and
+appends every oops to the list as soon as its end is found. Only the lines
+which may still become a part of an oops are kept in memory.
+
+Seeing ABRT's "kernel oopses to Abrt" marker in a syslog file drops all
+oopses found so far, including the ones already appended to the list.
+*/
+struct abrt_koops_extractor;
+
+/**
+@param parser Must not be freed before the extractor
+*/
+struct abrt_koops_extractor *abrt_koops_extractor_new(const struct abrt_koops_parser *parser);
+void abrt_koops_extractor_free(struct abrt_koops_extractor *extractor);
+
+/**
+@brief Analyzes the data, an incomplete last line is kept for the next call
+*/
+void abrt_koops_extractor_feed(struct abrt_koops_extractor *extractor, GList **oops_list,
+        const char *data, size_t size);
+/**
+@brief Analyzes a single raw log line, e.g. a slice from abrt_line_reader_next()
+
+The line does not have to be terminated and the trailing \n is optional.
+Equivalent to feeding the line followed by \n.
+*/
+void abrt_koops_extractor_feed_log_line(struct abrt_koops_extractor *extractor, GList **oops_list,
+        const char *line, size_t len);
+/**
+@brief Analyzes a single line which has already been split from its log level
+
+Useful for sources which deliver the level separately, e.g. /dev/kmsg
+records. The line is copied and it must not contain the jiffies.
+*/
+void abrt_koops_extractor_feed_line(struct abrt_koops_extractor *extractor, GList **oops_list,
+        int level, const char *line);
+/**
+@brief Checks whether all fed lines have been analyzed and none of them
+belongs to an oops which has not been appended to the list yet
+
+Nothing is lost if the reader forgets the lines fed so far.
+*/
+bool abrt_koops_extractor_is_idle(const struct abrt_koops_extractor *extractor);
+/**
+@brief Checks whether the extractor keeps an incomplete last line fed by
+abrt_koops_extractor_feed()
+
+A writer may still be in the middle of the line, so the reader should not
+finish the extraction yet.
+*/
+bool abrt_koops_extractor_has_partial_line(const struct abrt_koops_extractor *extractor);
+/**
+@brief Analyzes the rest of the data as if the log ended here
+
+The extractor can be fed with a new log afterwards.
+*/
+void abrt_koops_extractor_finish(struct abrt_koops_extractor *extractor, GList **oops_list);
 GList *abrt_koops_suspicious_strings_list(void);
 GList *abrt_koops_suspicious_strings_blacklist(void);
 void abrt_koops_print_suspicious_strings(void);
@@ -29,6 +29,12 @@ char *        abrt_g_settings_autoreporting_event = NULL;
 bool          abrt_g_settings_shortenedreporting = 0;
 bool          abrt_g_settings_explorechroots = 0;
 unsigned int  abrt_g_settings_debug_level = 0;
+unsigned int  abrt_g_settings_server_workers = 0;
+unsigned int  abrt_g_settings_server_worker_max_requests = 100;
+unsigned int  abrt_g_settings_max_parallel_post_create = 0;
+unsigned int  abrt_g_settings_journal_checkpoint_messages = 100;
+unsigned int  abrt_g_settings_journal_checkpoint_interval = 5000;
+unsigned int  abrt_g_settings_symbol_cache_size = 1024;
 
 void abrt_free_abrt_conf_data()
 {
@@ -65,6 +71,33 @@ static char *xstrdup_normalized_path(const char *path)
     return res;
 }
 
+/* Parses an unsigned number option and removes it from the table. If the
+ * option is missing, the default value is used.
+ */
+static void parse_unsigned_option(GHashTable *settings, const char *name,
+        unsigned int *result, unsigned int default_value)
+{
+    const char *value = g_hash_table_lookup(settings, name);
+    if (!value)
+    {
+        *result = default_value;
+        return;
+    }
+
+    char *end;
+    errno = 0;
+    unsigned long ul = strtoul(value, &end, 10);
+    if (errno || end == value || *end != '\0' || ul > INT_MAX)
+    {
+        error_msg("Error parsing %s setting: '%s'", name, value);
+        *result = default_value;
+    }
+    else
+        *result = ul;
+
+    g_hash_table_remove(settings, name);
+}
+
 static void ParseCommon(GHashTable *settings, const char *conf_filename)
 {
     gpointer value;
@@ -156,6 +189,19 @@ static void ParseCommon(GHashTable *settings, const char *conf_filename)
         g_hash_table_remove(settings, "DebugLevel");
     }
 
+    parse_unsigned_option(settings, "ServerWorkers",
+            &abrt_g_settings_server_workers, 0);
+    parse_unsigned_option(settings, "ServerWorkerMaxRequests",
+            &abrt_g_settings_server_worker_max_requests, 100);
+    parse_unsigned_option(settings, "MaxParallelPostCreate",
+            &abrt_g_settings_max_parallel_post_create, 0);
+    parse_unsigned_option(settings, "JournalCheckpointMessages",
+            &abrt_g_settings_journal_checkpoint_messages, 100);
+    parse_unsigned_option(settings, "JournalCheckpointInterval",
+            &abrt_g_settings_journal_checkpoint_interval, 5000);
+    parse_unsigned_option(settings, "SymbolCacheSize",
+            &abrt_g_settings_symbol_cache_size, 1024);
+
     GHashTableIter iter;
     gpointer name;
     g_hash_table_iter_init(&iter, settings);
@@ -0,0 +1,477 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <elf.h>
+#include <link.h>
+#include "libabrt.h"
+
+/* Only cores of the native class and byte order are parsed, the others
+ * are left to eu-unstrip */
+#if __BYTE_ORDER == __LITTLE_ENDIAN
+# define CORE_ELFDATA ELFDATA2LSB
+#else
+# define CORE_ELFDATA ELFDATA2MSB
+#endif
+
+#if __ELF_NATIVE_CLASS == 64
+# define CORE_ELFCLASS ELFCLASS64
+#else
+# define CORE_ELFCLASS ELFCLASS32
+#endif
+
+#define NOTE_ALIGN(size) (((size) + 3) & ~(size_t)3)
+
+/* Nothing is aligned in a corrupted core */
+#define IS_ALIGNED(ptr, type) (((uintptr_t)(ptr) % _Alignof(type)) == 0)
+
+/* The core is mapped as a whole, but only the program headers, the notes
+ * and the pages with the ELF headers of the modules are touched; the holes
+ * of a sparse core are never read */
+struct core
+{
+    const char *data;
+    size_t size;
+
+    const ElfW(Phdr) *phdrs;
+    size_t phnum;
+
+    /* PT_LOAD segments sorted by address, there may be tens of thousands
+     * of them */
+    const ElfW(Phdr) **loads;
+    size_t loads_count;
+};
+
+struct core_module
+{
+    ElfW(Addr) start;
+    ElfW(Addr) end;
+    const char *name;
+    /* Hex encoded, NULL if the module does not have any */
+    char *build_id;
+    ElfW(Addr) build_id_addr;
+};
+
+/* Returns the memory of the crashed process at addr if it is in the core */
+static const void *core_memory(const struct core *core, ElfW(Addr) addr, size_t size)
+{
+    /* The last segment starting at or below addr */
+    size_t low = 0;
+    size_t high = core->loads_count;
+    while (low < high)
+    {
+        const size_t middle = low + (high - low) / 2;
+        if (core->loads[middle]->p_vaddr <= addr)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low == 0)
+        return NULL;
+
+    const ElfW(Phdr) *phdr = core->loads[low - 1];
+    if (addr - phdr->p_vaddr > phdr->p_filesz
+     || size > phdr->p_filesz - (addr - phdr->p_vaddr))
+    {
+        return NULL;
+    }
+
+    const ElfW(Off) offset = phdr->p_offset + (addr - phdr->p_vaddr);
+    /* Truncated cores are common */
+    if (offset > core->size || size > core->size - offset)
+        return NULL;
+
+    return core->data + offset;
+}
+
+static int load_cmp(const void *a, const void *b)
+{
+    const ElfW(Phdr) *const pa = *(const ElfW(Phdr) *const *)a;
+    const ElfW(Phdr) *const pb = *(const ElfW(Phdr) *const *)b;
+
+    if (pa->p_vaddr != pb->p_vaddr)
+        return pa->p_vaddr < pb->p_vaddr ? -1 : 1;
+    return 0;
+}
+
+static const void *core_file_data(const struct core *core, ElfW(Off) offset, size_t size)
+{
+    if (offset > core->size || size > core->size - offset)
+        return NULL;
+
+    return core->data + offset;
+}
+
+/*
+ * Calls the callback for every note in [notes, notes + size), stops when the
+ * callback returns true.
+ */
+static bool foreach_note(const char *notes, size_t size,
+        bool (*callback)(const ElfW(Nhdr) *nhdr, const char *name, const char *desc, void *param),
+        void *param)
+{
+    size_t pos = 0;
+    while (size - pos >= sizeof(ElfW(Nhdr)))
+    {
+        const ElfW(Nhdr) *nhdr = (const ElfW(Nhdr) *)(notes + pos);
+        pos += sizeof(*nhdr);
+
+        const size_t namesz = NOTE_ALIGN(nhdr->n_namesz);
+        const size_t descsz = NOTE_ALIGN(nhdr->n_descsz);
+        if (namesz > size - pos || descsz > size - pos - namesz)
+            break;
+
+        const char *name = notes + pos;
+        const char *desc = name + namesz;
+        pos += namesz + descsz;
+
+        if (callback(nhdr, name, desc, param))
+            return true;
+    }
+
+    return false;
+}
+
+static bool find_build_id(const ElfW(Nhdr) *nhdr, const char *name, const char *desc, void *param)
+{
+    if (nhdr->n_type != NT_GNU_BUILD_ID
+     || nhdr->n_namesz != sizeof(ELF_NOTE_GNU)
+     || memcmp(name, ELF_NOTE_GNU, sizeof(ELF_NOTE_GNU)) != 0
+     || nhdr->n_descsz == 0)
+    {
+        return false;
+    }
+
+    *(const ElfW(Nhdr) **)param = nhdr;
+    return true;
+}
+
+/*
+ * Fills the address range and the build id of the module whose ELF header
+ * is mapped at start. Returns false if there is no ELF header.
+ */
+static bool read_module(const struct core *core, ElfW(Addr) start, ElfW(Addr) page_size,
+        struct core_module *module)
+{
+    const ElfW(Ehdr) *ehdr = core_memory(core, start, sizeof(*ehdr));
+    if (ehdr == NULL
+     || !IS_ALIGNED(ehdr, ElfW(Ehdr))
+     || memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0
+     || ehdr->e_ident[EI_CLASS] != CORE_ELFCLASS
+     || ehdr->e_ident[EI_DATA] != CORE_ELFDATA
+     || ehdr->e_phentsize != sizeof(ElfW(Phdr)))
+    {
+        return false;
+    }
+
+    const ElfW(Phdr) *phdrs = core_memory(core, start + ehdr->e_phoff, ehdr->e_phnum * sizeof(ElfW(Phdr)));
+    if (phdrs == NULL || !IS_ALIGNED(phdrs, ElfW(Phdr)))
+        return false;
+
+    /* The same as libdwfl does: the range spans all loadable segments
+     * aligned to pages and the bias is given by the first one */
+    bool have_load = false;
+    ElfW(Addr) bias = 0;
+    for (ElfW(Half) i = 0; i < ehdr->e_phnum; ++i)
+    {
+        if (phdrs[i].p_type != PT_LOAD)
+            continue;
+
+        if (!have_load)
+        {
+            bias = start - (phdrs[i].p_vaddr & -page_size);
+            have_load = true;
+        }
+
+        const ElfW(Addr) end = bias + ((phdrs[i].p_vaddr + phdrs[i].p_memsz + page_size - 1) & -page_size);
+        if (end > module->end)
+            module->end = end;
+    }
+
+    if (!have_load)
+        return false;
+
+    module->start = start;
+
+    for (ElfW(Half) i = 0; i < ehdr->e_phnum && module->build_id == NULL; ++i)
+    {
+        if (phdrs[i].p_type != PT_NOTE)
+            continue;
+
+        /* Usually on the first page, which is dumped with the ELF header */
+        const char *notes = core_memory(core, bias + phdrs[i].p_vaddr, phdrs[i].p_filesz);
+        const ElfW(Nhdr) *nhdr = NULL;
+        if (notes == NULL || !IS_ALIGNED(notes, ElfW(Nhdr))
+         || !foreach_note(notes, phdrs[i].p_filesz, find_build_id, &nhdr))
+            continue;
+
+        const unsigned char *desc = (const unsigned char *)nhdr + sizeof(*nhdr) + NOTE_ALIGN(nhdr->n_namesz);
+        module->build_id = g_malloc(nhdr->n_descsz * 2 + 1);
+        for (ElfW(Word) j = 0; j < nhdr->n_descsz; ++j)
+            sprintf(module->build_id + j * 2, "%02x", desc[j]);
+        module->build_id_addr = bias + phdrs[i].p_vaddr + ((const char *)desc - notes);
+    }
+
+    return true;
+}
+
+/*
+ * Whether the file mapped at start is an ELF object whose header is not in
+ * the core. eu-unstrip finds such modules in the link map of the process and
+ * reads them from the disk.
+ */
+static bool is_missing_module(const struct core *core, ElfW(Addr) start, const char *file_name)
+{
+    if (core_memory(core, start, sizeof(ElfW(Ehdr))) != NULL)
+        return false;
+
+    /* Never open devices */
+    struct stat statbuf;
+    if (stat(file_name, &statbuf) != 0 || !S_ISREG(statbuf.st_mode))
+        return false;
+
+    const int fd = open(file_name, O_RDONLY | O_CLOEXEC | O_NOCTTY);
+    if (fd < 0)
+        return false;
+
+    char magic[SELFMAG];
+    const bool elf = read(fd, magic, SELFMAG) == SELFMAG && memcmp(magic, ELFMAG, SELFMAG) == 0;
+    close(fd);
+
+    return elf;
+}
+
+struct core_notes
+{
+    const struct core *core;
+    GArray *modules;
+    ElfW(Addr) page_size;
+    ElfW(Addr) vdso;
+    /* A module can't be listed from the core alone */
+    bool missing_module;
+};
+
+/* Notes are aligned only to 4 bytes */
+static ElfW(Addr) note_word(const char *desc, size_t index)
+{
+    ElfW(Addr) word;
+    memcpy(&word, desc + index * sizeof(word), sizeof(word));
+    return word;
+}
+
+static bool add_modules(const ElfW(Nhdr) *nhdr, const char *name, const char *desc, void *param)
+{
+    struct core_notes *notes = param;
+
+    if (nhdr->n_type == NT_AUXV)
+    {
+        /* {long type, value}[] */
+        for (size_t i = 0; i + 1 < nhdr->n_descsz / sizeof(ElfW(Addr)); i += 2)
+        {
+            if (note_word(desc, i) == AT_SYSINFO_EHDR)
+                notes->vdso = note_word(desc, i + 1);
+        }
+        return false;
+    }
+
+    if (nhdr->n_type != NT_FILE)
+        return false;
+
+    /* long count; long page_size; {long start, end, pgoff}[count]; names */
+    const size_t words = nhdr->n_descsz / sizeof(ElfW(Addr));
+    if (words < 2)
+        return false;
+
+    const ElfW(Addr) count = note_word(desc, 0);
+    if (note_word(desc, 1) != 0)
+        notes->page_size = note_word(desc, 1);
+    if (count > (words - 2) / 3)
+        return false;
+
+    const char *file_name = desc + (2 + 3 * count) * sizeof(ElfW(Addr));
+    const char *const end = desc + nhdr->n_descsz;
+    for (ElfW(Addr) i = 0; i < count && file_name < end; ++i)
+    {
+        const char *const next_name = memchr(file_name, '\0', end - file_name);
+        if (next_name == NULL)
+            break;
+
+        /* The ELF header is at the beginning of the file */
+        const size_t mapping = 2 + 3 * i;
+        if (note_word(desc, mapping + 2) == 0)
+        {
+            const ElfW(Addr) start = note_word(desc, mapping);
+            struct core_module module = { .name = file_name };
+            if (read_module(notes->core, start, notes->page_size, &module))
+                g_array_append_val(notes->modules, module);
+            else if (is_missing_module(notes->core, start, file_name))
+            {
+                log_info("ELF header of '%s' is not in the core", file_name);
+                notes->missing_module = true;
+                return true;
+            }
+        }
+
+        file_name = next_name + 1;
+    }
+
+    return false;
+}
+
+static int core_module_cmp(const void *a, const void *b)
+{
+    const struct core_module *const ma = a;
+    const struct core_module *const mb = b;
+
+    if (ma->start != mb->start)
+        return ma->start < mb->start ? -1 : 1;
+    return 0;
+}
+
+char *abrt_core_list_modules(const char *core_path)
+{
+    const int fd = open(core_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        perror_msg("Can't open '%s'", core_path);
+        return NULL;
+    }
+
+    struct stat statbuf;
+    if (fstat(fd, &statbuf) != 0 || !S_ISREG(statbuf.st_mode) || statbuf.st_size < sizeof(ElfW(Ehdr)))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    struct core core = { .size = statbuf.st_size };
+    void *const map = mmap(NULL, core.size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        perror_msg("Can't map '%s'", core_path);
+        return NULL;
+    }
+    /* Only a few pages scattered over the file are read */
+    madvise(map, core.size, MADV_RANDOM);
+    core.data = map;
+
+    GString *result = NULL;
+    struct core_notes notes = {
+        .core = &core,
+        .modules = g_array_new(FALSE, FALSE, sizeof(struct core_module)),
+        .page_size = sysconf(_SC_PAGE_SIZE),
+    };
+
+    const ElfW(Ehdr) *ehdr = core_file_data(&core, 0, sizeof(*ehdr));
+    if (memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0
+     || ehdr->e_ident[EI_CLASS] != CORE_ELFCLASS
+     || ehdr->e_ident[EI_DATA] != CORE_ELFDATA
+     || ehdr->e_type != ET_CORE
+     || ehdr->e_phentsize != sizeof(ElfW(Phdr)))
+    {
+        log_info("'%s' is not a core of this architecture", core_path);
+        goto out;
+    }
+
+    core.phnum = ehdr->e_phnum;
+    if (core.phnum == PN_XNUM)
+    {
+        /* Processes with a lot of mappings, the real number is stored in
+         * the first section header */
+        const ElfW(Shdr) *shdr = core_file_data(&core, ehdr->e_shoff, sizeof(*shdr));
+        if (shdr == NULL || !IS_ALIGNED(shdr, ElfW(Shdr)))
+        {
+            log_info("Can't read the number of program headers of '%s'", core_path);
+            goto out;
+        }
+        core.phnum = shdr->sh_info;
+    }
+    core.phdrs = core_file_data(&core, ehdr->e_phoff, core.phnum * sizeof(ElfW(Phdr)));
+    if (core.phdrs == NULL || !IS_ALIGNED(core.phdrs, ElfW(Phdr)))
+    {
+        log_info("Can't read program headers of '%s'", core_path);
+        goto out;
+    }
+
+    core.loads = g_new(const ElfW(Phdr) *, core.phnum);
+    for (size_t i = 0; i < core.phnum; ++i)
+    {
+        if (core.phdrs[i].p_type == PT_LOAD)
+            core.loads[core.loads_count++] = &core.phdrs[i];
+    }
+    /* The kernel writes them sorted, but be safe */
+    if (core.loads_count > 1)
+        qsort(core.loads, core.loads_count, sizeof(*core.loads), load_cmp);
+
+    bool have_notes = false;
+    for (size_t i = 0; i < core.phnum; ++i)
+    {
+        if (core.phdrs[i].p_type != PT_NOTE)
+            continue;
+
+        const char *data = core_file_data(&core, core.phdrs[i].p_offset, core.phdrs[i].p_filesz);
+        if (data == NULL || !IS_ALIGNED(data, ElfW(Nhdr)))
+            continue;
+
+        foreach_note(data, core.phdrs[i].p_filesz, add_modules, &notes);
+        have_notes = true;
+    }
+
+    if (!have_notes)
+    {
+        log_info("'%s' does not contain any notes", core_path);
+        goto out;
+    }
+
+    /* Leave it to eu-unstrip, the list must not differ */
+    if (notes.missing_module)
+        goto out;
+
+    if (notes.vdso != 0)
+    {
+        struct core_module module = { .name = "[vdso]" };
+        if (read_module(&core, notes.vdso, notes.page_size, &module))
+            g_array_append_val(notes.modules, module);
+    }
+
+    /* eu-unstrip lists the modules by their addresses */
+    g_array_sort(notes.modules, core_module_cmp);
+
+    result = g_string_new(NULL);
+    for (guint i = 0; i < notes.modules->len; ++i)
+    {
+        const struct core_module *module = &g_array_index(notes.modules, struct core_module, i);
+        g_string_append_printf(result, "%#llx+%#llx ",
+                (unsigned long long)module->start,
+                (unsigned long long)(module->end - module->start));
+        if (module->build_id != NULL)
+            g_string_append_printf(result, "%s@%#llx", module->build_id,
+                    (unsigned long long)module->build_id_addr);
+        else
+            g_string_append_c(result, '-');
+        g_string_append_printf(result, " - - %s\n", module->name);
+    }
+
+ out:
+    for (guint i = 0; i < notes.modules->len; ++i)
+        free(g_array_index(notes.modules, struct core_module, i).build_id);
+    g_array_free(notes.modules, TRUE);
+    free(core.loads);
+    munmap(map, core.size);
+
+    return result ? g_string_free(result, FALSE) : NULL;
+}
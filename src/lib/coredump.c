@@ -0,0 +1,280 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <zstd.h>
+#include "libabrt.h"
+
+/* Zero blocks of this size are skipped, so that the unpacked core is sparse
+ * like the one written by the kernel */
+#define COREDUMP_HOLE_BLOCK 4096
+
+/*
+ * The coredump unpacked by the outermost abrt_coredump_acquire() of
+ * a process. The nested users get the same file, so that an analyzer which
+ * runs gdb and then lists the modules decompresses the core only once.
+ */
+static struct
+{
+    char *dump_dir_name;
+    char *path;
+    unsigned users;
+} unpacked;
+
+/*
+ * Writes the zero blocks of buf as holes. The caller must extend the file
+ * to its final size, a hole at the end is not allocated by lseek().
+ */
+static int write_sparse(int fd, const char *buf, size_t len)
+{
+    const char *data = buf;
+    const char *const end = buf + len;
+    while (buf < end)
+    {
+        const size_t block = MIN((size_t)(end - buf), COREDUMP_HOLE_BLOCK);
+        if (buf[0] != '\0' || memcmp(buf, buf + 1, block - 1) != 0)
+        {
+            buf += block;
+            continue;
+        }
+
+        if (data != buf && libreport_full_write(fd, data, buf - data) != buf - data)
+            return -1;
+        if (lseek(fd, block, SEEK_CUR) < 0)
+            return -1;
+        buf += block;
+        data = buf;
+    }
+
+    if (data != end && libreport_full_write(fd, data, end - data) != end - data)
+        return -1;
+    return 0;
+}
+
+/*
+ * Decompresses the zstd frames of fdi to fdo by streaming, only a couple of
+ * blocks are held in memory regardless of the size of the core. A frame may
+ * not unpack to more than its header declares and the whole core to more
+ * than MaxCrashReportsSize, the dump location can't hold a bigger one anyway.
+ */
+static int unpack_zstd(int fdi, int fdo)
+{
+    ZSTD_DStream *const stream = ZSTD_createDStream();
+    if (stream == NULL)
+    {
+        error_msg("Can't create zstd stream");
+        return -1;
+    }
+
+    const size_t in_size = ZSTD_DStreamInSize();
+    const size_t out_size = ZSTD_DStreamOutSize();
+    g_autofree char *in_buf = g_malloc(in_size);
+    g_autofree char *out_buf = g_malloc(out_size);
+
+    int ret = -1;
+    off_t total = 0;
+    const uint64_t max_total = abrt_g_settings_nMaxCrashReportsSize > 0
+                             ? abrt_g_settings_nMaxCrashReportsSize * (uint64_t)(1024 * 1024)
+                             : UINT64_MAX;
+    uint64_t limit = max_total;
+    /* 0 means that the last frame is complete */
+    size_t hint = 0;
+    for (;;)
+    {
+        const ssize_t r = libreport_safe_read(fdi, in_buf, in_size);
+        if (r < 0)
+        {
+            perror_msg("Can't read compressed coredump");
+            goto finish;
+        }
+        if (r == 0)
+            break;
+
+        ZSTD_inBuffer in = { in_buf, r, 0 };
+        ZSTD_outBuffer out;
+        do
+        {
+            if (hint == 0)
+            {
+                /* A new frame starts, its size is unknown if the compressor
+                 * streamed it or if the header is split between reads */
+                const unsigned long long content_size =
+                        ZSTD_getFrameContentSize(in_buf + in.pos, in.size - in.pos);
+                limit = max_total;
+                if (content_size < ZSTD_CONTENTSIZE_ERROR && content_size < max_total - total)
+                    limit = total + content_size;
+            }
+
+            out = (ZSTD_outBuffer){ out_buf, out_size, 0 };
+            hint = ZSTD_decompressStream(stream, &out, &in);
+            if (ZSTD_isError(hint))
+            {
+                error_msg("Can't decompress coredump: %s", ZSTD_getErrorName(hint));
+                goto finish;
+            }
+
+            if (out.pos > limit - total)
+            {
+                error_msg("Unpacked coredump is bigger than %llu bytes, aborting",
+                          (unsigned long long)limit);
+                goto finish;
+            }
+
+            if (write_sparse(fdo, out_buf, out.pos) != 0)
+            {
+                perror_msg("Can't write unpacked coredump");
+                goto finish;
+            }
+            total += out.pos;
+        }
+        /* The decoder may hold more data if the buffer is full, unless the
+         * frame is complete. Another call would start a new frame. */
+        while (in.pos < in.size || (out.pos == out.size && hint != 0));
+    }
+
+    if (hint != 0)
+    {
+        error_msg("Compressed coredump is truncated");
+        goto finish;
+    }
+
+    if (ftruncate(fdo, total) != 0)
+    {
+        perror_msg("Can't write unpacked coredump");
+        goto finish;
+    }
+
+    ret = 0;
+finish:
+    ZSTD_freeDStream(stream);
+    return ret;
+}
+
+/*
+ * Returns the malloc'ed path of a new file in a new private directory
+ * in LARGE_DATA_TMP_DIR, the core must be named FILENAME_COREDUMP for the
+ * retrace archive.
+ */
+static char *unpack_coredump(const char *zst_path)
+{
+    const int fdi = open(zst_path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+    if (fdi < 0)
+    {
+        perror_msg("Can't open '%s'", zst_path);
+        return NULL;
+    }
+
+    char *tmp_dir = g_strdup(LARGE_DATA_TMP_DIR"/abrt-coredump-XXXXXX");
+    if (mkdtemp(tmp_dir) == NULL)
+    {
+        perror_msg("Can't create temporary directory in '%s'", LARGE_DATA_TMP_DIR);
+        close(fdi);
+        free(tmp_dir);
+        return NULL;
+    }
+
+    char *core_path = g_build_filename(tmp_dir, FILENAME_COREDUMP, NULL);
+    const int fdo = open(core_path, O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+    int r = -1;
+    if (fdo < 0)
+        perror_msg("Can't create '%s'", core_path);
+    else
+    {
+        log_info("Unpacking '%s' to '%s'", zst_path, core_path);
+        r = unpack_zstd(fdi, fdo);
+        close(fdo);
+    }
+    close(fdi);
+
+    if (r != 0)
+    {
+        unlink(core_path);
+        rmdir(tmp_dir);
+        free(core_path);
+        core_path = NULL;
+    }
+
+    free(tmp_dir);
+    return core_path;
+}
+
+char *abrt_coredump_acquire(const char *dump_dir_name)
+{
+    char *core_path = g_build_filename(dump_dir_name, FILENAME_COREDUMP, NULL);
+    struct stat statbuf;
+    if (lstat(core_path, &statbuf) == 0)
+        return core_path;
+
+    g_autofree char *zst_path = g_build_filename(dump_dir_name, FILENAME_COREDUMP_ZST, NULL);
+    if (lstat(zst_path, &statbuf) != 0)
+        /* Let the caller fail on the missing file */
+        return core_path;
+    free(core_path);
+
+    if (unpacked.users != 0)
+    {
+        if (strcmp(unpacked.dump_dir_name, dump_dir_name) == 0)
+        {
+            ++unpacked.users;
+            return g_strdup(unpacked.path);
+        }
+
+        /* Not shared, the outer user owns the cached one */
+        return unpack_coredump(zst_path);
+    }
+
+    core_path = unpack_coredump(zst_path);
+    if (core_path != NULL)
+    {
+        unpacked.dump_dir_name = g_strdup(dump_dir_name);
+        unpacked.path = g_strdup(core_path);
+        unpacked.users = 1;
+    }
+
+    return core_path;
+}
+
+static void remove_unpacked(const char *core_path)
+{
+    if (unlink(core_path) != 0)
+        perror_msg("Can't remove '%s'", core_path);
+
+    g_autofree char *tmp_dir = g_path_get_dirname(core_path);
+    if (rmdir(tmp_dir) != 0)
+        perror_msg("Can't remove '%s'", tmp_dir);
+}
+
+void abrt_coredump_release(const char *dump_dir_name, char *core_path)
+{
+    if (core_path == NULL)
+        return;
+
+    /* The core stored uncompressed in the problem directory is left alone */
+    g_autofree char *stored_path = g_build_filename(dump_dir_name, FILENAME_COREDUMP, NULL);
+    if (strcmp(core_path, stored_path) != 0)
+    {
+        if (unpacked.users == 0 || strcmp(core_path, unpacked.path) != 0)
+            remove_unpacked(core_path);
+        else if (--unpacked.users == 0)
+        {
+            remove_unpacked(unpacked.path);
+            g_clear_pointer(&unpacked.dump_dir_name, free);
+            g_clear_pointer(&unpacked.path, free);
+        }
+    }
+
+    free(core_path);
+}
@@ -0,0 +1,327 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/*
+ * The deduplication index groups problem directories into buckets of
+ * problems which can be duplicates of each other. Only problems of the same
+ * user, type and executable can be duplicates.
+ *
+ * Layout:
+ *   DEDUP_INDEX_DIR/buckets/<bucket>/<problem dir basename>
+ *       Three lines: UUID, DUPHASH and CONTAINER_ID (empty if missing).
+ *   DEDUP_INDEX_DIR/dirs/<problem dir basename> -> <bucket>
+ *       Symbolic link used to find the bucket of a removed directory.
+ *   DEDUP_INDEX_DIR/ready
+ *       Exists if the index covers all problem directories.
+ *
+ * The index lives in a tmpfs and abrtd rebuilds it on start-up. All updates
+ * are single atomic file operations, so readers never see partially written
+ * entries. Problem directories can be removed without updating the index,
+ * hence stale entries are expected and readers must verify the candidates.
+ */
+#define DEDUP_INDEX_DIR VAR_RUN"/abrt/dedup-index"
+#define DEDUP_BUCKETS_DIR DEDUP_INDEX_DIR"/buckets"
+#define DEDUP_DIRS_DIR DEDUP_INDEX_DIR"/dirs"
+#define DEDUP_READY_FILE DEDUP_INDEX_DIR"/ready"
+
+char *abrt_dedup_bucket_name(const char *uid, const char *type, const char *executable)
+{
+    GChecksum *checksum = g_checksum_new(G_CHECKSUM_SHA1);
+
+    g_checksum_update(checksum, (const guchar *)(uid ? uid : ""), -1);
+    g_checksum_update(checksum, (const guchar *)"\n", 1);
+    g_checksum_update(checksum, (const guchar *)(type ? type : ""), -1);
+    g_checksum_update(checksum, (const guchar *)"\n", 1);
+    /* Missing executable is not the same as an empty one */
+    if (executable != NULL)
+    {
+        g_checksum_update(checksum, (const guchar *)"+", 1);
+        g_checksum_update(checksum, (const guchar *)executable, -1);
+    }
+    else
+        g_checksum_update(checksum, (const guchar *)"-", 1);
+
+    char *bucket = g_strdup(g_checksum_get_string(checksum));
+    g_checksum_free(checksum);
+
+    return bucket;
+}
+
+static const char *dump_dir_basename(const char *dump_dir_name)
+{
+    const char *base = strrchr(dump_dir_name, '/');
+    return base ? base + 1 : dump_dir_name;
+}
+
+/* Hidden names are temporary files of the index, "*.new" directories are
+ * problems still being written (including the abrt-server staging ones) and
+ * must never become targets of deduplication */
+static bool dedup_name_is_indexable(const char *base)
+{
+    return base[0] != '\0' && base[0] != '.' && !g_str_has_suffix(base, ".new");
+}
+
+bool abrt_dedup_index_is_ready(void)
+{
+    return access(DEDUP_READY_FILE, F_OK) == 0;
+}
+
+int abrt_dedup_index_add(struct dump_dir *dd)
+{
+    const char *base = dump_dir_basename(dd->dd_dirname);
+    if (!dedup_name_is_indexable(base))
+        return -EINVAL;
+
+    if (access(DEDUP_INDEX_DIR, F_OK) != 0)
+        /* abrtd is not running, it will index the directory on start-up */
+        return -ENOENT;
+
+    const int flags = DD_FAIL_QUIETLY_ENOENT | DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE;
+    g_autofree char *uid = dd_load_text_ext(dd, FILENAME_UID, flags);
+    g_autofree char *type = dd_load_text_ext(dd, FILENAME_TYPE, flags);
+    g_autofree char *executable = dd_load_text_ext(dd, FILENAME_EXECUTABLE, flags);
+    g_autofree char *container_id = dd_load_text_ext(dd, FILENAME_CONTAINER_ID, flags);
+    g_autofree char *uuid = dd_load_text_ext(dd, FILENAME_UUID, flags);
+    g_autofree char *duphash = dd_load_text_ext(dd, FILENAME_DUPHASH, flags);
+
+    if (type == NULL)
+        return -EINVAL;
+
+    g_autofree char *bucket = abrt_dedup_bucket_name(uid, type, executable);
+    g_autofree char *bucket_dir = g_build_filename(DEDUP_BUCKETS_DIR, bucket, NULL);
+    if (mkdir(bucket_dir, 0700) != 0 && errno != EEXIST)
+    {
+        const int r = -errno;
+        perror_msg("Can't create dedup index bucket '%s'", bucket_dir);
+        return r;
+    }
+
+    g_autofree char *entry = g_build_filename(bucket_dir, base, NULL);
+    g_autofree char *entry_tmp = g_strdup_printf("%s/.%s.tmp", bucket_dir, base);
+    g_autofree char *content = g_strdup_printf("%s\n%s\n%s\n",
+            uuid ? uuid : "",
+            duphash ? duphash : "",
+            container_id ? container_id : "");
+
+    int fd = open(entry_tmp, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        const int r = -errno;
+        perror_msg("Can't create dedup index entry '%s'", entry_tmp);
+        return r;
+    }
+
+    const bool written = libreport_full_write_str(fd, content) == strlen(content);
+    close(fd);
+    if (!written || rename(entry_tmp, entry) != 0)
+    {
+        const int r = errno ? -errno : -EIO;
+        perror_msg("Can't save dedup index entry '%s'", entry);
+        unlink(entry_tmp);
+        return r;
+    }
+
+    g_autofree char *link = g_build_filename(DEDUP_DIRS_DIR, base, NULL);
+    unlink(link);
+    if (symlink(bucket, link) != 0)
+        perror_msg("Can't create dedup index link '%s'", link);
+
+    log_debug("Added '%s' to dedup index bucket %s", base, bucket);
+    return 0;
+}
+
+void abrt_dedup_index_remove(const char *dump_dir_name)
+{
+    const char *base = dump_dir_basename(dump_dir_name);
+    if (base[0] == '\0' || base[0] == '.')
+        return;
+
+    g_autofree char *link = g_build_filename(DEDUP_DIRS_DIR, base, NULL);
+    char bucket[PATH_MAX];
+    const ssize_t len = readlink(link, bucket, sizeof(bucket) - 1);
+    if (len < 0)
+        return;
+    bucket[len] = '\0';
+
+    if (strchr(bucket, '/') == NULL)
+    {
+        g_autofree char *entry = g_build_filename(DEDUP_BUCKETS_DIR, bucket, base, NULL);
+        unlink(entry);
+    }
+    unlink(link);
+
+    log_debug("Removed '%s' from dedup index", base);
+}
+
+static void dedup_entry_free(struct abrt_dedup_entry *entry)
+{
+    if (entry == NULL)
+        return;
+
+    free(entry->dirname);
+    free(entry->uuid);
+    free(entry->duphash);
+    free(entry->container_id);
+    free(entry);
+}
+
+void abrt_dedup_entry_list_free(GList *entries)
+{
+    g_list_free_full(entries, (GDestroyNotify)dedup_entry_free);
+}
+
+static bool element_is_newer(const char *problem_dir, const char *name,
+        const struct stat *entry_stat)
+{
+    g_autofree char *path = g_build_filename(problem_dir, name, NULL);
+    struct stat statbuf;
+    if (stat(path, &statbuf) != 0)
+        /* Removed after the problem was indexed, or never had a value */
+        return true;
+
+    if (statbuf.st_mtim.tv_sec != entry_stat->st_mtim.tv_sec)
+        return statbuf.st_mtim.tv_sec > entry_stat->st_mtim.tv_sec;
+    return statbuf.st_mtim.tv_nsec > entry_stat->st_mtim.tv_nsec;
+}
+
+static char *dup_line_or_null(const char *line)
+{
+    return line[0] != '\0' ? g_strdup(line) : NULL;
+}
+
+GList *abrt_dedup_index_lookup(const char *dump_location,
+        const char *uid, const char *type, const char *executable)
+{
+    GList *entries = NULL;
+
+    g_autofree char *bucket = abrt_dedup_bucket_name(uid, type, executable);
+    g_autofree char *bucket_dir = g_build_filename(DEDUP_BUCKETS_DIR, bucket, NULL);
+    DIR *dir = opendir(bucket_dir);
+    if (dir == NULL)
+        /* No problem of this kind has been indexed yet */
+        return NULL;
+
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL)
+    {
+        if (!dedup_name_is_indexable(dent->d_name))
+            continue; /* ".", "..", temporary files and unfinished problems */
+
+        g_autofree char *problem_dir = g_build_filename(dump_location, dent->d_name, NULL);
+        if (access(problem_dir, F_OK) != 0)
+        {
+            log_debug("Dropping stale dedup index entry '%s'", dent->d_name);
+            abrt_dedup_index_remove(dent->d_name);
+            continue;
+        }
+
+        g_autofree char *entry_path = g_build_filename(bucket_dir, dent->d_name, NULL);
+        struct stat entry_stat;
+        g_autofree char *content = NULL;
+        if (stat(entry_path, &entry_stat) != 0
+         || !g_file_get_contents(entry_path, &content, NULL, NULL))
+            continue;
+
+        char *lines[3] = { NULL };
+        char *line = content;
+        for (unsigned i = 0; i < ARRAY_SIZE(lines) && line != NULL; ++i)
+        {
+            char *end = strchr(line, '\n');
+            if (end)
+                *end++ = '\0';
+            lines[i] = line;
+            line = end;
+        }
+
+        struct abrt_dedup_entry *entry = g_new0(struct abrt_dedup_entry, 1);
+        entry->dirname = g_strdup(dent->d_name);
+        entry->uuid = lines[0] ? dup_line_or_null(lines[0]) : NULL;
+        entry->duphash = lines[1] ? dup_line_or_null(lines[1]) : NULL;
+        entry->container_id = lines[2] ? dup_line_or_null(lines[2]) : NULL;
+
+        /* Analyzers and events rewrite these elements after the problem was
+         * indexed, the caller must read them from the directory then */
+        if (element_is_newer(problem_dir, FILENAME_UUID, &entry_stat))
+            g_clear_pointer(&entry->uuid, free);
+        if (element_is_newer(problem_dir, FILENAME_DUPHASH, &entry_stat))
+            g_clear_pointer(&entry->duphash, free);
+        entries = g_list_prepend(entries, entry);
+    }
+    closedir(dir);
+
+    return g_list_reverse(entries);
+}
+
+/* Removes all files from the directory and its sub-directories. The index
+ * is only two levels deep.
+ */
+static void remove_index_tree(const char *path, int depth)
+{
+    DIR *dir = opendir(path);
+    if (dir == NULL)
+        return;
+
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL)
+    {
+        if (libreport_dot_or_dotdot(dent->d_name))
+            continue;
+
+        if (unlinkat(dirfd(dir), dent->d_name, 0) == 0)
+            continue;
+
+        if ((errno == EISDIR || errno == EPERM) && depth > 0)
+        {
+            g_autofree char *sub = g_build_filename(path, dent->d_name, NULL);
+            remove_index_tree(sub, depth - 1);
+            if (rmdir(sub) != 0)
+                perror_msg("Can't remove '%s'", sub);
+        }
+        else
+            perror_msg("Can't remove '%s/%s'", path, dent->d_name);
+    }
+    closedir(dir);
+}
+
+int abrt_dedup_index_rebuild_begin(void)
+{
+    remove_index_tree(DEDUP_INDEX_DIR, 2);
+
+    if ((mkdir(DEDUP_INDEX_DIR, 0700) != 0 && errno != EEXIST)
+     || (mkdir(DEDUP_BUCKETS_DIR, 0700) != 0 && errno != EEXIST)
+     || (mkdir(DEDUP_DIRS_DIR, 0700) != 0 && errno != EEXIST))
+    {
+        const int r = -errno;
+        perror_msg("Can't create dedup index in '%s'", DEDUP_INDEX_DIR);
+        return r;
+    }
+
+    return 0;
+}
+
+void abrt_dedup_index_rebuild_end(void)
+{
+    int fd = open(DEDUP_READY_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0)
+    {
+        perror_msg("Can't create '%s'", DEDUP_READY_FILE);
+        return;
+    }
+    close(fd);
+}
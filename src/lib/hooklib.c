@@ -63,12 +63,18 @@ void abrt_trim_problem_dirs(const char *dirname, double cap_size, const char *ex
     }
     log_debug("excluded_basename:'%s'", excluded_basename);
 
+    /* The directory is walked only once, the sizes of the remaining
+     * directories do not change by deleting the worst one.
+     */
+    struct abrt_size_ledger *ledger = abrt_size_ledger_new(dirname);
+    const char *excluded[] = { excluded_basename, NULL };
+
     int count = 20;
     while (--count >= 0)
     {
-        /* We exclude our own dir from candidates for deletion (3rd param): */
-        g_autofree char *worst_basename = NULL;
-        double cur_size = libreport_get_dirsize_find_largest_dir(dirname, &worst_basename, excluded_basename, NULL);
+        /* We exclude our own dir from candidates for deletion: */
+        g_autofree char *worst_basename = abrt_size_ledger_find_worst_dir(ledger, excluded);
+        double cur_size = abrt_size_ledger_get_total(ledger);
         if (cur_size <= cap_size || !worst_basename)
         {
             log_info("cur_size:%.0f cap_size:%.0f, no (more) trimming", cur_size, cap_size);
@@ -78,7 +84,11 @@ void abrt_trim_problem_dirs(const char *dirname, double cap_size, const char *ex
                 dirname, cur_size, cap_size / (1024*1024), worst_basename);
         g_autofree char *d = g_build_filename(dirname ? dirname : "", worst_basename, NULL);
         delete_dump_dir(d);
+        /* Forgets the directory if it is gone, otherwise it is picked again */
+        abrt_size_ledger_update(ledger, worst_basename);
     }
+
+    abrt_size_ledger_free(ledger);
 }
 
 /**
@@ -169,14 +179,20 @@ static char* exec_vp(char **args, int redirect_stderr, int exec_timeout_sec, int
     return g_string_free(buf_out, FALSE);
 }
 
-char *abrt_run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec)
+static char *run_unstrip_n(const char *core_path, unsigned timeout_sec)
 {
+    char *modules = abrt_core_list_modules(core_path);
+    if (modules != NULL)
+        return modules;
+
+    log_info("Can't read modules of '%s' directly, running eu-unstrip", core_path);
+
     int flags = EXECFLG_INPUT_NUL | EXECFLG_OUTPUT | EXECFLG_SETSID | EXECFLG_QUIET;
     VERB1 flags &= ~EXECFLG_QUIET;
     int pipeout[2];
     char* args[4];
     args[0] = (char*)"eu-unstrip";
-    args[1] = g_strdup_printf("--core=%s/"FILENAME_COREDUMP, dump_dir_name);
+    args[1] = g_strdup_printf("--core=%s", core_path);
     args[2] = (char*)"-n";
     args[3] = NULL;
     pid_t child = libreport_fork_execv_on_steroids(flags, args, pipeout, /*env_vec:*/ NULL, /*dir:*/ NULL, /*uid(unused):*/ 0);
@@ -236,10 +252,281 @@ char *abrt_run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec)
     return g_string_free(buf_out, FALSE);
 }
 
+char *abrt_run_unstrip_n(const char *dump_dir_name, unsigned timeout_sec)
+{
+    char *core_path = abrt_coredump_acquire(dump_dir_name);
+    if (core_path == NULL)
+        return NULL;
+
+    char *modules = run_unstrip_n(core_path, timeout_sec);
+    abrt_coredump_release(dump_dir_name, core_path);
+    return modules;
+}
+
+/* The output of gdb bigger than this is trimmed */
+#define BACKTRACE_BUDGET (256*1024)
+
+/* Marks the beginning of the output of GDB_BACKTRACE_SCRIPT, whatever gdb
+ * printed before it does not depend on the backtrace commands */
+#define GDB_BACKTRACE_SCRIPT_START "abrt-backtrace-script-start"
+
+/* Marks the successful end of GDB_BACKTRACE_SCRIPT, followed by the backtrace
+ * command the output fit in */
+#define GDB_BACKTRACE_SCRIPT_END "abrt-backtrace-script-end: "
+
+/* The last attempt of both GDB_BACKTRACE_SCRIPT and
+ * get_backtrace_by_restarting(), used whatever its size is */
+#define GDB_BACKTRACE_SMALLEST "backtrace 32"
+
+/*
+ * Runs the same sequence of backtrace commands as get_backtrace_by_restarting()
+ * inside a single gdb, hence the core, the binary and the debuginfo are loaded
+ * only once. Threads are backtraced one by one and an attempt is abandoned as
+ * soon as its output, together with the output of the commands following the
+ * backtrace, exceeds the budget.
+ *
+ * Must not contain double quotes, see get_backtrace_in_one_session().
+ */
+static const char GDB_BACKTRACE_SCRIPT[] =
+"import gdb\n"
+"\n"
+"def abrt_execute(command):\n"
+"    try:\n"
+"        return gdb.execute(command, to_string=True)\n"
+"    except gdb.error as ex:\n"
+"        return str(ex) + '\\n'\n"
+"\n"
+"def abrt_backtrace_attempts():\n"
+"    depth, all_threads, full = 1024, True, True\n"
+"    while True:\n"
+"        yield all_threads, full, depth\n"
+"        if depth <= 32:\n"
+"            return\n"
+"        depth //= 2\n"
+"        if depth <= 64 and all_threads:\n"
+"            depth, all_threads = 128, False\n"
+"        elif depth <= 64 and full:\n"
+"            depth, full = 128, False\n"
+"\n"
+"def abrt_backtrace(budget):\n"
+"    gdb.write('" GDB_BACKTRACE_SCRIPT_START "\\n')\n"
+"    gdb.flush()\n"
+"    threads = sorted(gdb.selected_inferior().threads(), key=lambda t: t.num)\n"
+"    crash_thread = gdb.selected_thread()\n"
+"    if crash_thread is None and threads:\n"
+"        crash_thread = threads[0]\n"
+"    if crash_thread is not None:\n"
+"        crash_thread.switch()\n"
+"    else:\n"
+"        gdb.write('abrt: no thread to backtrace\\n')\n"
+"    info = ''.join(abrt_execute(c) for c in ('info sharedlib',\n"
+"                                             'print (char*)__abort_msg',\n"
+"                                             'print (char*)__glib_assert_msg',\n"
+"                                             'info all-registers'))\n"
+"    attempts = list(abrt_backtrace_attempts())\n"
+"    for n, (all_threads, full, depth) in enumerate(attempts):\n"
+"        command = 'backtrace %s%u' % ('full ' if full else '', depth)\n"
+"        if n <= 1:\n"
+"            dis = abrt_execute('disassemble' if n == 0 else 'disassemble $pc-20, $pc+64')\n"
+"        size = len(info) + len(dis)\n"
+"        if all_threads:\n"
+"            bt = []\n"
+"            for t in threads:\n"
+"                bt.append(abrt_execute('thread apply %u %s' % (t.num, command)))\n"
+"                size += len(bt[-1])\n"
+"                if size >= budget:\n"
+"                    break\n"
+"            bt = ''.join(bt)\n"
+"            command = 'thread apply all -ascending ' + command\n"
+"        else:\n"
+"            bt = abrt_execute(command)\n"
+"            size += len(bt)\n"
+"        if size < budget or n == len(attempts) - 1:\n"
+"            break\n"
+"    gdb.write(bt + info + dis)\n"
+"    gdb.write('\\n" GDB_BACKTRACE_SCRIPT_END "%s\\n' % command)\n"
+"    gdb.flush()\n"
+;
+
+/*
+ * @param args The gdb command line which loads the binary and the core,
+ * there must be room for at least 5 more elements.
+ * @return Malloc'ed string, NULL if the script could not run (e.g. gdb is
+ * built without Python) and gdb needs to be run for each attempt.
+ */
+static char *get_backtrace_in_one_session(char **args, unsigned argc, unsigned timeout_sec)
+{
+    /* The script is passed as a single line Python string literal */
+    GString *script = g_string_new("python exec(\"");
+    for (const char *c = GDB_BACKTRACE_SCRIPT; *c != '\0'; ++c)
+    {
+        if (*c == '\n')
+            g_string_append(script, "\\n");
+        else if (*c == '\\')
+            g_string_append(script, "\\\\");
+        else
+            g_string_append_c(script, *c);
+    }
+    g_string_append(script, "\")");
+
+    args[argc] = (char*)"-ex";
+    args[argc + 1] = script->str;
+    args[argc + 2] = (char*)"-ex";
+    args[argc + 4] = NULL;
+
+    /* The budget applies to the whole output as in get_backtrace_by_restarting().
+     * The script can't see what gdb printed before it started (e.g. a line for
+     * every thread), so if that pushed the output over the budget, the script
+     * runs once more with the budget reduced by its size.
+     */
+    char *bt = NULL;
+    unsigned budget = BACKTRACE_BUDGET;
+    for (unsigned run = 0; ; ++run)
+    {
+        args[argc + 3] = g_strdup_printf("python abrt_backtrace(%u)", budget);
+        int status = 0;
+        bt = exec_vp(args, /*redirect_stderr:*/ 1, timeout_sec, &status);
+        free(args[argc + 3]);
+
+        char *start = bt ? strstr(bt, GDB_BACKTRACE_SCRIPT_START "\n") : NULL;
+        char *end = start ? g_strrstr(start, "\n" GDB_BACKTRACE_SCRIPT_END) : NULL;
+        if (end == NULL)
+        {
+            /* The backtrace already took too long, do not try again */
+            if (WIFSIGNALED(status) && WTERMSIG(status) == SIGKILL)
+                break;
+
+            log_notice("Can't generate backtrace by gdb script, running gdb for each attempt");
+            g_clear_pointer(&bt, free);
+            break;
+        }
+
+        const char *command = end + strlen("\n" GDB_BACKTRACE_SCRIPT_END);
+        const size_t command_len = strcspn(command, "\n");
+        const bool smallest = (command_len == strlen(GDB_BACKTRACE_SMALLEST)
+                               && strncmp(command, GDB_BACKTRACE_SMALLEST, command_len) == 0);
+        const size_t preamble_len = start - bt;
+
+        /* Drop the markers, the rest is what gdb would print running the
+         * commands itself */
+        if (end > start && end[-1] == '\n')
+            end[0] = '\0';
+        else
+            strcpy(end, "\n");
+        const size_t start_len = strlen(GDB_BACKTRACE_SCRIPT_START "\n");
+        memmove(start, start + start_len, strlen(start + start_len) + 1);
+
+        if (strnlen(bt, BACKTRACE_BUDGET) < BACKTRACE_BUDGET || smallest || run > 0)
+        {
+            if (!g_str_has_prefix(command, "thread apply all -ascending backtrace full 1024\n"))
+                log_warning("Backtrace is too big, reduced it to '%.*s'", (int)command_len, command);
+            break;
+        }
+
+        budget = preamble_len < BACKTRACE_BUDGET ? BACKTRACE_BUDGET - preamble_len : 1;
+        log_warning("Backtrace is too big (%u bytes), retrying with %u bytes left for it",
+                    (unsigned)strlen(bt), budget);
+        g_clear_pointer(&bt, free);
+    }
+
+    g_string_free(script, TRUE);
+    return bt;
+}
+
+/*
+ * Spawns gdb again with a smaller backtrace until its output fits in the
+ * budget.
+ *
+ * @param args The gdb command line which loads the binary and the core,
+ * there must be room for at least 13 more elements.
+ * @return Malloc'ed string
+ */
+static char *get_backtrace_by_restarting(char **args, unsigned argc, unsigned timeout_sec)
+{
+    unsigned i = argc;
+    args[i++] = (char*)"-ex";
+    const unsigned bt_cmd_index = i++;
+    /*args[bt_cmd_index] = ... see below */
+    args[i++] = (char*)"-ex";
+    args[i++] = (char*)"info sharedlib";
+    /* glibc's abort() stores its message in __abort_msg variable */
+    args[i++] = (char*)"-ex";
+    args[i++] = (char*)"print (char*)__abort_msg";
+    args[i++] = (char*)"-ex";
+    args[i++] = (char*)"print (char*)__glib_assert_msg";
+    args[i++] = (char*)"-ex";
+    args[i++] = (char*)"info all-registers";
+    args[i++] = (char*)"-ex";
+    const unsigned dis_cmd_index = i++;
+    args[dis_cmd_index] = (char*)"disassemble";
+    args[i++] = NULL;
+
+    /* Limit bt depth. With no limit, gdb sometimes OOMs the machine */
+    unsigned bt_depth = 1024;
+    const char *thread_apply_all = "thread apply all -ascending";
+    const char *full = "full ";
+    char *bt = NULL;
+    while (1)
+    {
+        args[bt_cmd_index] = g_strdup_printf("%s backtrace %s%u", thread_apply_all, full, bt_depth);
+        bt = exec_vp(args, /*redirect_stderr:*/ 1, timeout_sec, NULL);
+        free(args[bt_cmd_index]);
+        if ((bt && strnlen(bt, BACKTRACE_BUDGET) < BACKTRACE_BUDGET) || bt_depth <= 32)
+        {
+            break;
+        }
+
+        bt_depth /= 2;
+        if (bt)
+        {
+            log_warning("Backtrace is too big (%u bytes), reducing depth to %u",
+                        (unsigned)strlen(bt), bt_depth);
+        }
+        else
+        {
+            /* (NB: in fact, current impl. of exec_vp() never returns NULL) */
+            log_warning("Failed to generate backtrace, reducing depth to %u",
+                        bt_depth);
+            g_clear_pointer(&bt, free);
+        }
+
+        /* Replace -ex disassemble (which disasms entire function $pc points to)
+         * to a version which analyzes limited, small patch of code around $pc.
+         * (Users reported a case where bare "disassemble" attempted to process
+         * entire .bss).
+         * TODO: what if "$pc-N" underflows? in my test, this happens:
+         * Dump of assembler code from 0xfffffffffffffff0 to 0x30:
+         * End of assembler dump.
+         * (IOW: "empty" dump)
+         */
+        args[dis_cmd_index] = (char*)"disassemble $pc-20, $pc+64";
+
+        if (bt_depth <= 64 && thread_apply_all[0] != '\0')
+        {
+            /* This program likely has gazillion threads, dont try to bt them all */
+            bt_depth = 128;
+            thread_apply_all = "";
+        }
+        if (bt_depth <= 64 && full[0] != '\0')
+        {
+            /* Looks like there are gigantic local structures or arrays, disable "full" bt */
+            bt_depth = 128;
+            full = "";
+        }
+    }
+
+    return bt;
+}
+
 char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *debuginfo_dirs)
 {
     INITIALIZE_LIBABRT();
 
+    /* A compressed core is unpacked for gdb which needs to seek in it */
+    char *core_path = abrt_coredump_acquire(dd->dd_dirname);
+    if (core_path == NULL)
+        return NULL;
+
     char *executable = NULL;
     if (dd_exist(dd, FILENAME_BINARY))
         executable = g_build_filename(dd->dd_dirname ? dd->dd_dirname : "", FILENAME_BINARY, NULL);
@@ -250,7 +537,7 @@ char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *
     log_warning(_("Generating backtrace"));
 
     unsigned i = 0;
-    char *args[25];
+    char *args[32];
     args[i++] = (char*)GDB;
     args[i++] = (char*)"-batch";
     GString *set_debug_file_directory = g_string_new(NULL);
@@ -293,6 +580,19 @@ char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *
         g_string_free(debug_directories, TRUE);
     }
 
+    /* gdb saves the index of symbols of every file with a build-id there
+     * and loads it instead of reading the DWARF of the same build again */
+    const char *symbol_cache_dir = abrt_symbol_cache_dir();
+    unsigned symbol_cache_dir_index = 0;
+    if (symbol_cache_dir != NULL)
+    {
+        args[i++] = (char*)"-iex";
+        symbol_cache_dir_index = i;
+        args[i++] = g_strdup_printf("set index-cache directory %s", symbol_cache_dir);
+        args[i++] = (char*)"-iex";
+        args[i++] = (char*)"set index-cache enabled on";
+    }
+
     args[i++] = (char*)"-ex";
     const unsigned debug_dir_cmd_index = i++;
     args[debug_dir_cmd_index] = g_string_free(set_debug_file_directory, FALSE);
@@ -324,79 +624,12 @@ char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *
 
     args[i++] = (char*)"-ex";
     const unsigned core_cmd_index = i++;
-    args[core_cmd_index] = g_strdup_printf("core-file %s/"FILENAME_COREDUMP, dd->dd_dirname);
-
-    args[i++] = (char*)"-ex";
-    const unsigned bt_cmd_index = i++;
-    /*args[9] = ... see below */
-    args[i++] = (char*)"-ex";
-    args[i++] = (char*)"info sharedlib";
-    /* glibc's abort() stores its message in __abort_msg variable */
-    args[i++] = (char*)"-ex";
-    args[i++] = (char*)"print (char*)__abort_msg";
-    args[i++] = (char*)"-ex";
-    args[i++] = (char*)"print (char*)__glib_assert_msg";
-    args[i++] = (char*)"-ex";
-    args[i++] = (char*)"info all-registers";
-    args[i++] = (char*)"-ex";
-    const unsigned dis_cmd_index = i++;
-    args[dis_cmd_index] = (char*)"disassemble";
-    args[i++] = NULL;
+    args[core_cmd_index] = g_strdup_printf("core-file %s", core_path);
 
     /* Get the backtrace, but try to cap its size */
-    /* Limit bt depth. With no limit, gdb sometimes OOMs the machine */
-    unsigned bt_depth = 1024;
-    const char *thread_apply_all = "thread apply all -ascending";
-    const char *full = "full ";
-    char *bt = NULL;
-    while (1)
-    {
-        args[bt_cmd_index] = g_strdup_printf("%s backtrace %s%u", thread_apply_all, full, bt_depth);
-        bt = exec_vp(args, /*redirect_stderr:*/ 1, timeout_sec, NULL);
-        free(args[bt_cmd_index]);
-        if ((bt && strnlen(bt, 256*1024) < 256*1024) || bt_depth <= 32)
-        {
-            break;
-        }
-
-        bt_depth /= 2;
-        if (bt)
-        {
-            log_warning("Backtrace is too big (%u bytes), reducing depth to %u",
-                        (unsigned)strlen(bt), bt_depth);
-        }
-        else
-        {
-            /* (NB: in fact, current impl. of exec_vp() never returns NULL) */
-            log_warning("Failed to generate backtrace, reducing depth to %u",
-                        bt_depth);
-            g_clear_pointer(&bt, free);
-        }
-
-        /* Replace -ex disassemble (which disasms entire function $pc points to)
-         * to a version which analyzes limited, small patch of code around $pc.
-         * (Users reported a case where bare "disassemble" attempted to process
-         * entire .bss).
-         * TODO: what if "$pc-N" underflows? in my test, this happens:
-         * Dump of assembler code from 0xfffffffffffffff0 to 0x30:
-         * End of assembler dump.
-         * (IOW: "empty" dump)
-         */
-        args[dis_cmd_index] = (char*)"disassemble $pc-20, $pc+64";
-
-        if (bt_depth <= 64 && thread_apply_all[0] != '\0')
-        {
-            /* This program likely has gazillion threads, dont try to bt them all */
-            bt_depth = 128;
-            thread_apply_all = "";
-        }
-        if (bt_depth <= 64 && full[0] != '\0')
-        {
-            /* Looks like there are gigantic local structures or arrays, disable "full" bt */
-            bt_depth = 128;
-            full = "";
-        }
-    }
+    char *bt = get_backtrace_in_one_session(args, i, timeout_sec);
+    if (bt == NULL)
+        bt = get_backtrace_by_restarting(args, i, timeout_sec);
 
     if (auto_load_base_index > 0)
     {
@@ -404,9 +637,17 @@ char *abrt_get_backtrace(struct dump_dir *dd, unsigned timeout_sec, const char *
         free(args[auto_load_base_index + 2]);
     }
 
+    if (symbol_cache_dir_index > 0)
+    {
+        free(args[symbol_cache_dir_index]);
+        abrt_symbol_cache_trim(symbol_cache_dir,
+                (off_t)abrt_g_settings_symbol_cache_size * 1024 * 1024);
+    }
+
     free(args[debug_dir_cmd_index]);
     free(args[file_cmd_index]);
     free(args[core_cmd_index]);
+    abrt_coredump_release(dd->dd_dirname, core_path);
     return bt;
 }
 
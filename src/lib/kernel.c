@@ -32,14 +32,15 @@
  */
 #define SANE_MIN_OOPS_LEN 30
 
-static void record_oops(GList **oops_list, const struct abrt_koops_line_info* lines_info, int oopsstart, int oopsend)
+static void record_oops(const struct abrt_koops_parser *parser, GList **oops_list,
+        const struct abrt_koops_line_info* lines_info, int lines_count)
 {
     int q;
     int len;
     int rv = 1;
 
     len = 2;
-    for (q = oopsstart; q <= oopsend; q++)
+    for (q = 0; q < lines_count; q++)
         len += strlen(lines_info[q].ptr) + 1;
 
     /* too short oopses are invalid */
@@ -48,10 +49,10 @@ static void record_oops(GList **oops_list, const struct abrt_koops_line_info* li
         g_autofree char *oops = (char*)g_malloc0(len);
         char *dst = oops;
         g_autofree char *version = NULL;
-        for (q = oopsstart; q <= oopsend; q++)
+        for (q = 0; q < lines_count; q++)
         {
             if (!version)
-                version = abrt_koops_extract_version(lines_info[q].ptr);
+                version = abrt_koops_parser_extract_version(parser, lines_info[q].ptr);
             if (lines_info[q].ptr[0])
             {
                 dst = stpcpy(dst, lines_info[q].ptr);
@@ -159,22 +160,102 @@ static const char *const s_koops_suspicious_strings_blacklist[] = {
     NULL
 };
 
-static bool suspicious_line(const char *line)
+/* Lines which can contain the kernel version */
+static const char *const s_koops_version_line_strings[] = {
+    "Pid",
+    "comm",
+    "CPU",
+    "REGS",
+    "EFLAGS",
+
+    /* Termination */
+    NULL
+};
+
+/* "(4.7.0-2.x86_64.fc25) #"    */
+/* " 4.7.0-2.x86_64.fc25 #"     */
+/* " 2.6.3.4.5-2.x86_64.fc22 #" */
+#define KOOPS_VERSION_REGEX "([ \\(]|kernel-)([0-9]+\\.[0-9]+\\.[0-9]+(\\.[^.-]+)*-[^ \\)]+)\\)? #"
+
+/* ARM backtrace regex, match a string similar to r7:df912310 */
+#define KOOPS_ARM_REGISTER_REGEX "r[[:digit:]]{1,}:[a-f[:digit:]]{8}"
+
+struct abrt_koops_parser
 {
-    const char *const *str = s_koops_suspicious_strings;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-            break;
+    struct abrt_string_matcher *suspicious_matcher;
+    struct abrt_string_matcher *suspicious_blacklist_matcher;
+    struct abrt_string_matcher *version_line_matcher;
 
-    if (!*str)
-        return false;
+    regex_t version_regex;
+    int version_regex_rc;
+    regex_t arm_regex;
+    int arm_regex_rc;
+};
 
-    str = s_koops_suspicious_strings_blacklist;
-    for ( ; *str; ++str)
-        if (strstr(line, *str))
-           break;
+struct abrt_koops_parser *abrt_koops_parser_new(void)
+{
+    struct abrt_koops_parser *parser = g_new0(struct abrt_koops_parser, 1);
+
+    /* The lines are checked for all the strings in a single pass */
+    parser->suspicious_matcher = abrt_string_matcher_new(s_koops_suspicious_strings,
+            ARRAY_SIZE(s_koops_suspicious_strings) - 1);
+    parser->suspicious_blacklist_matcher = abrt_string_matcher_new(s_koops_suspicious_strings_blacklist,
+            ARRAY_SIZE(s_koops_suspicious_strings_blacklist) - 1);
+    parser->version_line_matcher = abrt_string_matcher_new(s_koops_version_line_strings,
+            ARRAY_SIZE(s_koops_version_line_strings) - 1);
+
+    parser->version_regex_rc = regcomp(&parser->version_regex, KOOPS_VERSION_REGEX, REG_EXTENDED);
+    if (parser->version_regex_rc != 0)
+    {
+        char buf[LINE_MAX];
+        regerror(parser->version_regex_rc, &parser->version_regex, buf, sizeof(buf));
+        error_msg("BUG: invalid kernel version regexp: %s", buf);
+    }
+
+    parser->arm_regex_rc = regcomp(&parser->arm_regex, KOOPS_ARM_REGISTER_REGEX, REG_EXTENDED | REG_NOSUB);
+
+    return parser;
+}
 
-    return !*str;
+void abrt_koops_parser_free(struct abrt_koops_parser *parser)
+{
+    if (parser == NULL)
+        return;
+
+    abrt_string_matcher_free(parser->suspicious_matcher);
+    abrt_string_matcher_free(parser->suspicious_blacklist_matcher);
+    abrt_string_matcher_free(parser->version_line_matcher);
+    if (parser->version_regex_rc == 0)
+        regfree(&parser->version_regex);
+    if (parser->arm_regex_rc == 0)
+        regfree(&parser->arm_regex);
+    free(parser);
+}
+
+/*
+ * The parser used by the functions which do not take one. It is created on
+ * the first use and lives until the process exits.
+ */
+static const struct abrt_koops_parser *default_parser(void)
+{
+    static struct abrt_koops_parser *parser;
+    static gsize initialized;
+
+    if (g_once_init_enter(&initialized))
+    {
+        parser = abrt_koops_parser_new();
+        g_once_init_leave(&initialized, 1);
+    }
+
+    return parser;
+}
+
+static bool suspicious_line(const struct abrt_koops_parser *parser, const char *line)
+{
+    if (abrt_string_matcher_find_str(parser->suspicious_matcher, line) < 0)
+        return false;
+
+    return abrt_string_matcher_find_str(parser->suspicious_blacklist_matcher, line) < 0;
 }
 
 void abrt_koops_print_suspicious_strings(void)
@@ -273,304 +354,510 @@ int abrt_koops_line_skip_level(const char **c)
     return linelevel;
 }
 
-void abrt_koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
+/* Lines of syslog or dmesg are shorter, longer lines are truncated in order
+ * to keep memory usage bounded on garbage input */
+#define KOOPS_MAX_LINE_LEN (64 * 1024)
+
+/* An oops start marker is followed by "---[ end trace" within 50 lines */
+#define KOOPS_END_TRACE_LOOKAHEAD 50
+
+/*
+ * The extractor analyzes lines as they come and keeps only the lines which
+ * may still become a part of an oops: the lines of the oops in progress
+ * (at most 80) and the lines needed to look for the end-of-trace marker
+ * after an oops start marker. Everything else is released right after the
+ * line is analyzed.
+ *
+ * Lines are identified by their absolute numbers, lines[0] is the line
+ * number 'base'.
+ */
+struct abrt_koops_extractor
+{
+    char hostname[HOST_NAME_MAX + 1];
+    char *long_needle;
+    char *short_needle;
+    /* The incomplete last line of the data fed so far */
+    GString *partial_line;
+    unsigned long linecount;
+
+    struct abrt_koops_line_info *lines;
+    unsigned lines_count;
+    unsigned lines_size;
+    long base;
+
+    /* The next line to be analyzed */
+    long cur;
+    long oopsstart;
+    int inbacktrace;
+    int prevlevel;
+
+    const struct abrt_koops_parser *parser;
+};
+
+#define EXTRACTOR_LINE(x, n) ((x)->lines[(n) - (x)->base])
+
+static void extractor_reset_lines(struct abrt_koops_extractor *extractor)
+{
+    for (unsigned i = 0; i < extractor->lines_count; ++i)
+        free(extractor->lines[i].ptr);
+
+    extractor->base += extractor->lines_count;
+    extractor->lines_count = 0;
+    extractor->cur = extractor->base;
+    extractor->oopsstart = -1;
+    extractor->inbacktrace = 0;
+    extractor->prevlevel = 0;
+}
+
+struct abrt_koops_extractor *abrt_koops_extractor_new(const struct abrt_koops_parser *parser)
 {
-    char hostname[HOST_NAME_MAX + 1] = { 0 };
-    g_autofree char *long_needle = NULL;
-    char *hostname_dot;
-    g_autofree char *short_needle = NULL;
-    char *c;
-    int linecount = 0;
-    int lines_info_size = 0;
-    struct abrt_koops_line_info *lines_info = NULL;
+    struct abrt_koops_extractor *extractor = g_new0(struct abrt_koops_extractor, 1);
 
-    if (gethostname(hostname, sizeof(hostname)) == -1)
+    if (gethostname(extractor->hostname, sizeof(extractor->hostname)) == -1)
     {
-        if (ENAMETOOLONG == errno)
-        {
-            /* Pure paranoia, since gethostname() truncates the hostname
-             * if the specified length is not enough to fit the entire thing
-             * and does not guarantee null-termination.
-             *
-             * Would only apply to extremely non-compliant systems, where
-             * HOST_NAME_MAX is just a suggestion.
-             */
-            g_return_if_reached();
-        }
+        /* gethostname() does not guarantee null-termination if the hostname
+         * has been truncated */
+        extractor->hostname[0] = '\0';
     }
+    extractor->hostname[HOST_NAME_MAX] = '\0';
 
-    long_needle = g_strdup_printf(" %s kernel: ", hostname);
-    hostname_dot = strchr(hostname, '.');
+    extractor->long_needle = g_strdup_printf(" %s kernel: ", extractor->hostname);
+    char *hostname_dot = strchr(extractor->hostname, '.');
     if (NULL != hostname_dot)
     {
         *hostname_dot = '\0';
     }
-    short_needle = g_strdup_printf(" %s kernel: ", hostname);
+    extractor->short_needle = g_strdup_printf(" %s kernel: ", extractor->hostname);
+
+    extractor->partial_line = g_string_new(NULL);
+    extractor->oopsstart = -1;
+    extractor->parser = parser;
 
-    /* Split buffer into lines */
+    return extractor;
+}
+
+void abrt_koops_extractor_free(struct abrt_koops_extractor *extractor)
+{
+    if (extractor == NULL)
+        return;
+
+    extractor_reset_lines(extractor);
+    free(extractor->lines);
+    g_string_free(extractor->partial_line, TRUE);
+    free(extractor->long_needle);
+    free(extractor->short_needle);
+    free(extractor);
+}
 
-    if (buflen != 0)
-            buffer[buflen - 1] = '\n';  /* the buffer usually ends with \n, but let's make sure */
-    c = buffer;
-    while (c < buffer + buflen)
+/*
+ * Analyzes the line extractor->cur. Returns false if there is no line to
+ * analyze or if more lines are needed to decide about the line.
+ */
+static bool extractor_analyze_line(struct abrt_koops_extractor *extractor, GList **oops_list, bool at_end)
+{
+    const long end = extractor->base + extractor->lines_count;
+    long i = extractor->cur;
+
+    if (i >= end)
+        return false;
+
+    char *curline = EXTRACTOR_LINE(extractor, i).ptr;
+    while (*curline == ' ')
+        curline++;
+
+    if (extractor->oopsstart < 0)
     {
-        char linelevel;
-        char *c9;
-        char *colon;
-
-        linecount++;
-        c9 = (char*)memchr(c, '\n', buffer + buflen - c); /* a \n will always be found */
-        assert(c9);
-        *c9 = '\0'; /* turn the \n into a string termination */
-        if (c9 == c)
-            goto next_line;
-
-        /* Is it a syslog file (/var/log/messages or similar)?
-         * Even though _usually_ it looks like "Nov 19 12:34:38 localhost kernel: xxx",
-         * some users run syslog in non-C locale:
-         * "2010-02-22T09:24:08.156534-08:00 gnu-4 gnome-session[2048]: blah blah"
-         *  ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ !!!
-         * We detect it by checking for N:NN:NN pattern in first 15 chars
-         * (and this still is not good enough... false positive: "pci 0000:15:00.0: PME# disabled")
-         */
-        colon = strchr(c, ':');
-        if (colon && colon > c && colon < c + 15
-         && isdigit(colon[-1]) /* N:... */
-         && isdigit(colon[1]) /* ...N:NN:... */
-         && isdigit(colon[2])
-         && colon[3] == ':'
-         && isdigit(colon[4]) /* ...N:NN:NN... */
-         && isdigit(colon[5])
-        ) {
-            /* It's syslog file, not a bare dmesg */
+        /* Find start-of-oops markers */
+        if (suspicious_line(extractor->parser, curline))
+        {
+            /* Wait for the lines which may contain the end marker */
+            if (!at_end && end < i + KOOPS_END_TRACE_LOOKAHEAD)
+                return false;
+
+            extractor->oopsstart = i;
+        }
 
-            /* Skip non-kernel lines */
-            char *kernel_str = strstr(c, "kernel: ");
-            if (!kernel_str)
+        if (extractor->oopsstart >= 0)
+        {
+            /* debug information */
+            log_debug("Found oops at line %ld: '%s'", extractor->oopsstart,
+                      EXTRACTOR_LINE(extractor, extractor->oopsstart).ptr);
+            /* try to find the end marker */
+            long i2 = i + 1;
+            while (i2 < end && i2 < (i + KOOPS_END_TRACE_LOOKAHEAD))
             {
-                /* if we see our own marker:
-                 * "hostname abrt: Kerneloops: Reported 1 kernel oopses to Abrt"
-                 * we know we submitted everything upto here already */
-                if (strstr(c, "kernel oopses to Abrt"))
+                if (strstr(EXTRACTOR_LINE(extractor, i2).ptr, "---[ end trace"))
                 {
-                    log_debug("Found our marker at line %d", linecount);
-                    free(lines_info);
-                    lines_info = NULL;
-                    lines_info_size = 0;
-                    g_list_free_full(g_steal_pointer(oops_list), free);
+                    extractor->inbacktrace = 1;
+                    i = i2;
+                    break;
                 }
-                goto next_line;
+                i2++;
             }
+        }
+    }
 
-            /* check if the machine hostname is contained in the message hostname */
-            if (hostname[0] != '\0' && !strstr(c, short_needle) && !strstr(c, long_needle))
-            {
-                goto next_line;
-            }
+    /* Are we entering a call trace part? */
+    /* a call trace starts with "Call Trace:" or with the " [<.......>] function+0xFF/0xAA" pattern */
+    if (extractor->oopsstart >= 0 && !extractor->inbacktrace)
+    {
+        if (strcasestr(curline, "Call Trace:")) /* yes, it must be case-insensitive */
+            extractor->inbacktrace = 1;
+        else
+        /* Fatal MCE's have a few lines of useful information between
+         * first "Machine check exception:" line and the final "Kernel panic"
+         * line. Such oops, of course, is only detectable in kdumps (tested)
+         * or possibly pstore-saved logs (I did not try this yet).
+         * In order to capture all these lines, we treat final line
+         * as "backtrace" (which is admittedly a hack):
+         */
+        if (strstr(curline, "Kernel panic - not syncing:") && strcasestr(curline, "Machine check"))
+            extractor->inbacktrace = 1;
+        else
+        if (strnlen(curline, 9) > 8
+         && (  (curline[0] == '(' && curline[1] == '[' && curline[2] == '<')
+            || (curline[0] == '[' && curline[1] == '<'))
+         && strstr(curline, ">]")
+         && strstr(curline, "+0x")
+         && strstr(curline, "/0x")
+        ) {
+            extractor->inbacktrace = 1;
+        }
+    }
 
-            c = kernel_str + sizeof("kernel: ")-1;
+    /* Are we at the end of an oops? */
+    else if (extractor->oopsstart >= 0 && extractor->inbacktrace)
+    {
+        long oopsend = LONG_MAX;
+
+        /* line needs to start with " [" or have "] [" if it is still a call trace */
+        /* example: "[<ffffffffa006c156>] radeon_get_ring_head+0x16/0x41 [radeon]" */
+        /* example s390: "([<ffffffffa006c156>] 0xdeadbeaf)" */
+        if ((curline[0] != '[' && (curline[0] != '(' || curline[1] != '['))
+         && !strstr(curline, "] [")
+         && !strstr(curline, "--- Exception")
+         && !strstr(curline, "LR =")
+         && !strstr(curline, "<#DF>")
+         && !strstr(curline, "<IRQ>")
+         && !strstr(curline, "<EOI>")
+         && !strstr(curline, "<NMI>")
+         && !strstr(curline, "<<EOE>>")
+         && !strstr(curline, "Comm:")
+         && !strstr(curline, "Hardware name:")
+         && !strstr(curline, "Backtrace:")
+         && strncmp(curline, "Code: ", 6) != 0
+         && strncmp(curline, "RIP ", 4) != 0
+         && strncmp(curline, "RSP ", 4) != 0
+         /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
+          * which is followed by a single frame */
+         && strncmp(curline, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) != 0
+         /* ARM dumps registers intertwined with the backtrace */
+         && (extractor->parser->arm_regex_rc == 0 ? regexec(&extractor->parser->arm_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
+        ) {
+            oopsend = i-1; /* not a call trace line */
+        }
+        /* oops lines are always more than 8 chars long */
+        else if (strnlen(curline, 8) < 8)
+            oopsend = i-1;
+        /* single oopses are of the same loglevel */
+        else if (EXTRACTOR_LINE(extractor, i).level != extractor->prevlevel)
+            oopsend = i-1;
+        else if (strstr(curline, "Instruction dump:"))
+            oopsend = i;
+        /* kernel end-of-oops marker (not including marker itself) */
+        else if (strstr(curline, "---[ end trace"))
+            oopsend = i-1;
+        /* if a new oops starts, this one has ended */
+        else if (suspicious_line(extractor->parser, curline))
+            oopsend = i-1;
+
+        if (oopsend <= i)
+        {
+            log_debug("End of oops at line %ld (%ld): '%s'", oopsend, i, EXTRACTOR_LINE(extractor, oopsend).ptr);
+            record_oops(extractor->parser, oops_list, &EXTRACTOR_LINE(extractor, extractor->oopsstart),
+                        oopsend - extractor->oopsstart + 1);
+            extractor->oopsstart = -1;
+            extractor->inbacktrace = 0;
         }
+    }
 
-        /* store and remove kernel log level */
-        linelevel = abrt_koops_line_skip_level((const char **)&c);
-        abrt_koops_line_skip_jiffies((const char **)&c);
+    extractor->prevlevel = EXTRACTOR_LINE(extractor, i).level;
+    i++;
+    extractor->cur = i;
 
-        if ((lines_info_size & 0xfff) == 0)
+    if (extractor->oopsstart >= 0)
+    {
+        /* Do we have a suspiciously long oops? Cancel it.
+         * Bumped from 60 to 80 (see examples/oops_recursive_locking1.test)
+         */
+        if (i - extractor->oopsstart > 80)
+        {
+            extractor->inbacktrace = 0;
+            extractor->oopsstart = -1;
+            log_debug("Dropped oops, too long");
+        }
+        else if (!extractor->inbacktrace && i - extractor->oopsstart > 40)
         {
-            lines_info = g_realloc(lines_info, (lines_info_size + 0x1000) * sizeof(lines_info[0]));
+            /* Used to drop oopses w/o backtraces, but some of them
+             * (MCEs, for example) don't have backtrace yet we still want to file them.
+             */
+            log_debug("One-line oops at line %ld: '%s'", extractor->oopsstart,
+                      EXTRACTOR_LINE(extractor, extractor->oopsstart).ptr);
+            record_oops(extractor->parser, oops_list, &EXTRACTOR_LINE(extractor, extractor->oopsstart), 1);
+            /*inbacktrace = 0; - already is */
+            extractor->oopsstart = -1;
         }
-        lines_info[lines_info_size].ptr = c;
-        lines_info[lines_info_size].level = linelevel;
-        lines_info_size++;
-next_line:
-        c = c9 + 1;
     }
 
-    abrt_koops_extract_oopses_from_lines(oops_list, lines_info, lines_info_size);
-    free(lines_info);
+    return true;
 }
 
-void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
+static void extractor_add_line(struct abrt_koops_extractor *extractor, GList **oops_list,
+        const char *line, int level)
 {
-    /* Analyze lines */
-
-    int i;
-    char prevlevel = 0;
-    int oopsstart = -1;
-    int inbacktrace = 0;
-    regex_t arm_regex;
-    int arm_regex_rc = 0;
-
-    /* ARM backtrace regex, match a string similar to r7:df912310 */
-    arm_regex_rc = regcomp(&arm_regex, "r[[:digit:]]{1,}:[a-f[:digit:]]{8}", REG_EXTENDED | REG_NOSUB);
-
-    i = 0;
-    while (i < lines_info_size)
+    /* Nothing is pending, so a line which does not start an oops would be
+     * analyzed right away and never looked at again: skip storing it. This
+     * is the case of almost all lines of a log. */
+    if (extractor->oopsstart < 0 && extractor->cur == extractor->base + (long)extractor->lines_count)
     {
-        char *curline = lines_info[i].ptr;
-
-        if (curline == NULL)
-        {
-            i++;
-            continue;
-        }
+        const char *curline = line;
         while (*curline == ' ')
             curline++;
 
-        if (oopsstart < 0)
+        if (!suspicious_line(extractor->parser, curline))
         {
-            /* Find start-of-oops markers */
-            if (suspicious_line(curline))
-                oopsstart = i;
-
-            if (oopsstart >= 0)
-            {
-                /* debug information */
-                log_debug("Found oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-                /* try to find the end marker */
-                int i2 = i + 1;
-                while (i2 < lines_info_size && i2 < (i+50))
-                {
-                    if (strstr(lines_info[i2].ptr, "---[ end trace"))
-                    {
-                        inbacktrace = 1;
-                        i = i2;
-                        break;
-                    }
-                    i2++;
-                }
-            }
+            extractor_reset_lines(extractor);
+            extractor->prevlevel = level;
+            extractor->base++;
+            extractor->cur++;
+            return;
         }
+    }
 
-        /* Are we entering a call trace part? */
-        /* a call trace starts with "Call Trace:" or with the " [<.......>] function+0xFF/0xAA" pattern */
-        if (oopsstart >= 0 && !inbacktrace)
+    if (extractor->lines_count == extractor->lines_size)
+    {
+        /* Release the lines which have been analyzed and are not a part of
+         * the oops in progress */
+        const long keep = extractor->oopsstart >= 0 ? extractor->oopsstart : extractor->cur;
+        const unsigned drop = keep - extractor->base;
+        for (unsigned i = 0; i < drop; ++i)
+            free(extractor->lines[i].ptr);
+
+        if (drop != 0)
         {
-            if (strcasestr(curline, "Call Trace:")) /* yes, it must be case-insensitive */
-                inbacktrace = 1;
-            else
-            /* Fatal MCE's have a few lines of useful information between
-             * first "Machine check exception:" line and the final "Kernel panic"
-             * line. Such oops, of course, is only detectable in kdumps (tested)
-             * or possibly pstore-saved logs (I did not try this yet).
-             * In order to capture all these lines, we treat final line
-             * as "backtrace" (which is admittedly a hack):
-             */
-            if (strstr(curline, "Kernel panic - not syncing:") && strcasestr(curline, "Machine check"))
-                inbacktrace = 1;
-            else
-            if (strnlen(curline, 9) > 8
-             && (  (curline[0] == '(' && curline[1] == '[' && curline[2] == '<')
-                || (curline[0] == '[' && curline[1] == '<'))
-             && strstr(curline, ">]")
-             && strstr(curline, "+0x")
-             && strstr(curline, "/0x")
-            ) {
-                inbacktrace = 1;
-            }
+            extractor->lines_count -= drop;
+            memmove(extractor->lines, extractor->lines + drop,
+                    extractor->lines_count * sizeof(extractor->lines[0]));
+            extractor->base = keep;
         }
 
-        /* Are we at the end of an oops? */
-        else if (oopsstart >= 0 && inbacktrace)
+        if (extractor->lines_count == extractor->lines_size)
         {
-            int oopsend = INT_MAX;
-
-            /* line needs to start with " [" or have "] [" if it is still a call trace */
-            /* example: "[<ffffffffa006c156>] radeon_get_ring_head+0x16/0x41 [radeon]" */
-            /* example s390: "([<ffffffffa006c156>] 0xdeadbeaf)" */
-            if ((curline[0] != '[' && (curline[0] != '(' || curline[1] != '['))
-             && !strstr(curline, "] [")
-             && !strstr(curline, "--- Exception")
-             && !strstr(curline, "LR =")
-             && !strstr(curline, "<#DF>")
-             && !strstr(curline, "<IRQ>")
-             && !strstr(curline, "<EOI>")
-             && !strstr(curline, "<NMI>")
-             && !strstr(curline, "<<EOE>>")
-             && !strstr(curline, "Comm:")
-             && !strstr(curline, "Hardware name:")
-             && !strstr(curline, "Backtrace:")
-             && strncmp(curline, "Code: ", 6) != 0
-             && strncmp(curline, "RIP ", 4) != 0
-             && strncmp(curline, "RSP ", 4) != 0
-             /* s390 Call Trace ends with 'Last Breaking-Event-Address:'
-              * which is followed by a single frame */
-             && strncmp(curline, "Last Breaking-Event-Address:", strlen("Last Breaking-Event-Address:")) != 0
-             /* ARM dumps registers intertwined with the backtrace */
-             && (arm_regex_rc == 0 ? regexec(&arm_regex, curline, 0, NULL, 0) == REG_NOMATCH : 1)
-            ) {
-                oopsend = i-1; /* not a call trace line */
-            }
-            /* oops lines are always more than 8 chars long */
-            else if (strnlen(curline, 8) < 8)
-                oopsend = i-1;
-            /* single oopses are of the same loglevel */
-            else if (lines_info[i].level != prevlevel)
-                oopsend = i-1;
-            else if (strstr(curline, "Instruction dump:"))
-                oopsend = i;
-            /* kernel end-of-oops marker (not including marker itself) */
-            else if (strstr(curline, "---[ end trace"))
-                oopsend = i-1;
-            /* if a new oops starts, this one has ended */
-            else if (suspicious_line(curline))
-                oopsend = i-1;
-
-            if (oopsend <= i)
-            {
-                log_debug("End of oops at line %d (%d): '%s'", oopsend, i, lines_info[oopsend].ptr);
-                record_oops(oops_list, lines_info, oopsstart, oopsend);
-                oopsstart = -1;
-                inbacktrace = 0;
-            }
+            extractor->lines_size = extractor->lines_size ? extractor->lines_size * 2 : 256;
+            extractor->lines = g_realloc(extractor->lines,
+                    extractor->lines_size * sizeof(extractor->lines[0]));
         }
+    }
 
-        prevlevel = lines_info[i].level;
-        i++;
+    extractor->lines[extractor->lines_count].ptr = g_strndup(line, KOOPS_MAX_LINE_LEN);
+    extractor->lines[extractor->lines_count].level = level;
+    extractor->lines_count++;
 
-        if (oopsstart >= 0)
+    while (extractor_analyze_line(extractor, oops_list, /*at_end*/false))
+        ;
+}
+
+/*
+ * Filters out lines which do not come from the kernel of this machine,
+ * strips the syslog prefix, the log level and the jiffies.
+ */
+static void extractor_feed_line(struct abrt_koops_extractor *extractor, GList **oops_list, char *c)
+{
+    extractor->linecount++;
+
+    if (c[0] == '\0')
+        return;
+
+    /* Is it a syslog file (/var/log/messages or similar)?
+     * Even though _usually_ it looks like "Nov 19 12:34:38 localhost kernel: xxx",
+     * some users run syslog in non-C locale:
+     * "2010-02-22T09:24:08.156534-08:00 gnu-4 gnome-session[2048]: blah blah"
+     *  ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^ !!!
+     * We detect it by checking for N:NN:NN pattern in first 15 chars
+     * (and this still is not good enough... false positive: "pci 0000:15:00.0: PME# disabled")
+     */
+    char *colon = strchr(c, ':');
+    if (colon && colon > c && colon < c + 15
+     && isdigit(colon[-1]) /* N:... */
+     && isdigit(colon[1]) /* ...N:NN:... */
+     && isdigit(colon[2])
+     && colon[3] == ':'
+     && isdigit(colon[4]) /* ...N:NN:NN... */
+     && isdigit(colon[5])
+    ) {
+        /* It's syslog file, not a bare dmesg */
+
+        /* Skip non-kernel lines */
+        char *kernel_str = strstr(c, "kernel: ");
+        if (!kernel_str)
         {
-            /* Do we have a suspiciously long oops? Cancel it.
-             * Bumped from 60 to 80 (see examples/oops_recursive_locking1.test)
-             */
-            if (i - oopsstart > 80)
+            /* if we see our own marker:
+             * "hostname abrt: Kerneloops: Reported 1 kernel oopses to Abrt"
+             * we know we submitted everything upto here already */
+            if (strstr(c, "kernel oopses to Abrt"))
             {
-                inbacktrace = 0;
-                oopsstart = -1;
-                log_debug("Dropped oops, too long");
-                continue;
-            }
-            if (!inbacktrace && i - oopsstart > 40)
-            {
-                /* Used to drop oopses w/o backtraces, but some of them
-                 * (MCEs, for example) don't have backtrace yet we still want to file them.
-                 */
-                log_debug("One-line oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-                record_oops(oops_list, lines_info, oopsstart, oopsstart);
-                /*inbacktrace = 0; - already is */
-                oopsstart = -1;
-                continue;
+                log_debug("Found our marker at line %lu", extractor->linecount);
+                extractor_reset_lines(extractor);
+                g_list_free_full(g_steal_pointer(oops_list), free);
             }
+            return;
+        }
+
+        /* check if the machine hostname is contained in the message hostname */
+        if (extractor->hostname[0] != '\0'
+         && !strstr(c, extractor->short_needle) && !strstr(c, extractor->long_needle))
+        {
+            return;
         }
-    } /* while (i < lines_info_size) */
 
-    regfree(&arm_regex);
+        c = kernel_str + sizeof("kernel: ")-1;
+    }
+
+    /* store and remove kernel log level */
+    const int linelevel = abrt_koops_line_skip_level((const char **)&c);
+    abrt_koops_line_skip_jiffies((const char **)&c);
+
+    extractor_add_line(extractor, oops_list, c, linelevel);
+}
+
+void abrt_koops_extractor_feed(struct abrt_koops_extractor *extractor, GList **oops_list,
+        const char *data, size_t size)
+{
+    const char *const end = data + size;
+    while (data < end)
+    {
+        const char *eol = memchr(data, '\n', end - data);
+        const char *const line_end = eol ? eol : end;
+
+        GString *const line = extractor->partial_line;
+        if (line->len < KOOPS_MAX_LINE_LEN)
+            g_string_append_len(line, data, MIN((size_t)(line_end - data), KOOPS_MAX_LINE_LEN - line->len));
+
+        if (eol == NULL)
+            break;
+
+        extractor_feed_line(extractor, oops_list, line->str);
+        g_string_truncate(line, 0);
+        data = eol + 1;
+    }
+}
+
+void abrt_koops_extractor_feed_log_line(struct abrt_koops_extractor *extractor, GList **oops_list,
+        const char *line, size_t len)
+{
+    if (len != 0 && line[len - 1] == '\n')
+        --len;
+
+    /* The same as feeding the line followed by \n, the copy is needed only
+     * to terminate the line */
+    GString *const buf = extractor->partial_line;
+    if (buf->len < KOOPS_MAX_LINE_LEN)
+        g_string_append_len(buf, line, MIN(len, KOOPS_MAX_LINE_LEN - buf->len));
+
+    extractor_feed_line(extractor, oops_list, buf->str);
+    g_string_truncate(buf, 0);
+}
+
+void abrt_koops_extractor_feed_line(struct abrt_koops_extractor *extractor, GList **oops_list,
+        int level, const char *line)
+{
+    extractor->linecount++;
+
+    if (line[0] == '\0')
+        return;
+
+    extractor_add_line(extractor, oops_list, line, level);
+}
+
+bool abrt_koops_extractor_is_idle(const struct abrt_koops_extractor *extractor)
+{
+    return extractor->oopsstart < 0
+        && extractor->cur == extractor->base + (long)extractor->lines_count
+        && extractor->partial_line->len == 0;
+}
+
+bool abrt_koops_extractor_has_partial_line(const struct abrt_koops_extractor *extractor)
+{
+    return extractor->partial_line->len != 0;
+}
+
+void abrt_koops_extractor_finish(struct abrt_koops_extractor *extractor, GList **oops_list)
+{
+    /* The data do not have to end with \n */
+    if (extractor->partial_line->len != 0)
+    {
+        extractor_feed_line(extractor, oops_list, extractor->partial_line->str);
+        g_string_truncate(extractor->partial_line, 0);
+    }
+
+    while (extractor_analyze_line(extractor, oops_list, /*at_end*/true))
+        ;
 
     /* process last oops if we have one */
-    if (oopsstart >= 0)
+    if (extractor->oopsstart >= 0)
     {
-        if (inbacktrace)
+        if (extractor->inbacktrace)
         {
-            int oopsend = i-1;
-            log_debug("End of oops at line %d (end of file): '%s'", oopsend, lines_info[oopsend].ptr);
-            record_oops(oops_list, lines_info, oopsstart, oopsend);
+            const long oopsend = extractor->cur - 1;
+            log_debug("End of oops at line %ld (end of file): '%s'", oopsend,
+                      EXTRACTOR_LINE(extractor, oopsend).ptr);
+            record_oops(extractor->parser, oops_list, &EXTRACTOR_LINE(extractor, extractor->oopsstart),
+                        oopsend - extractor->oopsstart + 1);
         }
         else
         {
-            log_debug("One-line oops at line %d: '%s'", oopsstart, lines_info[oopsstart].ptr);
-            record_oops(oops_list, lines_info, oopsstart, oopsstart);
+            log_debug("One-line oops at line %ld: '%s'", extractor->oopsstart,
+                      EXTRACTOR_LINE(extractor, extractor->oopsstart).ptr);
+            record_oops(extractor->parser, oops_list, &EXTRACTOR_LINE(extractor, extractor->oopsstart), 1);
         }
     }
+
+    extractor_reset_lines(extractor);
+    extractor->linecount = 0;
+}
+
+void abrt_koops_parser_extract_oopses(const struct abrt_koops_parser *parser, GList **oops_list,
+        char *buffer, size_t buflen)
+{
+    struct abrt_koops_extractor *extractor = abrt_koops_extractor_new(parser);
+    abrt_koops_extractor_feed(extractor, oops_list, buffer, buflen);
+    abrt_koops_extractor_finish(extractor, oops_list);
+    abrt_koops_extractor_free(extractor);
+}
+
+void abrt_koops_extract_oopses(GList **oops_list, char *buffer, size_t buflen)
+{
+    abrt_koops_parser_extract_oopses(default_parser(), oops_list, buffer, buflen);
+}
+
+void abrt_koops_parser_extract_oopses_from_lines(const struct abrt_koops_parser *parser, GList **oops_list,
+        const struct abrt_koops_line_info *lines_info, int lines_info_size)
+{
+    struct abrt_koops_extractor *extractor = abrt_koops_extractor_new(parser);
+
+    for (int i = 0; i < lines_info_size; ++i)
+    {
+        if (lines_info[i].ptr != NULL)
+            extractor_add_line(extractor, oops_list, lines_info[i].ptr, lines_info[i].level);
+    }
+
+    abrt_koops_extractor_finish(extractor, oops_list);
+    abrt_koops_extractor_free(extractor);
+}
+
+void abrt_koops_extract_oopses_from_lines(GList **oops_list, const struct abrt_koops_line_info *lines_info, int lines_info_size)
+{
+    abrt_koops_parser_extract_oopses_from_lines(default_parser(), oops_list, lines_info, lines_info_size);
 }
 
 char *abrt_koops_hash_str_ext(const char *oops_buf, int frame_count, int duphash_flags)
@@ -620,59 +907,43 @@ char *abrt_koops_hash_str(const char *oops_buf)
     return abrt_koops_hash_str_ext(oops_buf, frame_count, duphash_flags);
 }
 
-char *abrt_koops_extract_version(const char *linepointer)
+char *abrt_koops_parser_extract_version(const struct abrt_koops_parser *parser, const char *linepointer)
 {
-    if (strstr(linepointer, "Pid")
-     || strstr(linepointer, "comm")
-     || strstr(linepointer, "CPU")
-     || strstr(linepointer, "REGS")
-     || strstr(linepointer, "EFLAGS")
-    ) {
-        /* "(4.7.0-2.x86_64.fc25) #"    */
-        /* " 4.7.0-2.x86_64.fc25 #"     */
-        /* " 2.6.3.4.5-2.x86_64.fc22 #" */
-        const char *regexp = "([ \\(]|kernel-)([0-9]+\\.[0-9]+\\.[0-9]+(\\.[^.-]+)*-[^ \\)]+)\\)? #";
-        regex_t re;
-        int r = regcomp(&re, regexp, REG_EXTENDED);
-        if (r != 0)
+    if (parser->version_regex_rc != 0)
+        return NULL;
+
+    if (abrt_string_matcher_find_str(parser->version_line_matcher, linepointer) < 0)
+        return NULL;
+
+    regmatch_t matchptr[3];
+    int r = regexec(&parser->version_regex, linepointer, sizeof(matchptr)/sizeof(matchptr[0]), matchptr, 0);
+    if (r != 0)
+    {
+        if (r != REG_NOMATCH)
         {
             char buf[LINE_MAX];
-            regerror(r, &re, buf, sizeof(buf));
-            error_msg("BUG: invalid kernel version regexp: %s", buf);
-            return NULL;
+            regerror(r, &parser->version_regex, buf, sizeof(buf));
+            error_msg("BUG: kernel version regexp failed: %s", buf);
         }
-
-        regmatch_t matchptr[3];
-        r = regexec(&re, linepointer, sizeof(matchptr)/sizeof(matchptr[0]), matchptr, 0);
-        if (r != 0)
+        else
         {
-            if (r != REG_NOMATCH)
-            {
-                char buf[LINE_MAX];
-                regerror(r, &re, buf, sizeof(buf));
-                error_msg("BUG: kernel version regexp failed: %s", buf);
-            }
-            else
-            {
-                log_debug("A kernel version candidate line didn't match kernel oops regexp:");
-                log_debug("\t'%s'", linepointer);
-            }
-
-            regfree(&re);
-            return NULL;
+            log_debug("A kernel version candidate line didn't match kernel oops regexp:");
+            log_debug("\t'%s'", linepointer);
         }
 
-        /* 0: entire string */
-        /* 1: version prefix */
-        /* 2: version string */
-        const regmatch_t *const ver = matchptr + 2;
-        char *ret = g_strndup(linepointer + ver->rm_so, ver->rm_eo - ver->rm_so);
-
-        regfree(&re);
-        return ret;
+        return NULL;
     }
 
-    return NULL;
+    /* 0: entire string */
+    /* 1: version prefix */
+    /* 2: version string */
+    const regmatch_t *const ver = matchptr + 2;
+    return g_strndup(linepointer + ver->rm_so, ver->rm_eo - ver->rm_so);
+}
+
+char *abrt_koops_extract_version(const char *linepointer)
+{
+    return abrt_koops_parser_extract_version(default_parser(), linepointer);
 }
 
 /* reading /proc/sys/kernel/tainted file after an oops is ALWAYS going
@@ -0,0 +1,190 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/* The initial size of the buffer */
+#define LINE_READER_BLOCK (64 * 1024)
+
+/* Longer lines are returned in pieces of this size, so that a file without
+ * new lines can't eat all memory */
+#define LINE_READER_MAX_LINE (1024 * 1024)
+
+/*
+ * The file is read into a buffer which grows only if a line does not fit.
+ *
+ * Log files are not mapped: logrotate's copytruncate may truncate a file
+ * while it is being read and touching a mapping beyond the end of the file
+ * raises SIGBUS. A truncated file just ends for read().
+ */
+struct abrt_line_reader
+{
+    int fd;
+
+    /* The buffer has one extra byte for the string terminator */
+    char *buf;
+    size_t buf_size;
+    bool eof;
+
+    /* A regular file is read only up to this offset, -1 for other files */
+    off_t size_limit;
+
+    /* [data, end) are the valid data which start at data_offset in the
+     * file, pos is the first byte which has not been returned yet */
+    char *data;
+    char *pos;
+    char *end;
+    off_t data_offset;
+};
+
+struct abrt_line_reader *abrt_line_reader_new(int fd)
+{
+    struct abrt_line_reader *reader = g_new0(struct abrt_line_reader, 1);
+    reader->fd = fd;
+
+    struct stat statbuf;
+    const off_t cur_pos = lseek(fd, 0, SEEK_CUR);
+    reader->size_limit = -1;
+    if (cur_pos >= 0 && fstat(fd, &statbuf) == 0 && S_ISREG(statbuf.st_mode))
+    {
+        reader->size_limit = statbuf.st_size;
+        posix_fadvise(fd, cur_pos, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    reader->buf_size = LINE_READER_BLOCK;
+    reader->buf = g_malloc(reader->buf_size + 1);
+    reader->data = reader->pos = reader->end = reader->buf;
+    reader->data_offset = (cur_pos >= 0 ? cur_pos : 0);
+
+    return reader;
+}
+
+void abrt_line_reader_free(struct abrt_line_reader *reader)
+{
+    if (reader == NULL)
+        return;
+
+    /* Leave the file position right after the last returned line, the same
+     * as if the file was read line by line. Pipes can't seek, of course. */
+    lseek(reader->fd, reader->data_offset + (reader->pos - reader->data), SEEK_SET);
+
+    free(reader->buf);
+    free(reader);
+}
+
+/*
+ * Moves the unreturned data to the beginning of the buffer and reads more
+ * data. Returns false if there are no more data.
+ */
+static bool line_reader_fill(struct abrt_line_reader *reader)
+{
+    if (reader->eof)
+        return false;
+
+    const size_t pending = reader->end - reader->pos;
+    reader->data_offset += reader->pos - reader->buf;
+    memmove(reader->buf, reader->pos, pending);
+    reader->data = reader->pos = reader->buf;
+    reader->end = reader->buf + pending;
+
+    if (pending == reader->buf_size)
+    {
+        reader->buf_size *= 2;
+        reader->buf = g_realloc(reader->buf, reader->buf_size + 1);
+        reader->data = reader->pos = reader->buf;
+        reader->end = reader->buf + pending;
+    }
+
+    size_t size = reader->buf_size - pending;
+    if (reader->size_limit >= 0)
+    {
+        /* Do not read the data appended after the reader was created */
+        const off_t end_offset = reader->data_offset + pending;
+        if (end_offset >= reader->size_limit)
+        {
+            reader->eof = true;
+            return false;
+        }
+        size = MIN(size, (size_t)(reader->size_limit - end_offset));
+    }
+
+    const ssize_t r = libreport_safe_read(reader->fd, reader->end, size);
+    if (r <= 0)
+    {
+        if (r < 0)
+            perror_msg("Can't read log file");
+        reader->eof = true;
+        return false;
+    }
+
+    reader->end += r;
+    return true;
+}
+
+const char *abrt_line_reader_next(struct abrt_line_reader *reader, size_t *len)
+{
+    /* Do not search the same bytes again after reading more data */
+    size_t searched = 0;
+    for (;;)
+    {
+        char *const line = reader->pos;
+        const size_t available = reader->end - line;
+        char *eol = memchr(line + searched, '\n', available - searched);
+
+        if (eol != NULL || (reader->eof && available != 0))
+        {
+            *len = (eol != NULL ? eol + 1 : reader->end) - line;
+            reader->pos = line + *len;
+            return line;
+        }
+
+        if (available >= LINE_READER_MAX_LINE)
+        {
+            *len = available;
+            reader->pos = reader->end;
+            return line;
+        }
+
+        searched = available;
+        if (!line_reader_fill(reader))
+        {
+            if (reader->pos == reader->end)
+                return NULL;
+            /* Return the last line without \n */
+        }
+    }
+}
+
+char *abrt_line_reader_next_str(struct abrt_line_reader *reader, size_t *len)
+{
+    size_t size;
+    const char *line = abrt_line_reader_next(reader, &size);
+    if (line == NULL)
+        return NULL;
+
+    if (size != 0 && line[size - 1] == '\n')
+        --size;
+
+    if (len != NULL)
+        *len = size;
+
+    /* The buffer is ours and it has room for the terminator after the last
+     * line, no copying is needed */
+    char *str = (char *)line;
+    str[size] = '\0';
+    return str;
+}
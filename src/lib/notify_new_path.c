@@ -24,7 +24,7 @@ void abrt_notify_new_path(const char *path)
     abrt_notify_new_path_with_response(path, NULL);
 }
 
-int abrt_notify_new_path_with_response(const char *path, char **message)
+static int connect_to_abrtd(void)
 {
     int retval;
     int fd = socket(AF_UNIX, SOCK_STREAM, 0);
@@ -48,15 +48,12 @@ int abrt_notify_new_path_with_response(const char *path, char **message)
         return retval;
     }
 
-    libreport_full_write_str(fd, "POST /creation_notification HTTP/1.1\r\n\r\n");
-    libreport_full_write_str(fd, path);
+    return fd;
+}
 
-    /*
-     * This sends FIN packet. Without it, close() may result in RST instead.
-     * Not really needed on AF_UNIX, just a bit of TCP-induced paranoia
-     * aka "good practice".
-     */
-    shutdown(fd, SHUT_WR);
+/* Reads the reply and closes the socket */
+static int read_response(int fd, char **message)
+{
     if (message == NULL)
     {
         close(fd);
@@ -107,3 +104,119 @@ int abrt_notify_new_path_with_response(const char *path, char **message)
     /* If code is greater than INT_MAX, -EBADMSG is returned. */
     return (int)code;
 }
+
+int abrt_notify_new_path_with_response(const char *path, char **message)
+{
+    int fd = connect_to_abrtd();
+    if (fd < 0)
+        return fd;
+
+    libreport_full_write_str(fd, "POST /creation_notification HTTP/1.1\r\n\r\n");
+    libreport_full_write_str(fd, path);
+
+    /*
+     * This sends FIN packet. Without it, close() may result in RST instead.
+     * Not really needed on AF_UNIX, just a bit of TCP-induced paranoia
+     * aka "good practice".
+     */
+    shutdown(fd, SHUT_WR);
+
+    return read_response(fd, message);
+}
+
+/* abrtd may close the socket if it rejects the problem, do not die of SIGPIPE */
+static int send_all(int fd, const void *buf, size_t len)
+{
+    while (len != 0)
+    {
+        ssize_t r = send(fd, buf, len, MSG_NOSIGNAL);
+        if (r < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -errno;
+        }
+
+        buf = (const char *)buf + r;
+        len -= r;
+    }
+
+    return 0;
+}
+
+int abrt_problem_socket_open(void)
+{
+    int fd = connect_to_abrtd();
+    if (fd < 0)
+        return fd;
+
+    int r = send_all(fd, ABRT_SOCKET_V2_MAGIC, ABRT_SOCKET_V2_MAGIC_LEN);
+    if (r < 0)
+    {
+        close(fd);
+        return r;
+    }
+
+    return fd;
+}
+
+/* Fills the element header followed by the name, returns its length */
+static size_t element_header(char *buf, unsigned type, const char *name, uint64_t size)
+{
+    struct abrt_socket_v2_element element = {
+        .type = type,
+        .name_len = strlen(name),
+        .size = size,
+    };
+
+    memcpy(buf, &element, sizeof(element));
+    memcpy(buf + sizeof(element), name, element.name_len);
+    return sizeof(element) + element.name_len;
+}
+
+int abrt_problem_socket_add_data(int sockfd, const char *name, const void *data, size_t size)
+{
+    if (strlen(name) > ABRT_SOCKET_V2_NAME_MAX)
+        return -ENAMETOOLONG;
+
+    char header[sizeof(struct abrt_socket_v2_element) + ABRT_SOCKET_V2_NAME_MAX];
+    const size_t len = element_header(header, ABRT_SOCKET_V2_DATA, name, size);
+
+    int r = send_all(sockfd, header, len);
+    if (r < 0)
+        return r;
+
+    return send_all(sockfd, data, size);
+}
+
+int abrt_problem_socket_add_fd(int sockfd, const char *name, int data_fd)
+{
+    if (strlen(name) > ABRT_SOCKET_V2_NAME_MAX)
+        return -ENAMETOOLONG;
+
+    char header[sizeof(struct abrt_socket_v2_element) + ABRT_SOCKET_V2_NAME_MAX];
+    const size_t len = element_header(header, ABRT_SOCKET_V2_FD, name, 0);
+
+    /* The descriptor comes with the first byte, the rest of the header may
+     * be sent separately */
+    int r = abrt_send_fds(sockfd, header, 1, &data_fd, 1);
+    if (r < 0)
+        return r;
+
+    return send_all(sockfd, header + 1, len - 1);
+}
+
+int abrt_problem_socket_close(int sockfd, char **message)
+{
+    char header[sizeof(struct abrt_socket_v2_element)];
+    const size_t len = element_header(header, ABRT_SOCKET_V2_END, "", 0);
+
+    int r = send_all(sockfd, header, len);
+    if (r < 0)
+    {
+        close(sockfd);
+        return r;
+    }
+
+    return read_response(sockfd, message);
+}
@@ -0,0 +1,125 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <sys/socket.h>
+#include "libabrt.h"
+
+int abrt_send_fds(int sockfd, const void *buf, size_t len, const int *fds, unsigned fds_count)
+{
+    /* At least one byte of real data must accompany the ancillary data,
+     * otherwise the message is not delivered on SOCK_STREAM sockets.
+     */
+    if (len == 0 || fds_count > ABRT_PASS_FD_MAX)
+        return -EINVAL;
+
+    struct iovec iov = {
+        .iov_base = (void *)buf,
+        .iov_len = len,
+    };
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * ABRT_PASS_FD_MAX)];
+        struct cmsghdr align;
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+
+    if (fds_count != 0)
+    {
+        msg.msg_control = control.buf;
+        msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds_count);
+
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds_count);
+        memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fds_count);
+    }
+
+    ssize_t r;
+    do
+        r = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+    while (r < 0 && errno == EINTR);
+
+    if (r < 0)
+        return -errno;
+
+    return 0;
+}
+
+ssize_t abrt_recv_fds(int sockfd, void *buf, size_t len, int *fds, unsigned *fds_count)
+{
+    const unsigned fds_max = *fds_count;
+    *fds_count = 0;
+
+    struct iovec iov = {
+        .iov_base = buf,
+        .iov_len = len,
+    };
+
+    union {
+        char buf[CMSG_SPACE(sizeof(int) * ABRT_PASS_FD_MAX)];
+        struct cmsghdr align;
+    } control;
+
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t r;
+    do
+        r = recvmsg(sockfd, &msg, MSG_CMSG_CLOEXEC);
+    while (r < 0 && errno == EINTR);
+
+    if (r < 0)
+        return -errno;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+            continue;
+
+        const unsigned received = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const int *data = (const int *)CMSG_DATA(cmsg);
+        for (unsigned i = 0; i < received; ++i)
+        {
+            int fd;
+            memcpy(&fd, data + i, sizeof(fd));
+
+            /* Do not leak descriptors the caller has no room for */
+            if (*fds_count < fds_max)
+                fds[(*fds_count)++] = fd;
+            else
+            {
+                log_warning("Closing unexpected passed file descriptor %d", fd);
+                close(fd);
+            }
+        }
+    }
+
+    if (msg.msg_flags & MSG_CTRUNC)
+        log_warning("Some passed file descriptors were discarded by the kernel");
+
+    return r;
+}
@@ -0,0 +1,179 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/* Initial buffer sizes, enough for the files of most processes */
+#define CGROUP_BUFFER_SIZE (4 * 1024)
+#define MOUNTINFO_BUFFER_SIZE (32 * 1024)
+
+/* The namespaces of init never change, /proc/1 is opened only once */
+static int init_proc_dir_fd = -1;
+
+/*
+ * Reads the whole file in the process directory into a buffer of the given
+ * initial size. Returns NULL if the file can't be read.
+ */
+static char *read_proc_file_at(int proc_dir_fd, const char *name, size_t size)
+{
+    int fd = openat(proc_dir_fd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return NULL;
+
+    char *buf = g_malloc(size);
+    size_t len = 0;
+    for (;;)
+    {
+        if (len + 1 >= size)
+        {
+            size *= 2;
+            buf = g_realloc(buf, size);
+        }
+
+        const ssize_t r = libreport_safe_read(fd, buf + len, size - len - 1);
+        if (r < 0)
+        {
+            log_debug("Can't read '%s': %s", name, strerror(errno));
+            g_free(buf);
+            close(fd);
+            return NULL;
+        }
+        if (r == 0)
+            break;
+
+        len += r;
+    }
+
+    close(fd);
+    buf[len] = '\0';
+    return buf;
+}
+
+/*
+ * Closes the stream opened by open_memstream() for one of the libreport
+ * dumpers and returns its content, NULL if the dumper failed.
+ */
+static char *finish_dump(FILE *stream, char **content, bool failed)
+{
+    fclose(stream);
+    if (failed)
+    {
+        free(*content);
+        *content = NULL;
+    }
+
+    return *content;
+}
+
+struct abrt_proc_snapshot *abrt_proc_snapshot_new(pid_t pid)
+{
+    const int proc_dir_fd = libreport_open_proc_pid_dir(pid);
+    if (proc_dir_fd < 0)
+        return NULL;
+
+    struct abrt_proc_snapshot *snapshot = g_new0(struct abrt_proc_snapshot, 1);
+    snapshot->pid = pid;
+
+    /* The process may be disappearing, read its files before anything else
+     * and save them later */
+    snapshot->cmdline = libreport_get_cmdline_at(proc_dir_fd);
+    snapshot->environ = libreport_get_environ_at(proc_dir_fd);
+    snapshot->cgroup = read_proc_file_at(proc_dir_fd, "cgroup", CGROUP_BUFFER_SIZE);
+    snapshot->mountinfo = read_proc_file_at(proc_dir_fd, "mountinfo", MOUNTINFO_BUFFER_SIZE);
+
+    char *content = NULL;
+    size_t size = 0;
+    FILE *stream = open_memstream(&content, &size);
+    if (stream != NULL)
+        snapshot->open_fds = finish_dump(stream, &content, libreport_dump_fd_info_at(proc_dir_fd, stream) < 0);
+
+    if (init_proc_dir_fd < 0)
+    {
+        init_proc_dir_fd = libreport_open_proc_pid_dir(1);
+        if (init_proc_dir_fd >= 0)
+            libreport_close_on_exec_on(init_proc_dir_fd);
+    }
+
+    content = NULL;
+    stream = (init_proc_dir_fd >= 0) ? open_memstream(&content, &size) : NULL;
+    if (stream != NULL)
+        snapshot->namespaces = finish_dump(stream, &content,
+                libreport_dump_namespace_diff_at(init_proc_dir_fd, proc_dir_fd, stream) < 0);
+
+    /* Obtain the root directory path only if process' root directory is
+     * not the same as the init's root directory
+     */
+    if (libreport_process_has_own_root_at(proc_dir_fd))
+    {
+        snapshot->rootdir = libreport_get_rootdir_at(proc_dir_fd);
+
+        /* The root directory path '/' means that the process has mounted its
+         * own root in its own MOUNT namespace, i.e. it is containerized */
+        pid_t container_pid;
+        if (snapshot->rootdir != NULL && strcmp(snapshot->rootdir, "/") == 0)
+        {
+            log_debug("Process %d is considered to be containerized", pid);
+            if (libreport_get_pid_of_container_at(proc_dir_fd, &container_pid) == 0)
+                snapshot->container_cmdline = libreport_get_cmdline(container_pid);
+        }
+    }
+
+    close(proc_dir_fd);
+    return snapshot;
+}
+
+void abrt_proc_snapshot_save(const struct abrt_proc_snapshot *snapshot, struct dump_dir *dd)
+{
+    const struct
+    {
+        const char *name;
+        const char *content;
+    } items[] = {
+        { FILENAME_CMDLINE,    snapshot->cmdline },
+        { FILENAME_ENVIRON,    snapshot->environ },
+        { FILENAME_CGROUP,     snapshot->cgroup },
+        { FILENAME_MOUNTINFO,  snapshot->mountinfo },
+        { FILENAME_OPEN_FDS,   snapshot->open_fds },
+        { FILENAME_NAMESPACES, snapshot->namespaces },
+        { FILENAME_CONTAINER_CMDLINE, snapshot->container_cmdline },
+        /* A chrooted process */
+        { FILENAME_ROOTDIR, (snapshot->rootdir != NULL && strcmp(snapshot->rootdir, "/") != 0)
+                            ? snapshot->rootdir : NULL },
+    };
+
+    for (size_t i = 0; i < G_N_ELEMENTS(items); ++i)
+    {
+        if (items[i].content != NULL)
+            dd_save_text(dd, items[i].name, items[i].content);
+    }
+}
+
+void abrt_proc_snapshot_free(struct abrt_proc_snapshot *snapshot)
+{
+    if (snapshot == NULL)
+        return;
+
+    free(snapshot->cmdline);
+    free(snapshot->environ);
+    g_free(snapshot->cgroup);
+    g_free(snapshot->mountinfo);
+    free(snapshot->open_fds);
+    free(snapshot->namespaces);
+    free(snapshot->rootdir);
+    free(snapshot->container_cmdline);
+    free(snapshot);
+}
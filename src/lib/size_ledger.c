@@ -0,0 +1,223 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/*
+ * The ledger remembers sizes of all entries of a directory, so the total
+ * size of the directory and the best candidate for deletion can be found
+ * without walking the whole tree again. Sizes of sub-directories are
+ * measured recursively, sizes of regular files are taken from stat.
+ * Other kinds of files are not accounted, the same as in
+ * libreport_get_dirsize_find_largest_dir().
+ *
+ * Events save elements by creating new files, which changes the modification
+ * time of the problem directory, hence the recorded time is enough to find
+ * out whether the size has to be measured again.
+ */
+struct ledger_entry
+{
+    double size;
+    struct timespec mtim;
+    bool is_dir;
+};
+
+struct abrt_size_ledger
+{
+    char *path;
+    /* entry name -> struct ledger_entry */
+    GHashTable *entries;
+    double total;
+};
+
+static void ledger_drop_entry(struct abrt_size_ledger *ledger, const char *name)
+{
+    struct ledger_entry *entry = g_hash_table_lookup(ledger->entries, name);
+    if (entry == NULL)
+        return;
+
+    ledger->total -= entry->size;
+    g_hash_table_remove(ledger->entries, name);
+}
+
+void abrt_size_ledger_update(struct abrt_size_ledger *ledger, const char *name)
+{
+    if (libreport_dot_or_dotdot(name) || strchr(name, '/') != NULL)
+        return;
+
+    ledger_drop_entry(ledger, name);
+
+    g_autofree char *full_name = g_build_filename(ledger->path, name, NULL);
+    struct stat statbuf;
+    if (lstat(full_name, &statbuf) != 0)
+        return;
+
+    struct ledger_entry *entry = g_new(struct ledger_entry, 1);
+    entry->mtim = statbuf.st_mtim;
+    entry->is_dir = S_ISDIR(statbuf.st_mode);
+    if (entry->is_dir)
+        entry->size = libreport_get_dirsize(full_name);
+    else if (S_ISREG(statbuf.st_mode))
+        entry->size = statbuf.st_size;
+    else
+        entry->size = 0;
+
+    ledger->total += entry->size;
+    g_hash_table_insert(ledger->entries, g_strdup(name), entry);
+}
+
+void abrt_size_ledger_remove(struct abrt_size_ledger *ledger, const char *name)
+{
+    ledger_drop_entry(ledger, name);
+}
+
+void abrt_size_ledger_reset(struct abrt_size_ledger *ledger)
+{
+    g_hash_table_remove_all(ledger->entries);
+    ledger->total = 0;
+
+    DIR *dp = opendir(ledger->path);
+    if (dp == NULL)
+        return;
+
+    struct dirent *dent;
+    while ((dent = readdir(dp)) != NULL)
+        abrt_size_ledger_update(ledger, dent->d_name);
+
+    closedir(dp);
+}
+
+struct abrt_size_ledger *abrt_size_ledger_new(const char *path)
+{
+    struct abrt_size_ledger *ledger = g_new(struct abrt_size_ledger, 1);
+    ledger->path = g_strdup(path);
+    ledger->entries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    ledger->total = 0;
+
+    abrt_size_ledger_reset(ledger);
+
+    return ledger;
+}
+
+void abrt_size_ledger_free(struct abrt_size_ledger *ledger)
+{
+    if (ledger == NULL)
+        return;
+
+    g_hash_table_destroy(ledger->entries);
+    free(ledger->path);
+    free(ledger);
+}
+
+void abrt_size_ledger_refresh(struct abrt_size_ledger *ledger)
+{
+    /* The table cannot be modified while it is being iterated */
+    GPtrArray *stale = g_ptr_array_new_with_free_func(g_free);
+
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, ledger->entries);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const char *name = (const char *)key;
+        const struct ledger_entry *entry = (const struct ledger_entry *)value;
+
+        g_autofree char *full_name = g_build_filename(ledger->path, name, NULL);
+        struct stat statbuf;
+        if (lstat(full_name, &statbuf) != 0
+            || statbuf.st_mtim.tv_sec != entry->mtim.tv_sec
+            || statbuf.st_mtim.tv_nsec != entry->mtim.tv_nsec)
+        {
+            g_ptr_array_add(stale, g_strdup(name));
+        }
+    }
+
+    for (guint i = 0; i < stale->len; ++i)
+    {
+        log_debug("Measuring '%s' again", (const char *)stale->pdata[i]);
+        abrt_size_ledger_update(ledger, stale->pdata[i]);
+    }
+
+    g_ptr_array_free(stale, TRUE);
+}
+
+const char *abrt_size_ledger_get_path(const struct abrt_size_ledger *ledger)
+{
+    return ledger->path;
+}
+
+double abrt_size_ledger_get_total(const struct abrt_size_ledger *ledger)
+{
+    /* Avoid negative totals caused by rounding errors */
+    return ledger->total > 0 ? ledger->total : 0;
+}
+
+static bool is_excluded(const char *name, const char *const *excluded)
+{
+    /* Skip anything named "<dirname>.new", such directories are still being
+     * created (abrt-server and the hooks rename them once they are complete).
+     */
+    const char *ext = strrchr(name, '.');
+    if (ext != NULL && strcmp(ext, ".new") == 0)
+        return true;
+
+    for (; excluded != NULL && *excluded != NULL; ++excluded)
+    {
+        if (strcmp(name, *excluded) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+char *abrt_size_ledger_find_worst_dir(const struct abrt_size_ledger *ledger,
+        const char *const *excluded)
+{
+    const time_t cur_time = time(NULL);
+    const char *worst = NULL;
+    double worst_weight = 0;
+
+    /* The weight depends on the current time, so the order of directories
+     * changes over time and cannot be kept sorted. This is a single pass over
+     * the ledger kept in memory; no file is touched.
+     */
+    GHashTableIter iter;
+    gpointer key, value;
+    g_hash_table_iter_init(&iter, ledger->entries);
+    while (g_hash_table_iter_next(&iter, &key, &value))
+    {
+        const char *name = (const char *)key;
+        const struct ledger_entry *entry = (const struct ledger_entry *)value;
+        if (!entry->is_dir || is_excluded(name, excluded))
+            continue;
+
+        /* Calculate "weighted" size and age
+         * w = sz_kbytes * age_mins */
+        double weight = entry->size / 1024;
+        const long age = (cur_time - entry->mtim.tv_sec) / 60;
+        if (age > 1)
+            weight *= age;
+
+        if (weight > worst_weight)
+        {
+            worst_weight = weight;
+            worst = name;
+        }
+    }
+
+    return g_strdup(worst);
+}
@@ -0,0 +1,61 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+int abrt_save_state_file(const char *file_name, const char *data, mode_t mode)
+{
+    g_autofree char *tmp_file_name = g_strdup_printf("%s.tmp", file_name);
+    int state_fd = open(tmp_file_name, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW, mode);
+    if (state_fd < 0)
+    {
+        perror_msg("open('%s')", tmp_file_name);
+        return -1;
+    }
+
+    if (libreport_full_write_str(state_fd, data) != strlen(data) || fsync(state_fd) != 0)
+    {
+        perror_msg("write('%s')", tmp_file_name);
+        close(state_fd);
+        unlink(tmp_file_name);
+        return -1;
+    }
+    close(state_fd);
+
+    if (rename(tmp_file_name, file_name) != 0)
+    {
+        perror_msg("rename('%s', '%s')", tmp_file_name, file_name);
+        unlink(tmp_file_name);
+        return -1;
+    }
+
+    /* The rename is not durable until the directory entry is written */
+    g_autofree char *dir_name = g_path_get_dirname(file_name);
+    const int dir_fd = open(dir_name, O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0)
+    {
+        perror_msg("open('%s')", dir_name);
+        return -1;
+    }
+
+    const int r = fsync(dir_fd);
+    if (r != 0)
+        perror_msg("fsync('%s')", dir_name);
+    close(dir_fd);
+
+    return r == 0 ? 0 : -1;
+}
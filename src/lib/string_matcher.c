@@ -0,0 +1,221 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/*
+ * Aho-Corasick automaton compiled into a deterministic state machine, so
+ * every input byte costs exactly one table lookup regardless of the number
+ * of patterns.
+ *
+ * Bytes which do not occur in any pattern share a single input class, which
+ * keeps the transition table small: the patterns we search for are short
+ * English phrases made of a few dozens of distinct characters.
+ */
+struct abrt_string_matcher
+{
+    /* byte -> input class, class 0 is for bytes not used by any pattern */
+    unsigned char byte_class[256];
+    unsigned class_count;
+    /* state * class_count + class -> state, state 0 is the root */
+    unsigned *delta;
+    /* state -> index of a pattern which ends in the state or -1 */
+    int *match;
+    unsigned state_count;
+};
+
+static unsigned matcher_add_state(struct abrt_string_matcher *matcher, unsigned *allocated)
+{
+    if (matcher->state_count == *allocated)
+    {
+        *allocated = *allocated ? *allocated * 2 : 64;
+        matcher->delta = g_realloc_n(matcher->delta, (gsize)*allocated * matcher->class_count,
+                                     sizeof(matcher->delta[0]));
+        matcher->match = g_realloc_n(matcher->match, *allocated, sizeof(matcher->match[0]));
+    }
+
+    const unsigned state = matcher->state_count++;
+    memset(matcher->delta + (gsize)state * matcher->class_count, 0,
+           matcher->class_count * sizeof(matcher->delta[0]));
+    matcher->match[state] = -1;
+
+    return state;
+}
+
+static void matcher_add_pattern(struct abrt_string_matcher *matcher, unsigned *allocated,
+        const char *pattern, int index)
+{
+    unsigned state = 0;
+    for (const unsigned char *p = (const unsigned char *)pattern; *p; ++p)
+    {
+        unsigned *next = matcher->delta + (gsize)state * matcher->class_count + matcher->byte_class[*p];
+        /* The root is never a target of a trie edge, so 0 means "no edge" */
+        if (*next == 0)
+        {
+            const unsigned new_state = matcher_add_state(matcher, allocated);
+            /* matcher->delta might have been moved */
+            next = matcher->delta + (gsize)state * matcher->class_count + matcher->byte_class[*p];
+            *next = new_state;
+        }
+        state = *next;
+    }
+
+    /* Keep the first one of duplicated patterns */
+    if (matcher->match[state] < 0)
+        matcher->match[state] = index;
+}
+
+/*
+ * Turns the trie into the automaton: computes failure links in breadth-first
+ * order and replaces missing edges by the edges of the failure state.
+ */
+static void matcher_build_automaton(struct abrt_string_matcher *matcher)
+{
+    const unsigned class_count = matcher->class_count;
+    unsigned *fail = g_new0(unsigned, matcher->state_count);
+    unsigned *queue = g_new(unsigned, matcher->state_count);
+    unsigned head = 0;
+    unsigned tail = 0;
+
+    for (unsigned c = 0; c < class_count; ++c)
+    {
+        const unsigned child = matcher->delta[c];
+        if (child != 0)
+        {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+
+    while (head < tail)
+    {
+        const unsigned state = queue[head++];
+        const unsigned *fail_row = matcher->delta + (gsize)fail[state] * class_count;
+        unsigned *row = matcher->delta + (gsize)state * class_count;
+
+        /* Patterns ending in the failure state end in this state too */
+        if (matcher->match[state] < 0)
+            matcher->match[state] = matcher->match[fail[state]];
+
+        for (unsigned c = 0; c < class_count; ++c)
+        {
+            if (row[c] != 0)
+            {
+                fail[row[c]] = fail_row[c];
+                queue[tail++] = row[c];
+            }
+            else
+                row[c] = fail_row[c];
+        }
+    }
+
+    free(queue);
+    free(fail);
+}
+
+struct abrt_string_matcher *abrt_string_matcher_new(const char *const *patterns, size_t count)
+{
+    struct abrt_string_matcher *matcher = g_new0(struct abrt_string_matcher, 1);
+
+    matcher->class_count = 1;
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (const unsigned char *p = (const unsigned char *)patterns[i]; *p; ++p)
+        {
+            if (matcher->byte_class[*p] == 0)
+                matcher->byte_class[*p] = matcher->class_count++;
+        }
+    }
+
+    unsigned allocated = 0;
+    matcher_add_state(matcher, &allocated);
+
+    for (size_t i = 0; i < count; ++i)
+        matcher_add_pattern(matcher, &allocated, patterns[i], (int)i);
+
+    matcher_build_automaton(matcher);
+
+    return matcher;
+}
+
+struct abrt_string_matcher *abrt_string_matcher_new_from_list(GList *patterns)
+{
+    const guint count = g_list_length(patterns);
+    const char **array = g_new(const char *, count + 1);
+
+    guint i = 0;
+    for (GList *l = patterns; l != NULL; l = l->next)
+        array[i++] = (const char *)l->data;
+    array[i] = NULL;
+
+    struct abrt_string_matcher *matcher = abrt_string_matcher_new(array, count);
+    free(array);
+
+    return matcher;
+}
+
+void abrt_string_matcher_free(struct abrt_string_matcher *matcher)
+{
+    if (matcher == NULL)
+        return;
+
+    free(matcher->delta);
+    free(matcher->match);
+    free(matcher);
+}
+
+int abrt_string_matcher_find(const struct abrt_string_matcher *matcher,
+        const char *buf, size_t size)
+{
+    /* An empty pattern is found everywhere, the same as strstr() does */
+    if (matcher->match[0] >= 0)
+        return matcher->match[0];
+
+    const unsigned *delta = matcher->delta;
+    const unsigned class_count = matcher->class_count;
+    const unsigned char *p = (const unsigned char *)buf;
+    const unsigned char *const end = p + size;
+
+    unsigned state = 0;
+    for (; p < end; ++p)
+    {
+        state = delta[state * class_count + matcher->byte_class[*p]];
+        if (matcher->match[state] >= 0)
+            return matcher->match[state];
+    }
+
+    return -1;
+}
+
+int abrt_string_matcher_find_str(const struct abrt_string_matcher *matcher, const char *str)
+{
+    if (matcher->match[0] >= 0)
+        return matcher->match[0];
+
+    const unsigned *delta = matcher->delta;
+    const unsigned class_count = matcher->class_count;
+
+    unsigned state = 0;
+    for (const unsigned char *p = (const unsigned char *)str; *p; ++p)
+    {
+        state = delta[state * class_count + matcher->byte_class[*p]];
+        if (matcher->match[state] >= 0)
+            return matcher->match[state];
+    }
+
+    return -1;
+}
@@ -0,0 +1,108 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+struct symbol_cache_entry
+{
+    char *name;
+    off_t size;
+    time_t used;
+};
+
+static int symbol_cache_entry_cmp(const void *a, const void *b)
+{
+    const struct symbol_cache_entry *const ea = a;
+    const struct symbol_cache_entry *const eb = b;
+
+    if (ea->used != eb->used)
+        return ea->used < eb->used ? -1 : 1;
+    return strcmp(ea->name, eb->name);
+}
+
+const char *abrt_symbol_cache_dir(void)
+{
+    if (abrt_g_settings_symbol_cache_size == 0)
+        return NULL;
+
+    /* Not an error, the cache is not shared with users who can't read all
+     * problems */
+    if (access(SYMBOL_CACHE_DIR, R_OK | W_OK | X_OK) != 0)
+    {
+        log_debug("Symbol cache '%s' is not accessible: %s", SYMBOL_CACHE_DIR, strerror(errno));
+        return NULL;
+    }
+
+    return SYMBOL_CACHE_DIR;
+}
+
+void abrt_symbol_cache_trim(const char *dirname, off_t cap_size)
+{
+    DIR *dir = opendir(dirname);
+    if (dir == NULL)
+    {
+        perror_msg("Can't open symbol cache '%s'", dirname);
+        return;
+    }
+
+    GArray *entries = g_array_new(FALSE, FALSE, sizeof(struct symbol_cache_entry));
+    off_t total = 0;
+
+    struct dirent *dent;
+    while ((dent = readdir(dir)) != NULL)
+    {
+        struct stat statbuf;
+        if (fstatat(dirfd(dir), dent->d_name, &statbuf, AT_SYMLINK_NOFOLLOW) != 0
+         || !S_ISREG(statbuf.st_mode))
+        {
+            continue;
+        }
+
+        /* Files are never rewritten, they are just read by gdb; reading
+         * updates atime at least once a day even with relatime */
+        struct symbol_cache_entry entry = {
+            .name = g_strdup(dent->d_name),
+            .size = statbuf.st_blocks * 512,
+            .used = MAX(statbuf.st_atime, statbuf.st_mtime),
+        };
+        g_array_append_val(entries, entry);
+        total += entry.size;
+    }
+
+    if (total > cap_size)
+    {
+        /* Least recently used first */
+        g_array_sort(entries, symbol_cache_entry_cmp);
+
+        for (guint i = 0; i < entries->len && total > cap_size; ++i)
+        {
+            struct symbol_cache_entry *const entry = &g_array_index(entries, struct symbol_cache_entry, i);
+            log_info("Removing '%s' from symbol cache", entry->name);
+            if (unlinkat(dirfd(dir), entry->name, 0) != 0 && errno != ENOENT)
+            {
+                perror_msg("Can't remove '%s/%s'", dirname, entry->name);
+                continue;
+            }
+            total -= entry->size;
+        }
+    }
+
+    for (guint i = 0; i < entries->len; ++i)
+        free(g_array_index(entries, struct symbol_cache_entry, i).name);
+    g_array_free(entries, TRUE);
+    closedir(dir);
+}
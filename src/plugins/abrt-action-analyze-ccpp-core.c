@@ -0,0 +1,173 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include <satyr/core/stacktrace.h>
+#include <satyr/core/unwind.h>
+#include <satyr/utils.h>
+
+#include "core-utils.h"
+#include "libabrt.h"
+
+/* The value 240 was taken from abrt-action-generate-backtrace.c. */
+#define GDB_TIMEOUT_SEC 240
+
+/*
+ * Does the same as abrt-action-generate-core-backtrace, but keeps the
+ * stacktrace for the other elements instead of parsing the saved JSON again.
+ */
+static struct sr_core_stacktrace *generate_core_backtrace(struct dump_dir *dd,
+                                                          const char *coredump_path)
+{
+    /* Let user know what's going on */
+    log_notice(_("Generating core_backtrace"));
+
+    g_autofree char *executable = dd_load_text(dd, FILENAME_EXECUTABLE);
+    g_autofree char *error_message = NULL;
+
+#ifdef ENABLE_NATIVE_UNWINDER
+    struct sr_core_stacktrace *stacktrace = sr_parse_coredump(coredump_path, executable, &error_message);
+#else /* ENABLE_NATIVE_UNWINDER */
+    g_autofree char *gdb_output = abrt_get_backtrace(dd, GDB_TIMEOUT_SEC, NULL);
+    if (!gdb_output)
+    {
+        log_warning(_("Error: GDB did not return any data"));
+        return NULL;
+    }
+
+    struct sr_core_stacktrace *stacktrace = sr_core_stacktrace_from_gdb(gdb_output,
+                                                    coredump_path, executable, &error_message);
+#endif /* ENABLE_NATIVE_UNWINDER */
+
+    if (!stacktrace)
+    {
+        log_warning(_("Error: %s"), error_message);
+        return NULL;
+    }
+
+    g_autofree char *json = sr_core_stacktrace_to_json(stacktrace);
+    /* Add newline to the end of core stacktrace file to make text editors happy */
+    g_autofree char *text = g_strconcat(json, "\n", NULL);
+    dd_save_text(dd, FILENAME_CORE_BACKTRACE, text);
+
+    return stacktrace;
+}
+
+int main(int argc, char **argv)
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    const char *dump_dir_name = ".";
+    const char *maps_file = NULL;
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-v] [-m MAPS_FILE] -d DIR\n"
+        "\n"
+        "Generates core_backtrace if it is missing, calculates UUID and finds\n"
+        "crash_function of coredump in problem directory DIR and saves the\n"
+        "packages of the files listed in MAPS_FILE as dso_list"
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_d = 1 << 1,
+        OPT_m = 1 << 2,
+    };
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&libreport_g_verbose),
+        OPT_STRING('d', NULL, &dump_dir_name, "DIR", _("Problem directory")),
+        OPT_STRING('m', NULL, &maps_file, "MAPS_FILE", _("Name of /proc/PID/maps element in problem directory")),
+        OPT_END()
+    };
+    /*unsigned opts =*/ libreport_parse_opts(argc, argv, program_options, program_usage_string);
+
+    libreport_export_abrt_envvars(0);
+
+    /* SymbolCacheSize */
+    abrt_load_abrt_conf();
+
+    if (libreport_g_verbose > 1)
+        sr_debug_parser = true;
+
+    struct dump_dir *dd = dd_opendir(dump_dir_name, /*flags:*/ 0);
+    if (!dd)
+        return 1;
+
+    /* A compressed core is unpacked once, abrt_get_backtrace() and
+     * abrt_run_unstrip_n() share the unpacked file */
+    char *coredump_path = abrt_coredump_acquire(dd->dd_dirname);
+    const bool has_coredump = coredump_path != NULL && access(coredump_path, R_OK) == 0;
+
+    /* If core_backtrace can't be generated, the UUID is still computed */
+    struct sr_core_stacktrace *stacktrace = NULL;
+    g_autofree char *core_backtrace_json = dd_load_text_ext(dd, FILENAME_CORE_BACKTRACE,
+                                                 DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE
+                                                 | DD_FAIL_QUIETLY_ENOENT);
+    if (core_backtrace_json)
+        stacktrace = abrt_core_stacktrace_from_json(core_backtrace_json);
+    else if (has_coredump)
+        stacktrace = generate_core_backtrace(dd, coredump_path);
+
+    char *build_ids = NULL;
+    if (has_coredump)
+        build_ids = abrt_run_unstrip_n(dd->dd_dirname, /*timeout_sec:*/ 30);
+
+    abrt_coredump_release(dd->dd_dirname, coredump_path);
+
+    if (build_ids)
+        abrt_core_trim_unstrip_output(build_ids, build_ids);
+    else if (stacktrace)
+        build_ids = abrt_core_build_ids_from_stacktrace(stacktrace);
+
+    abrt_core_save_uuid(dd, build_ids);
+    free(build_ids);
+
+    /* Normalizes the crash thread, must be the last use of the stacktrace */
+    if (stacktrace)
+    {
+        abrt_core_save_crash_function(dd, stacktrace);
+        sr_core_stacktrace_free(stacktrace);
+    }
+
+    int ret = 0;
+    if (maps_file)
+    {
+        g_autofree char *maps = dd_load_text_ext(dd, maps_file, DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE);
+        if (!maps)
+        {
+            error_msg(_("Can't read '%s'"), maps_file);
+            ret = 1;
+        }
+        else
+        {
+            g_autofree char *dso_list = abrt_core_dso_list_from_maps(maps);
+            if (dso_list)
+                dd_save_text(dd, FILENAME_DSO_LIST, dso_list);
+        }
+    }
+
+    dd_close(dd);
+
+    return ret;
+}
@@ -61,6 +61,9 @@ int main(int argc, char **argv)
 
     libreport_export_abrt_envvars(0);
 
+    /* SymbolCacheSize */
+    abrt_load_abrt_conf();
+
     g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
     if (!abrt_load_abrt_plugin_conf_file(CCPP_CONF, settings))
         error_msg("Can't load '%s'", CCPP_CONF);
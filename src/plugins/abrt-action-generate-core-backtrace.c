@@ -54,6 +54,9 @@ int main(int argc, char **argv)
 
     libreport_export_abrt_envvars(0);
 
+    /* SymbolCacheSize */
+    abrt_load_abrt_conf();
+
     if (libreport_g_verbose > 1)
         sr_debug_parser = true;
 
@@ -13,165 +13,11 @@
  * GNU General Public License for more details.
  */
 #include "libabrt.h"
-#include "abrt-journal.h"
+#include "journal-plugins.h"
 #include "oops-utils.h"
 
 #define ABRT_JOURNAL_WATCH_STATE_FILE VAR_STATE"/abrt-dump-journal-oops.state"
 
-/* Limit number of buffered lines */
-#define ABRT_JOURNAL_MAX_READ_LINES (1024 * 1024)
-
-#define ABRT_JOURNAL_KOOPS_ANALYZER "abrt-journal-koops"
-
-/*
- * Koops extractor
- */
-
-static GList* abrt_journal_extract_kernel_oops(abrt_journal_t *journal)
-{
-    size_t lines_info_count = 0;
-    size_t lines_info_size = 32;
-    struct abrt_koops_line_info *lines_info = g_malloc(lines_info_size * sizeof(lines_info[0]));
-
-    do
-    {
-        char *line = abrt_journal_get_log_line(journal);
-        if (line == NULL)
-            error_msg_and_die(_("Cannot read journal data."));
-
-        if (lines_info_count == lines_info_size)
-        {
-            lines_info_size *= 2;
-            lines_info = g_realloc(lines_info, lines_info_size * sizeof(lines_info[0]));
-        }
-
-        char *orig_line = line;
-        lines_info[lines_info_count].level = abrt_koops_line_skip_level((const char **)&line);
-        abrt_koops_line_skip_jiffies((const char **)&line);
-
-        memmove(orig_line, line, strlen(line) + 1);
-
-        lines_info[lines_info_count].ptr = orig_line;
-
-        ++lines_info_count;
-    }
-    while (lines_info_count < ABRT_JOURNAL_MAX_READ_LINES
-            && abrt_journal_next(journal) > 0);
-
-    GList *oops_list = NULL;
-    abrt_koops_extract_oopses_from_lines(&oops_list, lines_info, lines_info_count);
-
-    log_debug("Extracted: %d oopses", g_list_length(oops_list));
-
-    for (size_t i = 0; i < lines_info_count; ++i)
-        free(lines_info[i].ptr);
-
-    free(lines_info);
-
-    return oops_list;
-}
-
-/*
- * An adatapter of abrt_journal_extract_kernel_oops for abrt_journal_watch_callback
- */
-struct watch_journald_settings
-{
-    const char *dump_location;
-    int oops_utils_flags;
-};
-
-static void abrt_journal_watch_extract_kernel_oops(abrt_journal_watch_t *watch, void *data)
-{
-    const struct watch_journald_settings *conf = (const struct watch_journald_settings *)data;
-
-    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
-
-    /* Give systemd-journal one second to suck in all kernel's strings */
-    if (abrt_oops_signaled_sleep(1) > 0)
-    {
-        abrt_journal_watch_stop(watch);
-        return;
-    }
-
-    GList *oopses = abrt_journal_extract_kernel_oops(journal);
-    abrt_oops_process_list(oopses, conf->dump_location,
-                           ABRT_JOURNAL_KOOPS_ANALYZER, conf->oops_utils_flags);
-
-    g_list_free_full(oopses, (GDestroyNotify)free);
-
-    /* Skip stuff which appeared while processing oops as it is not necessary */
-    /* to catch all consecutive oopses (anyway such oopses are almost */
-    /* certainly duplicates of the already extracted ones) */
-    abrt_journal_seek_tail(journal);
-
-    /* In case of disaster, lets make sure we won't read the journal messages */
-    /* again. */
-    abrt_journal_save_current_position(journal, ABRT_JOURNAL_WATCH_STATE_FILE);
-
-    if (g_abrt_oops_sleep_woke_up_on_signal > 0)
-        abrt_journal_watch_stop(watch);
-}
-
-/*
- * Koops extractor end
- */
-
-static void watch_journald(abrt_journal_t *journal, const char *dump_location, int flags)
-{
-    GList *koops_strings = abrt_koops_suspicious_strings_list();
-
-    g_autofree char *oops_string_filter_regex = abrt_oops_string_filter_regex();
-    if (oops_string_filter_regex)
-    {
-        regex_t filter_re;
-        if (regcomp(&filter_re, oops_string_filter_regex, REG_NOSUB) != 0)
-            perror_msg_and_die(_("Failed to compile regex"));
-
-        GList *iter = koops_strings;
-        while(iter != NULL)
-        {
-            GList *next = g_list_next(iter);
-
-            const int reti = regexec(&filter_re, (const char *)iter->data, 0, NULL, 0);
-            if (reti == 0)
-                koops_strings = g_list_delete_link(koops_strings, iter);
-            else if (reti != REG_NOMATCH)
-            {
-                char msgbuf[100];
-                regerror(reti, &filter_re, msgbuf, sizeof(msgbuf));
-                error_msg_and_die("Regex match failed: %s", msgbuf);
-            }
-
-            iter = next;
-        }
-
-        regfree(&filter_re);
-    }
-
-    GList *koops_strings_blacklist = abrt_koops_suspicious_strings_blacklist();
-
-    struct watch_journald_settings watch_conf = {
-        .dump_location = dump_location,
-        .oops_utils_flags = flags,
-    };
-
-    struct abrt_journal_watch_notify_strings notify_strings_conf = {
-        .decorated_cb = abrt_journal_watch_extract_kernel_oops,
-        .decorated_cb_data = &watch_conf,
-        .strings = koops_strings,
-        .blacklisted_strings = koops_strings_blacklist,
-    };
-
-    abrt_journal_watch_t *watch = NULL;
-    if (abrt_journal_watch_new(&watch, journal, abrt_journal_watch_notify_strings, &notify_strings_conf) < 0)
-        error_msg_and_die(_("Failed to initialize systemd-journal watch"));
-
-    abrt_journal_watch_run_sync(watch);
-    abrt_journal_watch_free(watch);
-
-    g_list_free(koops_strings);
-}
-
 int main(int argc, char *argv[])
 {
     /* I18n */
@@ -226,7 +72,7 @@ int main(int argc, char *argv[])
         OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every oops found")),
         OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
         OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
-        OPT_BOOL(  't', NULL, NULL, _("Throttle problem directory creation to 1 per second")),
+        OPT_BOOL(  't', NULL, NULL, _("Add repeated oopses to the problem directory of their first occurrence")),
         OPT_STRING('c', NULL, &cursor, "CURSOR", _("Start reading systemd-journal from the CURSOR position")),
         OPT_BOOL(  'e', NULL, NULL, _("Start reading systemd-journal from the end")),
         OPT_BOOL(  'f', NULL, NULL, _("Follow systemd-journal from the last seen position (if available)")),
@@ -270,7 +116,7 @@ int main(int argc, char *argv[])
     const char *const env_journal_filter = getenv("ABRT_DUMP_JOURNAL_OOPS_DEBUG_FILTER");
     GList *kernel_journal_filter = NULL;
     kernel_journal_filter = g_list_append(kernel_journal_filter,
-            (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)"SYSLOG_IDENTIFIER=kernel"));
+            (env_journal_filter ? (gpointer)env_journal_filter : (gpointer)ABRT_JOURNAL_OOPS_DEFAULT_FILTER));
 
     abrt_journal_t *journal = NULL;
     if ((opts & OPT_J))
@@ -289,8 +135,6 @@ int main(int argc, char *argv[])
     if (abrt_journal_set_journal_filter(journal, kernel_journal_filter) < 0)
         error_msg_and_die(_("Cannot filter systemd-journal to kernel data only"));
 
-    g_list_free(kernel_journal_filter);
-
     if ((opts & OPT_e) && abrt_journal_seek_tail(journal) < 0)
         error_msg_and_die(_("Cannot seek to the end of journal"));
 
@@ -301,9 +145,14 @@ int main(int argc, char *argv[])
         else if(abrt_journal_set_cursor(journal, cursor))
             error_msg_and_die(_("Failed to start watch from cursor '%s'"), cursor);
 
-        watch_journald(journal, dump_location, oops_utils_flags);
+        struct abrt_journal_watch_plugin *plugin = abrt_journal_oops_plugin_new(kernel_journal_filter,
+                dump_location, oops_utils_flags);
+
+        GList *plugins = g_list_prepend(NULL, plugin);
+        abrt_journal_watch_plugins_sync(journal, plugins, ABRT_JOURNAL_WATCH_STATE_FILE);
+        g_list_free(plugins);
 
-        abrt_journal_save_current_position(journal, ABRT_JOURNAL_WATCH_STATE_FILE);
+        abrt_journal_watch_plugin_free(plugin);
     }
     else
     {
@@ -322,6 +171,7 @@ int main(int argc, char *argv[])
         return errors;
     }
 
+    g_list_free(kernel_journal_filter);
     abrt_journal_free(journal);
 
     return EXIT_SUCCESS;
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "journal-plugins.h"
+#include "oops-utils.h"
+#include "xorg-utils.h"
+
+#define ABRT_JOURNAL_WATCH_STATE_FILE VAR_STATE"/abrt-dump-journal.state"
+
+int main(int argc, char *argv[])
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-vsxt] [-COX] [-e]/[-c CURSOR] [-d DIR]/[-D]\n"
+        "\n"
+        "Follow systemd-journal and extract coredumps, oopses and Xorg crashes\n"
+        "in a single process\n"
+        "\n"
+        "All sources are watched if none of -C, -O and -X is given.\n"
+        "\n"
+        "-c and -e options conflicts because both specifies the first read message.\n"
+        "\n"
+        "The last seen position is saved in "ABRT_JOURNAL_WATCH_STATE_FILE"\n"
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_s = 1 << 1,
+        OPT_d = 1 << 2,
+        OPT_D = 1 << 3,
+        OPT_x = 1 << 4,
+        OPT_t = 1 << 5,
+        OPT_c = 1 << 6,
+        OPT_e = 1 << 7,
+        OPT_a = 1 << 8,
+        OPT_J = 1 << 9,
+        OPT_C = 1 << 10,
+        OPT_O = 1 << 11,
+        OPT_X = 1 << 12,
+    };
+
+    char *cursor = NULL;
+    char *dump_location = NULL;
+    char *journal_dir = NULL;
+
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&libreport_g_verbose),
+        OPT_BOOL(  's', NULL, NULL, _("Log to syslog")),
+        OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every problem found")),
+        OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
+        OPT_BOOL(  'x', NULL, NULL, _("Make the problem directories of oopses and Xorg crashes world readable")),
+        OPT_BOOL(  't', NULL, NULL, _("Add repeated oopses to the problem directory of their first occurrence and throttle creation of problem directories of Xorg crashes to 1 per second")),
+        OPT_STRING('c', NULL, &cursor, "CURSOR", _("Start reading systemd-journal from the CURSOR position")),
+        OPT_BOOL(  'e', NULL, NULL, _("Start reading systemd-journal from the end")),
+        OPT_BOOL(  'a', NULL, NULL, _("Read journal files from all machines")),
+        OPT_STRING('J', NULL, &journal_dir,  "PATH", _("Read all journal files from directory at PATH")),
+        OPT_BOOL(  'C', NULL, NULL, _("Watch coredumps")),
+        OPT_BOOL(  'O', NULL, NULL, _("Watch kernel oopses")),
+        OPT_BOOL(  'X', NULL, NULL, _("Watch Xorg crashes")),
+        OPT_END()
+    };
+    unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
+
+    libreport_export_abrt_envvars(0);
+
+    libreport_msg_prefix = libreport_g_progname;
+    if ((opts & OPT_s) || getenv("ABRT_SYSLOG"))
+    {
+        libreport_logmode = LOGMODE_JOURNAL;
+    }
+
+    if ((opts & OPT_c) && (opts & OPT_e))
+        error_msg_and_die(_("You need to specify either -c CURSOR or -e"));
+
+    /* Initialize ABRT configuration */
+    abrt_load_abrt_conf();
+
+    if (opts & OPT_D)
+    {
+        if (opts & OPT_d)
+            libreport_show_usage_and_die(program_usage_string, program_options);
+        dump_location = abrt_g_settings_dump_location;
+    }
+
+    if (!(opts & (OPT_C | OPT_O | OPT_X)))
+        opts |= OPT_C | OPT_O | OPT_X;
+
+    GList *plugins = NULL;
+    if ((opts & OPT_C))
+    {
+        int run_flags = 0;
+
+        {   /* Load CCpp.conf */
+            g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+            abrt_load_abrt_plugin_conf_file("CCpp.conf", settings);
+            const char *value;
+
+            value = g_hash_table_lookup(settings, "VerboseLog");
+            if (value)
+            {
+                char *endptr;
+
+                long verbose = g_ascii_strtoull(value, &endptr, 10);
+                if (verbose >= 0 && verbose <= UINT_MAX && value != endptr)
+                    libreport_g_verbose = (unsigned)verbose;
+                else
+                    error_msg_and_die("expected number in range <%d, %d>: '%s'", 0, UINT_MAX, value);
+            }
+
+            value = g_hash_table_lookup(settings, "KeepCompressedCoredump");
+            if (value && libreport_string_to_bool(value))
+                run_flags |= ABRT_CORE_KEEP_COMPRESSED;
+        }
+
+        GList *filter = g_list_prepend(NULL, (gpointer)ABRT_JOURNAL_CORE_DEFAULT_FILTER);
+        plugins = g_list_append(plugins, abrt_journal_core_plugin_new(filter, dump_location,
+                                                                      /*throttle*/0, run_flags));
+        g_list_free(filter);
+    }
+
+    if ((opts & OPT_O))
+    {
+        int oops_utils_flags = 0;
+        if ((opts & OPT_x))
+            oops_utils_flags |= ABRT_OOPS_WORLD_READABLE;
+
+        if ((opts & OPT_t))
+            oops_utils_flags |= ABRT_OOPS_THROTTLE_CREATION;
+
+        GList *filter = g_list_prepend(NULL, (gpointer)ABRT_JOURNAL_OOPS_DEFAULT_FILTER);
+        plugins = g_list_append(plugins, abrt_journal_oops_plugin_new(filter, dump_location,
+                                                                      oops_utils_flags));
+        g_list_free(filter);
+    }
+
+    if ((opts & OPT_X))
+    {
+        int xorg_utils_flags = 0;
+        if ((opts & OPT_x))
+            xorg_utils_flags |= ABRT_XORG_WORLD_READABLE;
+
+        if ((opts & OPT_t))
+            xorg_utils_flags |= ABRT_XORG_THROTTLE_CREATION;
+
+        GList *filter = abrt_journal_xorg_conf_journal_filters();
+        if (filter == NULL)
+            error_msg_and_die(_("Journal filter must be stored in /etc/abrt/plugins/xorg.conf file"));
+
+        plugins = g_list_append(plugins, abrt_journal_xorg_plugin_new(filter, dump_location,
+                                                                      xorg_utils_flags));
+        g_list_free_full(filter, free);
+    }
+
+    abrt_journal_t *journal = NULL;
+    if ((opts & OPT_J))
+    {
+        log_debug("Using journal files from directory '%s'", journal_dir);
+
+        if (abrt_journal_open_directory(&journal, journal_dir))
+            error_msg_and_die(_("Cannot initialize systemd-journal in directory '%s'"), journal_dir);
+    }
+    else
+    {
+        if (((opts & OPT_a) ? abrt_journal_new_merged : abrt_journal_new)(&journal))
+            error_msg_and_die(_("Cannot open systemd-journal"));
+    }
+
+    /* A single journal reader serves all sources: the reader returns a
+     * message if it matches filters of any plug-in and the dispatcher passes
+     * the message only to the plug-ins whose filters match it.
+     */
+    if (abrt_journal_set_plugins_journal_filter(journal, plugins) < 0)
+        error_msg_and_die(_("Cannot filter systemd-journal"));
+
+    if ((opts & OPT_e) && abrt_journal_seek_tail(journal) < 0)
+        error_msg_and_die(_("Cannot seek to the end of journal"));
+
+    if (cursor)
+    {
+        if (abrt_journal_set_cursor(journal, cursor))
+            error_msg_and_die(_("Failed to start watch from cursor '%s'"), cursor);
+    }
+    else if (abrt_journal_restore_position(journal, ABRT_JOURNAL_WATCH_STATE_FILE) == 0)
+    {
+        /* The stored position has already been seen, so move to the next one. */
+        abrt_journal_next(journal);
+    }
+
+    abrt_journal_watch_plugins_sync(journal, plugins, ABRT_JOURNAL_WATCH_STATE_FILE);
+
+    g_list_free_full(plugins, (GDestroyNotify)abrt_journal_watch_plugin_free);
+    abrt_journal_free(journal);
+    abrt_free_abrt_conf_data();
+
+    return EXIT_SUCCESS;
+}
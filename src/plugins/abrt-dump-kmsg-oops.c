@@ -0,0 +1,508 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include <signal.h>
+#include <poll.h>
+#include "libabrt.h"
+#include "oops-utils.h"
+
+#define ABRT_KMSG_WATCH_STATE_FILE VAR_STATE"/abrt-dump-kmsg-oops.state"
+#define ABRT_KMSG_WATCH_STATE_FILE_MODE 0600
+#define ABRT_KMSG_WATCH_STATE_FILE_MAX_SZ 128
+
+#define ABRT_KMSG_KOOPS_ANALYZER "abrt-kmsg-koops"
+#define ABRT_KMSG_DEVICE "/dev/kmsg"
+#define ABRT_KMSG_BOOT_ID_FILE "/proc/sys/kernel/random/boot_id"
+
+/* read() on /dev/kmsg returns one record and fails with EINVAL if the record
+ * does not fit into the buffer; the kernel never produces records longer
+ * than 8KiB (CONSOLE_EXT_LOG_MAX). */
+#define ABRT_KMSG_RECORD_MAX_SZ (8 * 1024)
+
+/* The kernel prints an oops in a burst; one second of silence means it is
+ * complete. */
+#define ABRT_KMSG_OOPS_COLLECT_MS 1000
+
+/* Do not rewrite the state file more often than this */
+#define ABRT_KMSG_CHECKPOINT_MS (5 * 1000)
+
+static volatile sig_atomic_t s_loop_terminated;
+static void signal_loop_to_terminate(int signum)
+{
+    (void)signum;
+    s_loop_terminated = 1;
+}
+
+/*
+ * A /dev/kmsg record looks like:
+ *   "PRIORITY,SEQNUM,TIMESTAMP,FLAGS[,...];MESSAGE\n"
+ * optionally followed by dictionary lines starting with a space:
+ *   " SUBSYSTEM=pci\n"
+ *
+ * The kernel escapes new lines and non-printable characters in MESSAGE, so
+ * a record has always exactly one message line.
+ */
+struct kmsg_record
+{
+    unsigned long long seq;
+    int level;
+    const char *message;
+};
+
+/*
+ * Modifies the record: terminates the message line.
+ * Returns false if the record is malformed.
+ */
+static bool kmsg_parse_record(char *record, struct kmsg_record *parsed)
+{
+    char *message = strchr(record, ';');
+    if (message == NULL)
+        return false;
+
+    *message++ = '\0';
+    message[strcspn(message, "\n")] = '\0';
+
+    unsigned prio;
+    unsigned long long seq;
+    if (sscanf(record, "%u,%llu,", &prio, &seq) != 2)
+        return false;
+
+    parsed->seq = seq;
+    parsed->level = prio & 7;
+    parsed->message = message;
+    return true;
+}
+
+/*
+ * The kernel messages come either from /dev/kmsg or from a file with records
+ * in the same format (one record per line, e.g. a copy of /dev/kmsg) which
+ * allows replaying an oops without crashing the kernel.
+ */
+struct kmsg_reader
+{
+    int fd;
+    FILE *replay;
+    char *buf;
+    size_t buf_size;
+};
+
+/*
+ * Returns 1 if a record is stored in *record, 0 if no record is available
+ * now or -1 if there will be no more records.
+ */
+static int kmsg_reader_next(struct kmsg_reader *reader, char **record)
+{
+    if (reader->replay != NULL)
+    {
+        ssize_t r;
+        /* Skip the dictionary lines */
+        while ((r = getline(&reader->buf, &reader->buf_size, reader->replay)) > 0
+                && reader->buf[0] == ' ')
+            ;
+
+        if (r <= 0)
+            return -1;
+
+        *record = reader->buf;
+        return 1;
+    }
+
+    while (1)
+    {
+        const ssize_t r = read(reader->fd, reader->buf, reader->buf_size - 1);
+        if (r > 0)
+        {
+            reader->buf[r] = '\0';
+            *record = reader->buf;
+            return 1;
+        }
+
+        if (r == 0)
+            return -1;
+
+        if (errno == EAGAIN || errno == EINTR)
+            return 0;
+
+        /* The reader position has been overwritten by new messages; the
+         * next read() returns the oldest record still available. */
+        if (errno == EPIPE)
+        {
+            log_warning(_("Kernel messages were overwritten before they could be read"));
+            continue;
+        }
+
+        perror_msg_and_die(_("Cannot read '%s'"), ABRT_KMSG_DEVICE);
+    }
+}
+
+/*
+ * The checkpoint
+ *
+ * Sequence numbers start from 0 at every boot, so the state file holds the
+ * boot ID along with the sequence number of the last processed record:
+ *   "BOOT_ID SEQNUM\n"
+ */
+
+static char *kmsg_load_boot_id(void)
+{
+    char *boot_id = NULL;
+    g_autoptr(GError) error = NULL;
+    if (!g_file_get_contents(ABRT_KMSG_BOOT_ID_FILE, &boot_id, NULL, &error))
+    {
+        error_msg(_("Cannot read boot ID, kernel log position won't be saved: %s"), error->message);
+        return NULL;
+    }
+
+    boot_id[strcspn(boot_id, "\n")] = '\0';
+    return boot_id;
+}
+
+/*
+ * Returns 0 and stores the sequence number in *seq if the state file was
+ * written during the current boot.
+ */
+static int kmsg_restore_position(const char *file_name, const char *boot_id, unsigned long long *seq)
+{
+    if (boot_id == NULL)
+        return -1;
+
+    g_autofree char *state = NULL;
+    gsize size;
+    g_autoptr(GError) error = NULL;
+    if (!g_file_get_contents(file_name, &state, &size, &error))
+    {
+        /* Only notice because this is expected on the first run */
+        log_notice(_("Not restoring kernel log position: %s"), error->message);
+        return -1;
+    }
+
+    if (size > ABRT_KMSG_WATCH_STATE_FILE_MAX_SZ)
+    {
+        error_msg(_("Cannot restore kernel log position: file '%s' exceeds %dB size limit"),
+                file_name, ABRT_KMSG_WATCH_STATE_FILE_MAX_SZ);
+        return -1;
+    }
+
+    char saved_boot_id[64];
+    unsigned long long saved_seq;
+    if (sscanf(state, "%63s %llu", saved_boot_id, &saved_seq) != 2)
+    {
+        error_msg(_("Cannot restore kernel log position: file '%s' is malformed"), file_name);
+        return -1;
+    }
+
+    if (strcmp(saved_boot_id, boot_id) != 0)
+    {
+        log_notice("The kernel log position in '%s' comes from a previous boot", file_name);
+        return -1;
+    }
+
+    *seq = saved_seq;
+    return 0;
+}
+
+static int kmsg_save_position(const char *file_name, const char *boot_id, unsigned long long seq)
+{
+    if (boot_id == NULL)
+        return -1;
+
+    g_autofree char *state = g_strdup_printf("%s %llu\n", boot_id, seq);
+    if (abrt_save_state_file(file_name, state, ABRT_KMSG_WATCH_STATE_FILE_MODE) < 0)
+    {
+        error_msg(_("Cannot save kernel log position"));
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * The watch
+ */
+
+struct kmsg_watch
+{
+    struct kmsg_reader reader;
+    struct abrt_koops_extractor *extractor;
+    GList *oopses;
+
+    const char *dump_location;
+    int oops_utils_flags;
+    int errors;
+
+    const char *state_file;
+    char *boot_id;
+    /* The last fed record */
+    unsigned long long seq;
+    bool have_seq;
+    /* The last saved record */
+    unsigned long long saved_seq;
+    bool have_saved_seq;
+    gint64 last_checkpoint;
+};
+
+static void kmsg_watch_process_oopses(struct kmsg_watch *watch)
+{
+    if (watch->oopses == NULL)
+        return;
+
+    watch->errors += abrt_oops_process_list(watch->oopses, watch->dump_location,
+                                            ABRT_KMSG_KOOPS_ANALYZER, watch->oops_utils_flags);
+    g_list_free_full(watch->oopses, (GDestroyNotify)free);
+    watch->oopses = NULL;
+}
+
+/*
+ * Saves the position only if all fed records have been turned into problem
+ * directories, so no oops is lost if the watch is killed.
+ */
+static void kmsg_watch_checkpoint(struct kmsg_watch *watch, bool force)
+{
+    if (watch->state_file == NULL || !watch->have_seq
+        || (watch->have_saved_seq && watch->saved_seq == watch->seq)
+        || !abrt_koops_extractor_is_idle(watch->extractor))
+        return;
+
+    const gint64 now = g_get_monotonic_time();
+    if (!force && (now - watch->last_checkpoint) / 1000 < ABRT_KMSG_CHECKPOINT_MS)
+        return;
+
+    kmsg_watch_process_oopses(watch);
+
+    if (kmsg_save_position(watch->state_file, watch->boot_id, watch->seq) == 0)
+    {
+        log_debug("Saved kernel log position %llu", watch->seq);
+        watch->saved_seq = watch->seq;
+        watch->have_saved_seq = true;
+    }
+
+    /* Do not retry a failed checkpoint after every record */
+    watch->last_checkpoint = now;
+}
+
+/*
+ * Analyzes all remaining lines and saves the problem directories.
+ */
+static void kmsg_watch_flush(struct kmsg_watch *watch)
+{
+    abrt_koops_extractor_finish(watch->extractor, &watch->oopses);
+    kmsg_watch_process_oopses(watch);
+    kmsg_watch_checkpoint(watch, /*force*/true);
+}
+
+static void kmsg_watch_feed(struct kmsg_watch *watch, char *record)
+{
+    struct kmsg_record parsed;
+    if (!kmsg_parse_record(record, &parsed))
+    {
+        log_info("Ignoring malformed kernel message '%s'", record);
+        return;
+    }
+
+    /* Already processed before the last checkpoint */
+    if (watch->have_saved_seq && parsed.seq <= watch->saved_seq)
+        return;
+
+    if (watch->have_seq && parsed.seq != watch->seq + 1)
+        log_notice("Kernel messages %llu..%llu are not available", watch->seq + 1, parsed.seq - 1);
+
+    abrt_koops_extractor_feed_line(watch->extractor, &watch->oopses, parsed.level, parsed.message);
+    watch->seq = parsed.seq;
+    watch->have_seq = true;
+
+    kmsg_watch_checkpoint(watch, /*force*/false);
+}
+
+static void kmsg_watch_run(struct kmsg_watch *watch, bool follow)
+{
+    if (follow)
+    {
+        /* services usually exit on SIGTERM and SIGHUP */
+        signal(SIGTERM, signal_loop_to_terminate);
+        signal(SIGHUP, signal_loop_to_terminate);
+        /* Ctrl-C for easier debugging */
+        signal(SIGINT, signal_loop_to_terminate);
+    }
+
+    bool pending = false;
+    while (!s_loop_terminated)
+    {
+        char *record;
+        const int r = kmsg_reader_next(&watch->reader, &record);
+        if (r > 0)
+        {
+            kmsg_watch_feed(watch, record);
+            pending = true;
+            continue;
+        }
+
+        if (r < 0 || !follow)
+            break;
+
+        if (pending)
+        {
+            struct pollfd pollfd = { .fd = watch->reader.fd, .events = POLLIN };
+            if (poll(&pollfd, 1, ABRT_KMSG_OOPS_COLLECT_MS) != 0)
+                continue;
+
+            kmsg_watch_flush(watch);
+            pending = false;
+        }
+
+        struct pollfd pollfd = { .fd = watch->reader.fd, .events = POLLIN };
+        poll(&pollfd, 1, -1);
+    }
+
+    kmsg_watch_flush(watch);
+}
+
+int main(int argc, char *argv[])
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-vsoxtf] [-e] [-d DIR]/[-D] [-K FILE]\n"
+        "\n"
+        "Extract oops from the kernel log buffer (/dev/kmsg)\n"
+        "\n"
+        "-e is useful only for -f because reading of the kernel log buffer starts\n"
+        "at the oldest available message if the last seen position is not available.\n"
+        "\n"
+        "-K reads records in the /dev/kmsg format from FILE and ignores\n"
+        "the last seen position.\n"
+        "\n"
+        "The last seen position is saved in "ABRT_KMSG_WATCH_STATE_FILE"\n"
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_s = 1 << 1,
+        OPT_o = 1 << 2,
+        OPT_d = 1 << 3,
+        OPT_D = 1 << 4,
+        OPT_x = 1 << 5,
+        OPT_t = 1 << 6,
+        OPT_e = 1 << 7,
+        OPT_f = 1 << 8,
+        OPT_K = 1 << 9,
+    };
+
+    char *dump_location = NULL;
+    char *replay_file = NULL;
+
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&libreport_g_verbose),
+        OPT_BOOL(  's', NULL, NULL, _("Log to syslog")),
+        OPT_BOOL(  'o', NULL, NULL, _("Print found oopses on standard output")),
+        OPT_STRING('d', NULL, &dump_location, "DIR", _("Create new problem directory in DIR for every oops found")),
+        OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
+        OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
+        OPT_BOOL(  't', NULL, NULL, _("Add repeated oopses to the problem directory of their first occurrence")),
+        OPT_BOOL(  'e', NULL, NULL, _("Start reading the kernel log buffer from the end")),
+        OPT_BOOL(  'f', NULL, NULL, _("Follow the kernel log buffer from the last seen position (if available)")),
+        OPT_STRING('K', NULL, &replay_file, "FILE", _("Read kernel messages from FILE instead of /dev/kmsg")),
+        OPT_END()
+    };
+    unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
+
+    libreport_export_abrt_envvars(0);
+
+    libreport_msg_prefix = libreport_g_progname;
+    if ((opts & OPT_s) || getenv("ABRT_SYSLOG"))
+    {
+        libreport_logmode = LOGMODE_JOURNAL;
+    }
+
+    if ((opts & OPT_K) && (opts & (OPT_e | OPT_f)))
+        error_msg_and_die(_("-K can't be used with -e or -f"));
+
+    if (opts & OPT_D)
+    {
+        if (opts & OPT_d)
+            libreport_show_usage_and_die(program_usage_string, program_options);
+        abrt_load_abrt_conf();
+        dump_location = abrt_g_settings_dump_location;
+        abrt_g_settings_dump_location = NULL;
+        abrt_free_abrt_conf_data();
+    }
+
+    struct kmsg_watch watch = { .reader.fd = -1 };
+    watch.dump_location = dump_location;
+
+    if ((opts & OPT_x))
+        watch.oops_utils_flags |= ABRT_OOPS_WORLD_READABLE;
+
+    if ((opts & OPT_t))
+        watch.oops_utils_flags |= ABRT_OOPS_THROTTLE_CREATION;
+
+    if ((opts & OPT_o))
+        watch.oops_utils_flags |= ABRT_OOPS_PRINT_STDOUT;
+
+    if ((opts & OPT_K))
+    {
+        watch.reader.replay = fopen(replay_file, "r");
+        if (watch.reader.replay == NULL)
+            perror_msg_and_die(_("Can't open '%s'"), replay_file);
+    }
+    else
+    {
+        watch.reader.fd = open(ABRT_KMSG_DEVICE, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+        if (watch.reader.fd < 0)
+            perror_msg_and_die(_("Can't open '%s'"), ABRT_KMSG_DEVICE);
+
+        watch.reader.buf_size = ABRT_KMSG_RECORD_MAX_SZ;
+        watch.reader.buf = g_malloc(watch.reader.buf_size);
+
+        if ((opts & OPT_f))
+        {
+            watch.state_file = ABRT_KMSG_WATCH_STATE_FILE;
+            watch.boot_id = kmsg_load_boot_id();
+
+            if (kmsg_restore_position(watch.state_file, watch.boot_id, &watch.saved_seq) == 0)
+            {
+                log_debug("Restored kernel log position %llu", watch.saved_seq);
+                watch.have_saved_seq = true;
+                watch.seq = watch.saved_seq;
+                watch.have_seq = true;
+            }
+        }
+
+        /* The records up to the last seen one are skipped while reading */
+        if ((opts & OPT_e) && !watch.have_saved_seq && lseek(watch.reader.fd, 0, SEEK_END) < 0)
+            perror_msg_and_die(_("Cannot seek to the end of '%s'"), ABRT_KMSG_DEVICE);
+    }
+
+    struct abrt_koops_parser *parser = abrt_koops_parser_new();
+    watch.extractor = abrt_koops_extractor_new(parser);
+
+    kmsg_watch_run(&watch, (opts & OPT_f));
+
+    abrt_koops_extractor_free(watch.extractor);
+    abrt_koops_parser_free(parser);
+    free(watch.boot_id);
+    free(watch.reader.buf);
+    if (watch.reader.replay != NULL)
+        fclose(watch.reader.replay);
+    if (watch.reader.fd >= 0)
+        close(watch.reader.fd);
+
+    return (opts & OPT_f) ? EXIT_SUCCESS : watch.errors;
+}
@@ -21,43 +21,25 @@
 #include "libabrt.h"
 #include "oops-utils.h"
 
-#define MAX_SCAN_BLOCK  (4*1024*1024)
-#define READ_AHEAD          (10*1024)
 #define ABRT_DUMP_OOPS_ANALYZER "abrt-oops"
 
 static void scan_syslog_file(GList **oops_list, int fd)
 {
-    struct stat st;
-    struct stat *statbuf = &st;
-
-    /* Try to not allocate an absurd amount of memory */
-    int sz = MAX_SCAN_BLOCK - READ_AHEAD;
-    /* If it's a real file, estimate size after cur pos */
-    off_t cur_pos = lseek(fd, 0, SEEK_CUR);
-    if (cur_pos >= 0 && fstat(fd, statbuf) == 0 && S_ISREG(statbuf->st_mode))
-    {
-        off_t size_to_read = statbuf->st_size - cur_pos;
-        if (size_to_read >= 0 && sz > size_to_read)
-            sz = size_to_read;
-    }
-
-    /*
-     * In theory we have a race here, since someone can spew
-     * to /var/log/messages before we read it in...
-     * We try to deal with it by reading READ_AHEAD extra.
-     */
-    sz += READ_AHEAD;
-    g_autofree char *buffer = g_malloc0(sz);
-
-    for (;;)
-    {
-        int r = libreport_full_read(fd, buffer, sz-1);
-        if (r <= 0)
-            break;
-        log_debug("Read %u bytes", r);
-        abrt_koops_extract_oopses(oops_list, buffer, r);
-//TODO: rewind to last newline?
-    }
+    /* A log file is mapped and its lines are analyzed in place, only the
+     * lines of a possible oops are copied by the extractor */
+    struct abrt_line_reader *reader = abrt_line_reader_new(fd);
+    struct abrt_koops_parser *parser = abrt_koops_parser_new();
+    struct abrt_koops_extractor *extractor = abrt_koops_extractor_new(parser);
+
+    const char *line;
+    size_t len;
+    while ((line = abrt_line_reader_next(reader, &len)) != NULL)
+        abrt_koops_extractor_feed_log_line(extractor, oops_list, line, len);
+
+    abrt_koops_extractor_finish(extractor, oops_list);
+    abrt_koops_extractor_free(extractor);
+    abrt_koops_parser_free(parser);
+    abrt_line_reader_free(reader);
 }
 
 int main(int argc, char **argv)
@@ -102,7 +84,7 @@ int main(int argc, char **argv)
         OPT_BOOL(  'D', NULL, NULL, _("Same as -d DumpLocation, DumpLocation is specified in abrt.conf")),
         OPT_STRING('u', NULL, &problem_dir, "PROBLEM", _("Save the extracted information in PROBLEM")),
         OPT_BOOL(  'x', NULL, NULL, _("Make the problem directory world readable")),
-        OPT_BOOL(  't', NULL, NULL, _("Throttle problem directory creation to 1 per second")),
+        OPT_BOOL(  't', NULL, NULL, _("Add repeated oopses to the problem directory of their first occurrence")),
         OPT_BOOL(  'm', NULL, NULL, _("Print search string(s) to stdout and exit")),
         OPT_END()
     };
@@ -88,14 +88,17 @@ int main(int argc, char **argv)
     if (argv[0])
         libreport_xmove_fd(g_open(argv[0], O_RDONLY), STDIN_FILENO);
 
+    /* Lines are scanned in place, only the backtrace lines are copied */
+    struct abrt_line_reader *reader = abrt_line_reader_new(STDIN_FILENO);
+
     int bt_count = 0;
-    g_autofree char *line = NULL;
-    while ((line = libreport_xmalloc_fgetline(stdin)) != NULL)
+    char *line;
+    while ((line = abrt_line_reader_next_str(reader, NULL)) != NULL)
     {
         char *p = skip_pfx(line);
         if (strcmp(p, "Backtrace:") == 0)
         {
-            struct xorg_crash_info *crash_info = process_xorg_bt(&xorg_get_next_line_from_fd, stdin);
+            struct xorg_crash_info *crash_info = process_xorg_bt(&xorg_get_next_line_from_reader, reader);
             if (crash_info)
             {
                 if (opts & OPT_o)
@@ -110,5 +113,7 @@ int main(int argc, char **argv)
         }
     }
 
+    abrt_line_reader_free(reader);
+
     return 0;
 }
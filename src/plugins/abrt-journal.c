@@ -23,12 +23,6 @@
 
 #include <systemd/sd-journal.h>
 
-/*
- * http://www.freedesktop.org/software/systemd/man/sd_journal_get_data.html
- * sd_journal_set_data_threshold() : This threshold defaults to 64K by default.
- */
-#define JOURNALD_MAX_FIELD_SIZE (64*1024)
-
 #define ABRT_JOURNAL_WATCH_STATE_FILE_MODE 0600
 #define ABRT_JOURNAL_WATCH_STATE_FILE_MAX_SZ (4 * 1024)
 
@@ -109,6 +103,64 @@ int abrt_journal_set_journal_filter(abrt_journal_t *journal, GList *journal_filt
     return 0;
 }
 
+int abrt_journal_add_journal_filter_disjunction(abrt_journal_t *journal)
+{
+    const int r = sd_journal_add_disjunction(journal->j);
+    if (r < 0)
+        log_notice("Failed to add journal filter disjunction: %s", strerror(-r));
+
+    return r;
+}
+
+/* Returns true if the filter list contains a filter for the field before the
+ * item 'end'.
+ */
+static bool journal_filter_has_field_before(GList *journal_filter_list, GList *end,
+                                            const char *field, size_t field_len)
+{
+    for (GList *l = journal_filter_list; l != end; l = l->next)
+        if (strncmp(l->data, field, field_len + 1) == 0)
+            return true;
+
+    return false;
+}
+
+bool abrt_journal_match_journal_filter(abrt_journal_t *journal, GList *journal_filter_list)
+{
+    for (GList *l = journal_filter_list; l != NULL; l = l->next)
+    {
+        const char *filter = l->data;
+        const char *eq = strchr(filter, '=');
+        if (eq == NULL)
+            return false;
+
+        /* Check every field only once, all its filters are checked below */
+        const size_t field_len = eq - filter;
+        if (journal_filter_has_field_before(journal_filter_list, l, filter, field_len))
+            continue;
+
+        g_autofree char *field = g_strndup(filter, field_len);
+        const void *data;
+        size_t data_len;
+        if (sd_journal_get_data(journal->j, field, &data, &data_len) < 0)
+            return false;
+
+        bool matched = false;
+        for (GList *m = l; m != NULL && !matched; m = m->next)
+        {
+            const char *other = m->data;
+            matched = strncmp(other, filter, field_len + 1) == 0
+                   && strlen(other) == data_len
+                   && memcmp(other, data, data_len) == 0;
+        }
+
+        if (!matched)
+            return false;
+    }
+
+    return true;
+}
+
 int abrt_journal_get_field(abrt_journal_t *journal, const char *field, const void **value, size_t *value_len)
 {
     const int r = sd_journal_get_data(journal->j, field, value, value_len);
@@ -310,19 +362,12 @@ int abrt_journal_save_current_position(abrt_journal_t *journal, const char *file
         return r;
     }
 
-    int state_fd = open(file_name,
-            O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
-            ABRT_JOURNAL_WATCH_STATE_FILE_MODE);
-
-    if (state_fd < 0)
+    if (abrt_save_state_file(file_name, crsr, ABRT_JOURNAL_WATCH_STATE_FILE_MODE) < 0)
     {
-        perror_msg(_("Cannot save journal watch's position: open('%s')"), file_name);
+        error_msg(_("Cannot save journal watch's position"));
         return -1;
     }
 
-    libreport_full_write_str(state_fd, crsr);
-    close(state_fd);
-
     return 0;
 }
 
@@ -408,6 +453,9 @@ struct abrt_journal_watch
 
     abrt_journal_watch_callback callback;
     void *callback_data;
+
+    abrt_journal_watch_idle_callback idle_callback;
+    void *idle_callback_data;
 };
 
 int abrt_journal_watch_new(abrt_journal_watch_t **watch, abrt_journal_t *journal, abrt_journal_watch_callback callback, void *callback_data)
@@ -433,6 +481,13 @@ abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch)
     return watch->j;
 }
 
+void abrt_journal_watch_set_idle_callback(abrt_journal_watch_t *watch,
+        abrt_journal_watch_idle_callback callback, void *callback_data)
+{
+    watch->idle_callback = callback;
+    watch->idle_callback_data = callback_data;
+}
+
 int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
 {
     sigset_t mask;
@@ -467,7 +522,22 @@ int abrt_journal_watch_run_sync(abrt_journal_watch_t *watch)
         }
         else if (r == 0)
         {
-            ppoll(&pollfd, 1, NULL, &mask);
+            int timeout_ms = -1;
+            if (watch->idle_callback != NULL)
+            {
+                timeout_ms = watch->idle_callback(watch, watch->idle_callback_data);
+                if (watch->state != ABRT_JOURNAL_WATCH_READY)
+                    break;
+            }
+
+            struct timespec timeout;
+            if (timeout_ms >= 0)
+            {
+                timeout.tv_sec = timeout_ms / 1000;
+                timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+            }
+
+            ppoll(&pollfd, 1, timeout_ms >= 0 ? &timeout : NULL, &mask);
             r = sd_journal_process(watch->j->j);
             if (r < 0)
             {
@@ -496,26 +566,234 @@ void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data)
 {
     struct abrt_journal_watch_notify_strings *conf = (struct abrt_journal_watch_notify_strings *)data;
 
-    char message[JOURNALD_MAX_FIELD_SIZE + 1];
+    if (conf->strings_matcher == NULL)
+    {
+        conf->strings_matcher = abrt_string_matcher_new_from_list(conf->strings);
+        conf->blacklisted_strings_matcher = abrt_string_matcher_new_from_list(conf->blacklisted_strings);
+    }
 
-    if (abrt_journal_get_string_field(abrt_journal_watch_get_journal(watch), "MESSAGE", (char *)message) == NULL)
+    /* The message is searched in place, there is no need to copy it to
+     * a NUL terminated buffer. */
+    const void *message;
+    size_t message_len;
+    if (abrt_journal_get_field(abrt_journal_watch_get_journal(watch), "MESSAGE", &message, &message_len) < 0)
         error_msg_and_die("Cannot read journal data.");
 
-    GList *cur = conf->strings;
-    for (; cur; cur = g_list_next(cur))
-        if (strstr(message, cur->data) != NULL)
-            break;
+    if (abrt_string_matcher_find(conf->strings_matcher, message, message_len) < 0)
+        return;
 
-    GList *blacklist_cur = conf->blacklisted_strings;
-    if (cur)
-        for (; blacklist_cur; blacklist_cur = g_list_next(blacklist_cur))
-            if (strstr(message, blacklist_cur->data) != NULL)
-                break;
+    if (abrt_string_matcher_find(conf->blacklisted_strings_matcher, message, message_len) >= 0)
+        return;
 
-    if (cur && !blacklist_cur)
-        conf->decorated_cb(watch, conf->decorated_cb_data);
+    conf->decorated_cb(watch, conf->decorated_cb_data);
+}
+
+void abrt_journal_watch_notify_strings_destroy(struct abrt_journal_watch_notify_strings *conf)
+{
+    abrt_string_matcher_free(conf->strings_matcher);
+    conf->strings_matcher = NULL;
+    abrt_string_matcher_free(conf->blacklisted_strings_matcher);
+    conf->blacklisted_strings_matcher = NULL;
 }
 
 /*
  * ABRT systemd-journal strings notifier - end
  */
+
+void abrt_journal_watch_plugin_free(struct abrt_journal_watch_plugin *plugin)
+{
+    if (plugin == NULL)
+        return;
+
+    if (plugin->free_data != NULL)
+        plugin->free_data(plugin->data);
+
+    g_list_free_full(plugin->journal_filters, free);
+    free(plugin);
+}
+
+int abrt_journal_set_plugins_journal_filter(abrt_journal_t *journal, GList *plugins)
+{
+    for (GList *l = plugins; l != NULL; l = l->next)
+    {
+        struct abrt_journal_watch_plugin *plugin = l->data;
+
+        if (l != plugins)
+        {
+            const int r = abrt_journal_add_journal_filter_disjunction(journal);
+            if (r < 0)
+                return r;
+        }
+
+        const int r = abrt_journal_set_journal_filter(journal, plugin->journal_filters);
+        if (r < 0)
+        {
+            error_msg(_("Cannot set systemd-journal filter for %s"), plugin->name);
+            return r;
+        }
+    }
+
+    return 0;
+}
+
+static bool dispatcher_plugins_pending(struct abrt_journal_watch_dispatcher *dispatcher)
+{
+    for (GList *l = dispatcher->plugins; l != NULL; l = l->next)
+    {
+        struct abrt_journal_watch_plugin *plugin = l->data;
+        if (plugin->pending_callback != NULL && plugin->pending_callback(plugin->data))
+            return true;
+    }
+
+    return false;
+}
+
+static void dispatcher_checkpoint(struct abrt_journal_watch_dispatcher *dispatcher, abrt_journal_t *journal)
+{
+    if (abrt_journal_save_current_position(journal, dispatcher->state_file) == 0)
+    {
+        log_debug("Saved journal position after %u messages", dispatcher->unsaved_messages);
+        ++dispatcher->checkpoints;
+    }
+    else
+        ++dispatcher->failed_checkpoints;
+
+    /* Do not retry a failed checkpoint after every message */
+    dispatcher->unsaved_messages = 0;
+    dispatcher->last_checkpoint = g_get_monotonic_time();
+}
+
+/* Returns the number of milliseconds remaining until the next checkpoint is
+ * due, 0 if it is due now, or -1 if there is nothing to save.
+ */
+static int dispatcher_checkpoint_timeout(struct abrt_journal_watch_dispatcher *dispatcher)
+{
+    if (dispatcher->state_file == NULL || dispatcher->unsaved_messages == 0)
+        return -1;
+
+    if (dispatcher->checkpoint_messages != 0
+        && dispatcher->unsaved_messages >= dispatcher->checkpoint_messages)
+        return 0;
+
+    const gint64 elapsed_ms = (g_get_monotonic_time() - dispatcher->last_checkpoint) / 1000;
+    if (elapsed_ms >= dispatcher->checkpoint_interval_ms)
+        return 0;
+
+    return dispatcher->checkpoint_interval_ms - elapsed_ms;
+}
+
+void abrt_journal_watch_dispatch(abrt_journal_watch_t *watch, void *data)
+{
+    struct abrt_journal_watch_dispatcher *dispatcher = (struct abrt_journal_watch_dispatcher *)data;
+    abrt_journal_t *journal = abrt_journal_watch_get_journal(watch);
+
+    for (GList *l = dispatcher->plugins; l != NULL; l = l->next)
+    {
+        struct abrt_journal_watch_plugin *plugin = l->data;
+
+        if (!abrt_journal_match_journal_filter(journal, plugin->journal_filters))
+            continue;
+
+        log_debug("Dispatching journal message to %s", plugin->name);
+        plugin->callback(watch, plugin->data);
+
+        if (watch->state != ABRT_JOURNAL_WATCH_READY)
+            break;
+    }
+
+    ++dispatcher->dispatched_messages;
+    ++dispatcher->unsaved_messages;
+
+    /* Do not save the position while a plug-in holds unprocessed messages,
+     * they would be lost in case of disaster. */
+    if (dispatcher_checkpoint_timeout(dispatcher) == 0 && !dispatcher_plugins_pending(dispatcher))
+        dispatcher_checkpoint(dispatcher, journal);
+}
+
+int abrt_journal_watch_dispatch_idle(abrt_journal_watch_t *watch, void *data)
+{
+    struct abrt_journal_watch_dispatcher *dispatcher = (struct abrt_journal_watch_dispatcher *)data;
+
+    int timeout_ms = -1;
+    for (GList *l = dispatcher->plugins; l != NULL; l = l->next)
+    {
+        struct abrt_journal_watch_plugin *plugin = l->data;
+        if (plugin->idle_callback == NULL)
+            continue;
+
+        const int r = plugin->idle_callback(watch, plugin->data);
+        if (r >= 0 && (timeout_ms < 0 || r < timeout_ms))
+            timeout_ms = r;
+    }
+
+    if (dispatcher_plugins_pending(dispatcher))
+        return timeout_ms;
+
+    int checkpoint_ms = dispatcher_checkpoint_timeout(dispatcher);
+    if (checkpoint_ms == 0)
+    {
+        dispatcher_checkpoint(dispatcher, abrt_journal_watch_get_journal(watch));
+        checkpoint_ms = -1;
+    }
+
+    if (checkpoint_ms >= 0 && (timeout_ms < 0 || checkpoint_ms < timeout_ms))
+        timeout_ms = checkpoint_ms;
+
+    return timeout_ms;
+}
+
+void abrt_journal_watch_dispatch_finish(struct abrt_journal_watch_dispatcher *dispatcher,
+                                        abrt_journal_t *journal)
+{
+    /* Once the position is saved, the next run would skip held messages */
+    for (GList *l = dispatcher->plugins; l != NULL; l = l->next)
+    {
+        struct abrt_journal_watch_plugin *plugin = l->data;
+        if (plugin->flush_callback != NULL)
+            plugin->flush_callback(plugin->data);
+    }
+
+    if (dispatcher->state_file == NULL)
+        return;
+
+    if (dispatcher_plugins_pending(dispatcher))
+    {
+        log_warning("Not saving journal position, unprocessed messages would be lost");
+        return;
+    }
+
+    dispatcher_checkpoint(dispatcher, journal);
+}
+
+int abrt_journal_watch_plugins_sync(abrt_journal_t *journal, GList *plugins, const char *state_file)
+{
+    struct abrt_journal_watch_dispatcher dispatcher = {
+        .plugins = plugins,
+        .state_file = state_file,
+        .checkpoint_messages = abrt_g_settings_journal_checkpoint_messages,
+        .checkpoint_interval_ms = abrt_g_settings_journal_checkpoint_interval,
+        .last_checkpoint = g_get_monotonic_time(),
+    };
+
+    abrt_journal_watch_t *watch = NULL;
+    if (abrt_journal_watch_new(&watch, journal, abrt_journal_watch_dispatch, &dispatcher) < 0)
+    {
+        error_msg(_("Failed to initialize systemd-journal watch"));
+        return -1;
+    }
+
+    abrt_journal_watch_set_idle_callback(watch, abrt_journal_watch_dispatch_idle, &dispatcher);
+    const int r = abrt_journal_watch_run_sync(watch);
+    abrt_journal_watch_free(watch);
+
+    abrt_journal_watch_dispatch_finish(&dispatcher, journal);
+
+    log_notice("Read %lu journal messages, saved the position %lu times (%lu failed)",
+               dispatcher.dispatched_messages, dispatcher.checkpoints, dispatcher.failed_checkpoints);
+
+    return r;
+}
+
+/*
+ * ABRT systemd-journal dispatcher - end
+ */
@@ -48,6 +48,17 @@ void abrt_journal_free(abrt_journal_t *journal);
 int abrt_journal_set_journal_filter(abrt_journal_t *journal,
                                     GList *journal_filter_list);
 
+/* Filters set after this call are OR-ed with the filters set before it.
+ */
+int abrt_journal_add_journal_filter_disjunction(abrt_journal_t *journal);
+
+/* Checks whether the current message matches the filters in the same way as
+ * systemd-journal does it: filters for the same field are OR-ed and filters
+ * for different fields are AND-ed.
+ */
+bool abrt_journal_match_journal_filter(abrt_journal_t *journal,
+                                       GList *journal_filter_list);
+
 int abrt_journal_get_field(abrt_journal_t *journal,
                            const char *field,
                            const void **value,
@@ -80,6 +91,9 @@ int abrt_journal_seek_tail(abrt_journal_t *journal);
 
 int abrt_journal_next(abrt_journal_t *journal);
 
+/* The position is written to a temporary file which is synced and renamed to
+ * file_name, so file_name always holds a complete cursor.
+ */
 int abrt_journal_save_current_position(abrt_journal_t *journal,
                                        const char *file_name);
 
@@ -96,6 +110,14 @@ typedef struct abrt_journal_watch abrt_journal_watch_t;
 typedef void (* abrt_journal_watch_callback)(struct abrt_journal_watch *watch,
                                              void *data);
 
+/*
+ * Returns the number of milliseconds after which the call back wants to be
+ * called again even if no new message comes, or -1 to wait for new messages
+ * only.
+ */
+typedef int (* abrt_journal_watch_idle_callback)(struct abrt_journal_watch *watch,
+                                                 void *data);
+
 int abrt_journal_watch_new(abrt_journal_watch_t **watch,
                            abrt_journal_t *journal,
                            abrt_journal_watch_callback callback,
@@ -108,6 +130,14 @@ void abrt_journal_watch_free(abrt_journal_watch_t *watch);
  */
 abrt_journal_t *abrt_journal_watch_get_journal(abrt_journal_watch_t *watch);
 
+/*
+ * Sets a call back which is called every time the watch has read all available
+ * messages and is about to wait for new ones.
+ */
+void abrt_journal_watch_set_idle_callback(abrt_journal_watch_t *watch,
+                                          abrt_journal_watch_idle_callback callback,
+                                          void *callback_data);
+
 /*
  * Starts reading journal messages and waiting for new messages in a loop.
  *
@@ -132,10 +162,104 @@ struct abrt_journal_watch_notify_strings
     void *decorated_cb_data;
     GList *strings;
     GList *blacklisted_strings;
+
+    /* Compiled from the lists above on the first message, the lists must not
+     * be changed afterwards */
+    struct abrt_string_matcher *strings_matcher;
+    struct abrt_string_matcher *blacklisted_strings_matcher;
 };
 
 void abrt_journal_watch_notify_strings(abrt_journal_watch_t *watch, void *data);
 
+/*
+ * Releases the compiled lists, the lists themselves are owned by the caller
+ */
+void abrt_journal_watch_notify_strings_destroy(struct abrt_journal_watch_notify_strings *conf);
+
+/*
+ * A source of problems watched by abrt_journal_watch_dispatch()
+ *
+ * The call backs must not move the journal to other messages. A plug-in which
+ * needs several messages to detect a problem collects them in its data and
+ * processes them in the idle call back.
+ */
+struct abrt_journal_watch_plugin
+{
+    const char *name;
+    /* Messages matching these filters are passed to the call back */
+    GList *journal_filters;
+    abrt_journal_watch_callback callback;
+    /* May be NULL */
+    abrt_journal_watch_idle_callback idle_callback;
+    /* Returns true if the plug-in holds messages which have not been
+     * processed yet (may be NULL) */
+    bool (*pending_callback)(void *data);
+    /* Processes the held messages right away, called when the watch ends
+     * (may be NULL) */
+    void (*flush_callback)(void *data);
+    void *data;
+    GDestroyNotify free_data;
+};
+
+void abrt_journal_watch_plugin_free(struct abrt_journal_watch_plugin *plugin);
+
+/*
+ * A watch call back which reads every message only once and passes it to all
+ * plug-ins whose filters match the message. Hence, a single process can watch
+ * several sources of problems.
+ *
+ * Use abrt_journal_watch_dispatch_idle() as the idle call back of the watch.
+ */
+struct abrt_journal_watch_dispatcher
+{
+    GList *plugins;
+    /* The position is saved in this file when no plug-in holds unprocessed
+     * messages and either checkpoint_messages messages have been read or
+     * checkpoint_interval_ms milliseconds have passed since the last saved
+     * position, and by abrt_journal_watch_dispatch_finish(). May be NULL. */
+    const char *state_file;
+    /* 0 disables the limit */
+    unsigned checkpoint_messages;
+    unsigned checkpoint_interval_ms;
+
+    /* Statistics */
+    unsigned long dispatched_messages;
+    unsigned long checkpoints;
+    unsigned long failed_checkpoints;
+
+    /* private */
+    unsigned unsaved_messages;
+    gint64 last_checkpoint;
+};
+
+/*
+ * Sets the journal filter to the union of the plug-ins' filters.
+ */
+int abrt_journal_set_plugins_journal_filter(abrt_journal_t *journal,
+                                            GList *plugins);
+
+void abrt_journal_watch_dispatch(abrt_journal_watch_t *watch, void *data);
+
+int abrt_journal_watch_dispatch_idle(abrt_journal_watch_t *watch, void *data);
+
+/*
+ * Flushes the plug-ins and saves the position unless a plug-in still holds
+ * messages. Call it when the watch has ended, e.g. on SIGTERM.
+ */
+void abrt_journal_watch_dispatch_finish(struct abrt_journal_watch_dispatcher *dispatcher,
+                                        abrt_journal_t *journal);
+
+/*
+ * Watches the journal with a dispatcher of the plug-ins until the watch is
+ * stopped and finishes the dispatcher. The journal filter must already be set.
+ *
+ * The checkpoint policy is configured in abrt.conf (JournalCheckpointMessages
+ * and JournalCheckpointInterval).
+ */
+int abrt_journal_watch_plugins_sync(abrt_journal_t *journal,
+                                    GList *plugins,
+                                    const char *state_file);
+
 #ifdef __cplusplus
 }
 #endif
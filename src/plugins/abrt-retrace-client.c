@@ -58,6 +58,8 @@ static const char *optional_retrace[] = { FILENAME_ROOTDIR,
                                           NULL };
 static const char *required_vmcore[] = { FILENAME_VMCORE,
                                          NULL };
+/* The core of dump_dir_name, unpacked outside of it if it is compressed */
+static char *coredump_path = NULL;
 static unsigned delay = 0;
 static int task_type = TASK_RETRACE;
 static bool http_show_headers;
@@ -98,6 +100,12 @@ static void args_add_if_exists(const char *args[],
     }
 }
 
+static void release_coredump(void)
+{
+    abrt_coredump_release(dump_dir_name, coredump_path);
+    coredump_path = NULL;
+}
+
 /* Create an archive with files required for retrace server and return
  * a file descriptor. Returns -1 if it fails.
  */
@@ -168,7 +176,7 @@ static int create_archive(bool unlink_temp)
     /* Run tar, and set output to a pipe with xz waiting on the other
      * end.
      */
-    const char *tar_args[10];
+    const char *tar_args[12];
     tar_args[0] = "tar";
     tar_args[1] = "cO";
     tar_args[2] = g_strdup_printf("--directory=%s", dump_dir_name);
@@ -185,6 +193,18 @@ static int create_archive(bool unlink_temp)
             args_add_if_exists(tar_args, dd, optional_retrace[i], &index);
     }
 
+    /* tar reads the unpacked core from its own directory, the archive
+     * member is FILENAME_COREDUMP in both cases */
+    g_autofree char *coredump_dir_arg = NULL;
+    if (coredump_path != NULL && !dd_exist(dd, FILENAME_COREDUMP)
+        && access(coredump_path, R_OK) == 0)
+    {
+        g_autofree char *coredump_dir = g_path_get_dirname(coredump_path);
+        coredump_dir_arg = g_strdup_printf("--directory=%s", coredump_dir);
+        tar_args[index++] = coredump_dir_arg;
+        tar_args[index++] = FILENAME_COREDUMP;
+    }
+
     tar_args[index] = NULL;
     dd_close(dd);
 
@@ -585,12 +605,24 @@ static int create(SoupSession  *session,
             task_type = TASK_VMCORE;
         dd_close(dd);
 
+        /* The server needs the uncompressed core and so does the size check */
+        if (task_type != TASK_VMCORE)
+        {
+            coredump_path = abrt_coredump_acquire(dump_dir_name);
+            if (coredump_path == NULL)
+                libreport_xfunc_die(); /* abrt_coredump_acquire already emitted error message */
+            atexit(release_coredump);
+        }
+
         g_autofree char *path = NULL;
         int i = 0;
         const char **required_files = task_type == TASK_VMCORE ? required_vmcore : required_retrace;
         while (required_files[i])
         {
-            path = g_build_filename(dump_dir_name, required_files[i], NULL);
+            if (task_type != TASK_VMCORE && strcmp(required_files[i], FILENAME_COREDUMP) == 0)
+                path = g_strdup(coredump_path);
+            else
+                path = g_build_filename(dump_dir_name, required_files[i], NULL);
             g_stat(path, &file_stat);
 
             if (!S_ISREG(file_stat.st_mode))
@@ -719,6 +751,7 @@ static int create(SoupSession  *session,
     }
 
     int tempfd = create_archive(delete_temp_archive);
+    release_coredump();
     if (-1 == tempfd)
         return 1;
 
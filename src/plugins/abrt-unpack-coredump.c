@@ -0,0 +1,72 @@
+/*
+    Copyright (C) 2026  ABRT team
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+*/
+#include "libabrt.h"
+
+/*
+ * Unpacks FILENAME_COREDUMP_ZST for the analyzers written in scripting
+ * languages, so they obey the same limits as the C ones.
+ */
+int main(int argc, char **argv)
+{
+    /* I18n */
+    setlocale(LC_ALL, "");
+#if ENABLE_NLS
+    bindtextdomain(PACKAGE, LOCALEDIR);
+    textdomain(PACKAGE);
+#endif
+
+    abrt_init(argv);
+
+    const char *dump_dir_name = ".";
+
+    /* Can't keep these strings/structs static: _() doesn't support that */
+    const char *program_usage_string = _(
+        "& [-v] [-d DIR]\n"
+        "\n"
+        "Prints the path of the uncompressed coredump of problem directory DIR.\n"
+        "A compressed coredump is unpacked to a new directory in the directory\n"
+        "for large temporary files, the caller removes the directory."
+    );
+    enum {
+        OPT_v = 1 << 0,
+        OPT_d = 1 << 1,
+    };
+    /* Keep enum above and order of options below in sync! */
+    struct options program_options[] = {
+        OPT__VERBOSE(&libreport_g_verbose),
+        OPT_STRING('d', NULL, &dump_dir_name, "DIR", _("Problem directory")),
+        OPT_END()
+    };
+    /*unsigned opts =*/ libreport_parse_opts(argc, argv, program_options, program_usage_string);
+
+    libreport_export_abrt_envvars(0);
+
+    /* MaxCrashReportsSize limits the size of the unpacked core */
+    abrt_load_abrt_conf();
+
+    /* Not released, the unpacked core must outlive this process */
+    char *coredump_path = abrt_coredump_acquire(dump_dir_name);
+    if (coredump_path == NULL)
+        return 1;
+
+    puts(coredump_path);
+    free(coredump_path);
+    abrt_free_abrt_conf_data();
+
+    return 0;
+}
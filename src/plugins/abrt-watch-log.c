@@ -18,42 +18,88 @@
  */
 #include <sys/inotify.h>
 #include <spawn.h>
+#include <signal.h>
+#include <poll.h>
 #include "libabrt.h"
+#include "oops-utils.h"
 
 #define MAX_SCAN_BLOCK  (4*1024*1024)
 #define READ_AHEAD          (10*1024)
 
+/* New data are passed to a persistent scanner or to the koops extractor in
+ * blocks of this size */
+#define STREAM_BLOCK        (64*1024)
+
+/* Without -p and -k, give the writers this much time to finish a burst
+ * before PROG is run, so that PROG doesn't get a partial oops. */
+#define DEFAULT_SPAWN_WINDOW_MS 1000
+
+/* An oops at the very end of a file is complete after this much silence */
+#define KOOPS_IDLE_MS 1000
+
+/* How often to look for a file whose directory can't be watched */
+#define MISSING_DIR_RETRY_MS (60 * 1000)
+
+#define ABRT_WATCH_LOG_KOOPS_ANALYZER "abrt-oops"
+
 extern char **environ;
 static unsigned page_size;
 
-static bool memstr(void *buf, unsigned size, const char *str)
+static volatile sig_atomic_t s_loop_terminated;
+static void signal_loop_to_terminate(int signum)
 {
-    int len = strlen(str);
-    while ((int)size >= len)
-    {
-        //log_warning("LOOKING FOR:'%s'", str);
-        char *first = memchr(buf, (unsigned char)str[0], size - len + 1);
-        if (!first)
-            break;
-        //log_warning("FOUND:'%.66s'", first);
-        first++;
-        if (len <= 1 || strncmp(first, str + 1, len - 1) == 0)
-            return true;
-        size -= (first - (char*)buf);
-        //log_warning("SKIP TO:'%.66s' %d chars", first, (int)(first - (char*)buf));
-        buf = first;
-    }
-    return false;
+    (void)signum;
+    s_loop_terminated = 1;
 }
 
-static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, char **prog)
+static pid_t spawn_prog(char **prog, int stdin_fd)
 {
     pid_t pid;
     int err;
     int attr_set = 0, fd_actions_set = 0;
     posix_spawnattr_t attr;
     posix_spawn_file_actions_t fd_actions;
+    short flags = POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    /* We ignore SIGPIPE, PROG must not inherit that */
+    sigset_t sigdefault;
+    sigemptyset(&sigdefault);
+    sigaddset(&sigdefault, SIGPIPE);
+
+    fflush(NULL); /* paranoia */
 
+    if ((err = posix_spawn_file_actions_init(&fd_actions)) != 0
+         || (fd_actions_set = 1,
+             err = posix_spawnattr_init(&attr)) != 0
+         || (attr_set = 1,
+             err = posix_spawnattr_setflags(&attr, flags)) != 0
+         || (err = posix_spawnattr_setsigdefault(&attr, &sigdefault)) != 0
+         || (err = posix_spawn_file_actions_adddup2(&fd_actions, stdin_fd, STDIN_FILENO)) != 0)
+    {
+        if (attr_set == 1)
+            posix_spawnattr_destroy(&attr);
+
+        if (fd_actions_set == 1)
+            posix_spawn_file_actions_destroy(&fd_actions);
+
+        perror_msg_and_die("posix_spawn init");
+    }
+
+    if ((err = posix_spawnp(&pid, prog[0], &fd_actions, &attr, prog, environ)) != 0)
+        perror_msg_and_die(_("Can't execute '%s'"), prog[0]);
+
+    if ((err = posix_spawn_file_actions_destroy(&fd_actions)) != 0
+         || (err = posix_spawnattr_destroy(&attr)) != 0)
+         perror_msg_and_die("posix_spawn destroy");
+
+    return pid;
+}
+
+static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list,
+        const struct abrt_string_matcher *matcher, char **prog)
+{
     /* fstat(fd, &statbuf) was just done by caller */
 
     off_t cur_pos = lseek(fd, 0, SEEK_CUR);
@@ -83,17 +129,13 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
         if (map != MAP_FAILED)
         {
             char *start = (char*)map + (cur_pos & (page_size - 1));
-            for (GList *l = match_list; l; l = l->next)
+            log_debug("Searching in '%.*s'", length > 20 ? 20 : (int)length, start);
+            /* All strings are searched for in one pass over the new data */
+            const int found = abrt_string_matcher_find(matcher, start, length);
+            if (found >= 0)
             {
-                log_debug("Searching for '%s' in '%.*s'",
-                                (char*)l->data,
-                                length > 20 ? 20 : (int)length, start
-                );
-                if (memstr(start, length, (char*)l->data))
-                {
-                    log_debug("FOUND:'%s'", (char*)l->data);
-                    goto found;
-                }
+                log_debug("FOUND:'%s'", (char*)g_list_nth_data(match_list, found));
+                goto found;
             }
             /* None of the strings are found */
             log_debug("NOT FOUND");
@@ -105,33 +147,7 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
         }
     }
 
-    fflush(NULL); /* paranoia */
-
-    if ((err = posix_spawn_file_actions_init(&fd_actions)) != 0
-#ifdef POSIX_SPAWN_USEVFORK
-         || (err = posix_spawnattr_init(&attr)) != 0
-         || (attr_set = 1,
-             err = posix_spawnattr_setflags(&attr, POSIX_SPAWN_USEVFORK)) != 0
-#endif
-         || (fd_actions_set = 1,
-             err = posix_spawn_file_actions_adddup2(&fd_actions, fd, STDIN_FILENO)) != 0)
-    {
-        if (attr_set == 1)
-            posix_spawnattr_destroy(&attr);
-
-        if (fd_actions_set == 1)
-            posix_spawn_file_actions_destroy(&fd_actions);
-
-        perror_msg_and_die("posix_spawn init");
-    }
-
-    if ((err = posix_spawnp(&pid, prog[0], &fd_actions, &attr, prog, environ)) != 0)
-        perror_msg_and_die(_("Can't execute '%s'"), prog[0]);
-
-    if ((err = posix_spawn_file_actions_destroy(&fd_actions)) != 0
-         || ((attr_set == 1) && ((err = posix_spawnattr_destroy(&attr)) != 0)))
-         perror_msg_and_die("posix_spawn destroy");
-
+    pid_t pid = spawn_prog(prog, fd);
     libreport_safe_waitpid(pid, NULL, 0);
 
     /* Check fd's position, and move to end if it wasn't advanced.
@@ -145,6 +161,433 @@ static void run_scanner_prog(int fd, struct stat *statbuf, GList *match_list, ch
     }
 }
 
+/*
+ * The watch
+ *
+ * All files are watched by a single inotify instance: the file itself for
+ * modifications and its directory for the file being (re)created. A change
+ * is processed once the coalescing window since the first unprocessed change
+ * of the file is over, there are no fixed sleeps.
+ */
+
+enum watch_mode
+{
+    /* Run PROG with the file on stdin whenever the file grows */
+    WATCH_SPAWN,
+    /* Write new lines of all files to stdin of a single PROG process */
+    WATCH_PIPE,
+    /* Extract oopses from new lines in this process */
+    WATCH_KOOPS,
+};
+
+struct watched_file
+{
+    char *filename;
+    /* Points into filename */
+    const char *basename;
+    int fd;
+    int wd;
+    int dir_wd;
+    /* Monotonic time of the first unprocessed change in microseconds, 0 if
+     * there is no such change */
+    gint64 changed_since;
+
+    /* WATCH_PIPE: the incomplete last line, the scanner must not get lines
+     * of two files mixed up */
+    GString *partial_line;
+
+    /* WATCH_KOOPS */
+    struct abrt_koops_extractor *extractor;
+    gint64 last_data;
+
+    /* Monotonic time of the last attempt to open the file if neither the
+     * file nor its directory exist, 0 otherwise */
+    gint64 missing_since;
+};
+
+struct watch
+{
+    enum watch_mode mode;
+    int inotify_fd;
+    struct watched_file *files;
+    unsigned files_count;
+    unsigned window_ms;
+
+    /* WATCH_SPAWN and WATCH_PIPE */
+    char **prog;
+    GList *match_list;
+    struct abrt_string_matcher *matcher;
+
+    /* WATCH_PIPE */
+    pid_t scanner_pid;
+    int scanner_fd;
+
+    /* WATCH_KOOPS */
+    struct abrt_koops_parser *parser;
+    const char *dump_location;
+};
+
+static void scanner_stop(struct watch *watch)
+{
+    if (watch->scanner_fd < 0)
+        return;
+
+    /* The scanner gets EOF */
+    close(watch->scanner_fd);
+    watch->scanner_fd = -1;
+    libreport_safe_waitpid(watch->scanner_pid, NULL, 0);
+    watch->scanner_pid = 0;
+}
+
+static void scanner_start(struct watch *watch)
+{
+    int pipefds[2];
+    if (pipe2(pipefds, O_CLOEXEC) != 0)
+        perror_msg_and_die("pipe");
+
+    watch->scanner_pid = spawn_prog(watch->prog, pipefds[0]);
+    close(pipefds[0]);
+    watch->scanner_fd = pipefds[1];
+    log_info("Started scanner '%s' (pid %d)", watch->prog[0], (int)watch->scanner_pid);
+}
+
+static void scanner_write(struct watch *watch, const char *data, size_t size)
+{
+    if (size == 0)
+        return;
+
+    if (watch->scanner_fd < 0)
+        scanner_start(watch);
+
+    if (libreport_full_write(watch->scanner_fd, data, size) == (ssize_t)size)
+        return;
+
+    /* The scanner exited, restart it and give it one more chance */
+    log_warning("Scanner '%s' stopped reading its input, restarting it", watch->prog[0]);
+    scanner_stop(watch);
+    scanner_start(watch);
+
+    if (libreport_full_write(watch->scanner_fd, data, size) != (ssize_t)size)
+        perror_msg_and_die(_("Can't write to '%s'"), watch->prog[0]);
+}
+
+/*
+ * Passes only complete lines to the scanner.
+ */
+static void scanner_write_lines(struct watch *watch, struct watched_file *file,
+        const char *data, size_t size)
+{
+    const char *const eol = memrchr(data, '\n', size);
+    if (eol == NULL)
+    {
+        g_string_append_len(file->partial_line, data, size);
+        /* Don't let a file without new lines eat all memory */
+        if (file->partial_line->len >= STREAM_BLOCK)
+        {
+            scanner_write(watch, file->partial_line->str, file->partial_line->len);
+            g_string_truncate(file->partial_line, 0);
+        }
+        return;
+    }
+
+    const size_t complete = eol + 1 - data;
+    if (file->partial_line->len != 0)
+    {
+        g_string_append_len(file->partial_line, data, complete);
+        scanner_write(watch, file->partial_line->str, file->partial_line->len);
+        g_string_truncate(file->partial_line, 0);
+    }
+    else
+        scanner_write(watch, data, complete);
+
+    g_string_append_len(file->partial_line, eol + 1, size - complete);
+}
+
+static void watch_process_oopses(struct watch *watch, GList *oopses)
+{
+    if (oopses == NULL)
+        return;
+
+    abrt_oops_process_list(oopses, watch->dump_location, ABRT_WATCH_LOG_KOOPS_ANALYZER,
+                           ABRT_OOPS_THROTTLE_CREATION);
+    g_list_free_full(oopses, (GDestroyNotify)free);
+}
+
+static void watch_finish_koops(struct watch *watch, struct watched_file *file)
+{
+    GList *oopses = NULL;
+    abrt_koops_extractor_finish(file->extractor, &oopses);
+    watch_process_oopses(watch, oopses);
+}
+
+/*
+ * Reads the file from the current position to its end.
+ */
+static void watch_stream_file(struct watch *watch, struct watched_file *file, struct stat *statbuf)
+{
+    off_t cur_pos = lseek(file->fd, 0, SEEK_CUR);
+    if (statbuf->st_size <= cur_pos)
+    {
+        /* The same trick as in run_scanner_prog() */
+        if (statbuf->st_size < cur_pos)
+            statbuf->st_ino++;
+        return;
+    }
+
+    log_info("File '%s' grew by %llu bytes", file->filename,
+        (long long)(statbuf->st_size - cur_pos));
+
+    g_autofree char *buffer = g_malloc(STREAM_BLOCK);
+    GList *oopses = NULL;
+    for (;;)
+    {
+        const ssize_t r = libreport_safe_read(file->fd, buffer, STREAM_BLOCK);
+        if (r <= 0)
+            break;
+
+        if (watch->mode == WATCH_PIPE)
+            scanner_write_lines(watch, file, buffer, r);
+        else
+            abrt_koops_extractor_feed(file->extractor, &oopses, buffer, r);
+    }
+
+    if (watch->mode == WATCH_KOOPS)
+    {
+        file->last_data = g_get_monotonic_time();
+        watch_process_oopses(watch, oopses);
+    }
+}
+
+static void watch_close_file(struct watch *watch, struct watched_file *file)
+{
+    if (watch->mode == WATCH_PIPE && file->partial_line->len != 0)
+    {
+        g_string_append_c(file->partial_line, '\n');
+        scanner_write(watch, file->partial_line->str, file->partial_line->len);
+        g_string_truncate(file->partial_line, 0);
+    }
+    else if (watch->mode == WATCH_KOOPS)
+        watch_finish_koops(watch, file);
+
+    close(file->fd);
+    if (file->wd >= 0)
+        inotify_rm_watch(watch->inotify_fd, file->wd);
+    file->fd = -1;
+    file->wd = -1;
+}
+
+static void watch_scan_file(struct watch *watch, struct watched_file *file, struct stat *statbuf)
+{
+    if (watch->mode == WATCH_SPAWN)
+        run_scanner_prog(file->fd, statbuf, watch->match_list, watch->matcher, watch->prog);
+    else
+        watch_stream_file(watch, file, statbuf);
+}
+
+static void watch_update_file(struct watch *watch, struct watched_file *file)
+{
+    struct stat statbuf;
+
+    /* If file is already opened, scan it from current pos */
+    if (file->fd >= 0)
+    {
+        memset(&statbuf, 0, sizeof(statbuf));
+        if (fstat(file->fd, &statbuf) != 0)
+            goto close_fd;
+        watch_scan_file(watch, file, &statbuf);
+
+        /* Was file deleted or replaced? */
+        ino_t fd_ino = statbuf.st_ino;
+        if (stat(file->filename, &statbuf) != 0 || statbuf.st_ino != fd_ino) /* yes */
+        {
+            log_info("Inode# of '%s' changed, closing fd", file->filename);
+ close_fd:
+            watch_close_file(watch, file);
+        }
+    }
+
+    /* If file isn't opened, try to open it and scan */
+    if (file->fd < 0)
+    {
+        if (file->dir_wd < 0)
+        {
+            g_autofree char *dirname = g_path_get_dirname(file->filename);
+            file->dir_wd = inotify_add_watch(watch->inotify_fd, dirname, IN_CREATE | IN_MOVED_TO);
+            if (file->dir_wd < 0)
+                log_info("Can't watch directory '%s': %s", dirname, strerror(errno));
+        }
+
+        file->fd = open(file->filename, O_RDONLY | O_CLOEXEC);
+        if (file->fd >= 0)
+        {
+            log_info("Opened '%s'", file->filename);
+            file->wd = inotify_add_watch(watch->inotify_fd, file->filename,
+                                         IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+            if (file->wd < 0)
+                perror_msg("inotify_add_watch failed on '%s'", file->filename);
+            else
+                log_info("Added inotify watch for '%s'", file->filename);
+
+            if (fstat(file->fd, &statbuf) == 0)
+            {
+                /* If file is large, skip the beginning.
+                 * IOW: ignore old log messages because they are unlikely
+                 * to have sufficiently recent data to be useful.
+                 */
+                if (statbuf.st_size > (MAX_SCAN_BLOCK - READ_AHEAD))
+                    lseek(file->fd, statbuf.st_size - (MAX_SCAN_BLOCK - READ_AHEAD), SEEK_SET);
+                /* Note that statbuf is filled by fstat by now,
+                 * watch_scan_file needs that
+                 */
+                watch_scan_file(watch, file, &statbuf);
+            }
+        }
+    }
+
+    /* Nothing tells us when the directory appears */
+    file->missing_since = (file->fd < 0 && file->dir_wd < 0) ? g_get_monotonic_time() : 0;
+}
+
+static void watch_mark_changed(struct watched_file *file, gint64 now)
+{
+    if (file->changed_since == 0)
+        file->changed_since = now;
+}
+
+static void watch_read_events(struct watch *watch)
+{
+    /* Enough for many events at once */
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    const ssize_t len = read(watch->inotify_fd, buf, sizeof(buf));
+    if (len < 0)
+    {
+        if (errno != EINTR && errno != EAGAIN) /* I saw EINTR here on strace attach */
+            perror_msg("Error reading inotify fd");
+        return;
+    }
+
+    const gint64 now = g_get_monotonic_time();
+    for (char *p = buf; p < buf + len; )
+    {
+        const struct inotify_event *event = (const struct inotify_event *)p;
+        p += sizeof(*event) + event->len;
+
+        for (unsigned i = 0; i < watch->files_count; ++i)
+        {
+            struct watched_file *file = &watch->files[i];
+
+            /* Lost events, check everything */
+            if (event->mask & IN_Q_OVERFLOW)
+                watch_mark_changed(file, now);
+            /* we don't actually check what happened to file -
+             * watch_update_file() will handle all possibilities.
+             */
+            else if (event->wd == file->wd)
+                watch_mark_changed(file, now);
+            else if (event->wd == file->dir_wd && event->len != 0
+                     && strcmp(event->name, file->basename) == 0)
+                watch_mark_changed(file, now);
+        }
+    }
+}
+
+/*
+ * Processes the files whose coalescing window is over and returns the
+ * number of milliseconds until the next file needs attention or -1.
+ */
+static int watch_process(struct watch *watch)
+{
+    const gint64 now = g_get_monotonic_time();
+    int timeout_ms = -1;
+
+#define UPDATE_TIMEOUT(remaining_ms) \
+    do { \
+        const int r_ = (remaining_ms); \
+        if (timeout_ms < 0 || r_ < timeout_ms) \
+            timeout_ms = r_; \
+    } while (0)
+
+    for (unsigned i = 0; i < watch->files_count; ++i)
+    {
+        struct watched_file *file = &watch->files[i];
+
+        if (file->changed_since != 0)
+        {
+            const gint64 elapsed_ms = (now - file->changed_since) / 1000;
+            if (elapsed_ms >= watch->window_ms)
+            {
+                log_debug("Change in '%s' detected", file->filename);
+                file->changed_since = 0;
+                watch_update_file(watch, file);
+            }
+            else
+                UPDATE_TIMEOUT(watch->window_ms - elapsed_ms);
+        }
+
+        /* The writer may be in the middle of the last line, the oops is
+         * complete only if the silence comes after a whole line. An
+         * incomplete line is analyzed when the file is closed. */
+        if (watch->mode == WATCH_KOOPS && !abrt_koops_extractor_is_idle(file->extractor)
+            && !abrt_koops_extractor_has_partial_line(file->extractor))
+        {
+            const gint64 elapsed_ms = (now - file->last_data) / 1000;
+            if (elapsed_ms >= KOOPS_IDLE_MS)
+                watch_finish_koops(watch, file);
+            else
+                UPDATE_TIMEOUT(KOOPS_IDLE_MS - elapsed_ms);
+        }
+
+        if (file->missing_since != 0)
+        {
+            const gint64 elapsed_ms = (now - file->missing_since) / 1000;
+            if (elapsed_ms >= MISSING_DIR_RETRY_MS)
+                watch_update_file(watch, file);
+            else
+                UPDATE_TIMEOUT(MISSING_DIR_RETRY_MS - elapsed_ms);
+        }
+    }
+
+#undef UPDATE_TIMEOUT
+
+    return timeout_ms;
+}
+
+static void watch_run(struct watch *watch)
+{
+    /* services usually exit on SIGTERM and SIGHUP */
+    signal(SIGTERM, signal_loop_to_terminate);
+    signal(SIGHUP, signal_loop_to_terminate);
+    /* Ctrl-C for easier debugging */
+    signal(SIGINT, signal_loop_to_terminate);
+    /* A dead scanner is restarted */
+    signal(SIGPIPE, SIG_IGN);
+
+    const gint64 now = g_get_monotonic_time();
+    for (unsigned i = 0; i < watch->files_count; ++i)
+    {
+        watch->files[i].changed_since = now - (gint64)watch->window_ms * 1000;
+        watch->files[i].last_data = now;
+    }
+
+    while (!s_loop_terminated)
+    {
+        const int timeout_ms = watch_process(watch);
+
+        struct pollfd pollfd = { .fd = watch->inotify_fd, .events = POLLIN };
+        /* We block here: */
+        if (poll(&pollfd, 1, timeout_ms) > 0)
+            watch_read_events(watch);
+    }
+
+    for (unsigned i = 0; i < watch->files_count; ++i)
+    {
+        if (watch->files[i].fd >= 0)
+            watch_close_file(watch, &watch->files[i]);
+    }
+
+    scanner_stop(watch);
+}
+
 int main(int argc, char **argv)
 {
     /* I18n */
@@ -159,22 +602,41 @@ int main(int argc, char **argv)
     page_size = sysconf(_SC_PAGE_SIZE);
 
     GList *match_list = NULL;
+    GList *more_files = NULL;
+    int window_ms = -1;
+    char *koops_dump_location = NULL;
 
     /* Can't keep these strings/structs static: _() doesn't support that */
     const char *program_usage_string = _(
-        "& [-vs] [-F STR]... FILE PROG [ARGS]\n"
+        "& [-vsp] [-F STR]... [-f FILE]... [-w NUM] FILE PROG [ARGS]\n"
+        "or: & [-vs] [-f FILE]... [-w NUM] -k DIR FILE...\n"
+        "\n"
+        "Watch log file FILE, run PROG when it grows or is replaced\n"
+        "\n"
+        "With -p, PROG is started only once and new lines of all watched files\n"
+        "are written to its standard input.\n"
         "\n"
-        "Watch log file FILE, run PROG when it grows or is replaced"
+        "With -k, oopses are extracted from new lines of all watched files\n"
+        "without running any program."
     );
     enum {
         OPT_v = 1 << 0,
         OPT_s = 1 << 1,
+        OPT_F = 1 << 2,
+        OPT_f = 1 << 3,
+        OPT_w = 1 << 4,
+        OPT_p = 1 << 5,
+        OPT_k = 1 << 6,
     };
     /* Keep enum above and order of options below in sync! */
     struct options program_options[] = {
         OPT__VERBOSE(&libreport_g_verbose),
         OPT_BOOL('s', NULL, NULL              , _("Log to syslog")),
         OPT_LIST('F', NULL, &match_list, "STR", _("Don't run PROG if STRs aren't found")),
+        OPT_LIST('f', NULL, &more_files, "FILE", _("Watch also FILE")),
+        OPT_INTEGER('w', NULL, &window_ms     , _("Process changes NUM milliseconds after the first one (default: 1000, 0 with -p or -k)")),
+        OPT_BOOL('p', NULL, NULL              , _("Keep PROG running and write new lines to its standard input")),
+        OPT_STRING('k', NULL, &koops_dump_location, "DIR", _("Create new problem directory in DIR for every oops found")),
         OPT_END()
     };
     unsigned opts = libreport_parse_opts(argc, argv, program_options, program_usage_string);
@@ -187,8 +649,25 @@ int main(int argc, char **argv)
         libreport_logmode = LOGMODE_JOURNAL;
     }
 
+    if ((opts & OPT_p) && (opts & OPT_k))
+        error_msg_and_die(_("-p and -k can't be used together"));
+
+    /* The string filter can't skip parts of a stream */
+    if ((opts & OPT_F) && (opts & (OPT_p | OPT_k)))
+        error_msg_and_die(_("-F can't be used with -p or -k"));
+
+    struct watch watch = {
+        .mode = (opts & OPT_p) ? WATCH_PIPE : (opts & OPT_k) ? WATCH_KOOPS : WATCH_SPAWN,
+        .scanner_fd = -1,
+        .dump_location = koops_dump_location,
+    };
+
+    if (window_ms < 0)
+        window_ms = watch.mode == WATCH_SPAWN ? DEFAULT_SPAWN_WINDOW_MS : 0;
+    watch.window_ms = window_ms;
+
     argv += optind;
-    if (!argv[0] || !argv[1])
+    if (!argv[0] || (watch.mode != WATCH_KOOPS && !argv[1]))
         libreport_show_usage_and_die(program_usage_string, program_options);
 
     /* We want to support -F "`echo foo; echo bar`" -
@@ -207,100 +686,56 @@ int main(int argc, char **argv)
         l = g_list_append(l, eol); /* in fact, always returns unchanged l */
     }
 
-    const char *filename = *argv++;
+    watch.match_list = match_list;
+    if (match_list)
+        watch.matcher = abrt_string_matcher_new_from_list(match_list);
+
+    /* FILE PROG [ARGS] or FILE... */
+    GList *filenames = NULL;
+    do
+        filenames = g_list_append(filenames, *argv++);
+    while (watch.mode == WATCH_KOOPS && *argv);
+    filenames = g_list_concat(filenames, more_files);
+    watch.prog = argv;
+
+    if (watch.mode == WATCH_KOOPS)
+        watch.parser = abrt_koops_parser_new();
+
+    watch.files_count = g_list_length(filenames);
+    watch.files = g_new0(struct watched_file, watch.files_count);
+    unsigned i = 0;
+    for (GList *l = filenames; l; l = l->next, ++i)
+    {
+        struct watched_file *file = &watch.files[i];
+        file->filename = (char *)l->data;
+        const char *slash = strrchr(file->filename, '/');
+        file->basename = slash ? slash + 1 : file->filename;
+        file->fd = -1;
+        file->wd = -1;
+        file->dir_wd = -1;
+        if (watch.mode == WATCH_PIPE)
+            file->partial_line = g_string_new(NULL);
+        else if (watch.mode == WATCH_KOOPS)
+            file->extractor = abrt_koops_extractor_new(watch.parser);
+    }
+    g_list_free(filenames);
 
-    int inotify_fd = inotify_init();
-    if (inotify_fd == -1)
+    watch.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch.inotify_fd == -1)
         perror_msg_and_die("inotify_init failed");
-    libreport_close_on_exec_on(inotify_fd);
 
-    struct stat statbuf;
-    int file_fd = -1;
-    int wd = -1;
+    watch_run(&watch);
 
-    while (1)
+    for (i = 0; i < watch.files_count; ++i)
     {
-        /* If file is already opened, scan it from current pos */
-        if (file_fd >= 0)
-        {
-            memset(&statbuf, 0, sizeof(statbuf));
-            if (fstat(file_fd, &statbuf) != 0)
-                goto close_fd;
-            run_scanner_prog(file_fd, &statbuf, match_list, argv);
-
-            /* Was file deleted or replaced? */
-            ino_t fd_ino = statbuf.st_ino;
-            if (stat(filename, &statbuf) != 0 || statbuf.st_ino != fd_ino) /* yes */
-            {
-                log_info("Inode# changed, closing fd");
- close_fd:
-                close(file_fd);
-                if (wd >= 0)
-                    inotify_rm_watch(inotify_fd, wd);
-                file_fd = -1;
-                wd = -1;
-            }
-        }
-
-        /* If file isn't opened, try to open it and scan */
-        if (file_fd < 0)
-        {
-            file_fd = open(filename, O_RDONLY);
-            if (file_fd >= 0)
-            {
-                log_info("Opened '%s'", filename);
-                /* For -w case, if we don't have inotify watch yet, open one */
-                if (wd < 0)
-                {
-                    wd = inotify_add_watch(inotify_fd, filename, IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
-                    if (wd < 0)
-                        perror_msg("inotify_add_watch failed on '%s'", filename);
-                    else
-                        log_info("Added inotify watch for '%s'", filename);
-                }
-                if (fstat(file_fd, &statbuf) == 0)
-                {
-                    /* If file is large, skip the beginning.
-                     * IOW: ignore old log messages because they are unlikely
-                     * to have sufficiently recent data to be useful.
-                     */
-                    if (statbuf.st_size > (MAX_SCAN_BLOCK - READ_AHEAD))
-                        lseek(file_fd, statbuf.st_size - (MAX_SCAN_BLOCK - READ_AHEAD), SEEK_SET);
-                    /* Note that statbuf is filled by fstat by now,
-                     * run_scanner_prog needs that
-                     */
-                    run_scanner_prog(file_fd, &statbuf, match_list, argv);
-                }
-            }
-        }
-
-        /* Even if log file grows all the time, say, a new line every 5 ms,
-         * we don't want to scan it all the time. Sleep a bit and let it grow
-         * in bigger increments.
-         * Sleep longer if file does not exist.
-         */
-        sleep(file_fd >= 0 ? 1 : 59);
-
-        /* Now wait for it to change, be moved or deleted */
-        if (wd >= 0)
-        {
-            char buf[4096];
-            log_debug("Waiting for '%s' to change", filename);
-            /* We block here: */
-            int len = read(inotify_fd, buf, sizeof(buf));
-            if (len < 0 && errno != EINTR) /* I saw EINTR here on strace attach */
-                perror_msg("Error reading inotify fd");
-            /* we don't actually check what happened to file -
-             * the code will handle all possibilities.
-             */
-            log_debug("Change in '%s' detected", filename);
-            /* Let them finish writing to the log file. otherwise
-             * we may end up trying to analyze partial oops.
-             */
-            sleep(1);
-        }
-
-    } /* while (1) */
+        if (watch.files[i].partial_line)
+            g_string_free(watch.files[i].partial_line, TRUE);
+        abrt_koops_extractor_free(watch.files[i].extractor);
+    }
+    free(watch.files);
+    abrt_koops_parser_free(watch.parser);
+    abrt_string_matcher_free(watch.matcher);
+    close(watch.inotify_fd);
 
     return 0;
 }
@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include <satyr/thread.h>
+#include <satyr/core/stacktrace.h>
+#include <satyr/core/thread.h>
+#include <satyr/core/frame.h>
+#include <satyr/normalize.h>
+
+#ifdef HAVE_LIBRPM
+#include <rpm/rpmlib.h>
+#include <rpm/rpmts.h>
+#include <rpm/rpmdb.h>
+#endif
+
+#include "core-utils.h"
+#include "libabrt.h"
+
+void abrt_core_trim_unstrip_output(char *result, const char *unstrip_n_output)
+{
+    // lines look like this:
+    // 0x400000+0x209000 23c77451cf6adff77fc1f5ee2a01d75de6511dda@0x40024c - - [exe]
+    // 0x400000+0x209000 ab3c8286aac6c043fd1bb1cc2a0b88ec29517d3e@0x40024c /bin/sleep /usr/lib/debug/bin/sleep.debug [exe]
+    // 0x7fff313ff000+0x1000 389c7475e3d5401c55953a425a2042ef62c4c7df@0x7fff313ff2f8 . - linux-vdso.so.1
+    //                ^^^^^^ ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+    // we drop everything except the marked part ^
+    // 0x7f1e2a3b4000+0x203000 - /usr/lib64/libfoo.so - /usr/lib64/libfoo.so
+    //                ^^^^^^^^
+    // only the size is kept of modules without build id, the rest depends
+    // on the files found on the disk
+
+    char *dst = result;
+    const char *line = unstrip_n_output;
+    while (*line)
+    {
+        const char *eol = strchrnul(line, '\n');
+        const char *plus = (char*)memchr(line, '+', eol - line);
+        if (plus)
+        {
+            const char *end = plus + 1;
+            while (end < eol && !isspace(*end))
+                ++end;
+            const char *build_id = end;
+            while (build_id < eol && isspace(*build_id))
+                ++build_id;
+            if (build_id < eol && *build_id != '-')
+            {
+                end = (const char *)memchr(build_id, '@', eol - build_id);
+                if (!end)
+                    end = eol;
+            }
+
+            while (++plus < end)
+            {
+                if (!isspace(*plus))
+                {
+                    *dst++ = *plus;
+                }
+            }
+        }
+        if (*eol != '\n') break;
+        line = eol + 1;
+    }
+    *dst = '\0';
+}
+
+static struct sr_core_thread *
+core_thread_from_core_stacktrace(struct sr_core_stacktrace *stacktrace)
+{
+    struct sr_core_thread *thread = sr_core_stacktrace_find_crash_thread(stacktrace);
+    if (!thread)
+    {
+        log_info("Failed to find crash thread");
+        return NULL;
+    }
+
+    return thread;
+}
+
+struct sr_core_stacktrace *abrt_core_stacktrace_from_json(const char *json)
+{
+    g_autofree char *error = NULL;
+    struct sr_core_stacktrace *stacktrace = sr_core_stacktrace_from_json_text(json, &error);
+    if (!stacktrace)
+    {
+        if (error)
+        {
+            log_info("Failed to parse core backtrace: %s", error);
+        }
+        return NULL;
+    }
+
+    return stacktrace;
+}
+
+char *abrt_core_build_ids_from_stacktrace(struct sr_core_stacktrace *stacktrace)
+{
+    struct sr_core_thread *thread = core_thread_from_core_stacktrace(stacktrace);
+
+    if (!thread)
+        return NULL;
+
+    void *build_id_list = NULL;
+
+    GString *strbuf = g_string_new(NULL);
+    for (struct sr_core_frame *frame = thread->frames;
+         frame;
+         frame = frame->next)
+    {
+        if (frame->build_id)
+            build_id_list = g_list_prepend(build_id_list, frame->build_id);
+    }
+
+    build_id_list = g_list_sort(build_id_list, (GCompareFunc)strcmp);
+    for (GList *iter = build_id_list; iter; iter = g_list_next(iter))
+    {
+        GList *next = g_list_next(iter);
+        if (next == NULL || 0 != strcmp(iter->data, next->data))
+        {
+            g_string_append_printf(strbuf, "%s\n", (char *)iter->data);
+        }
+    }
+    g_list_free(build_id_list);
+
+    return g_string_free(strbuf, FALSE);
+}
+
+void abrt_core_save_uuid(struct dump_dir *dd, const char *build_ids)
+{
+    char *executable = dd_load_text(dd, FILENAME_EXECUTABLE);
+    /* FILENAME_PACKAGE may be missing if ProcessUnpackaged = yes... */
+    /* ...then it is loaded as "" */
+    char *package = dd_load_text_ext(dd, FILENAME_PACKAGE, DD_FAIL_QUIETLY_ENOENT);
+    /* Package variable has "firefox-3.5.6-1.fc11[.1]" format */
+    /* Remove distro suffix and maybe least significant version number */
+    char *p = package;
+    while (*p)
+    {
+        if (*p == '.' && (p[1] < '0' || p[1] > '9'))
+        {
+            /* We found "XXXX.nondigitXXXX", trim this part */
+            *p = '\0';
+            break;
+        }
+        p++;
+    }
+    char *first_dot = strchr(package, '.');
+    if (first_dot)
+    {
+        char *last_dot = strrchr(first_dot, '.');
+        if (last_dot != first_dot)
+        {
+            /* There are more than one dot: "1.2.3"
+             * Strip last part, we don't want to distinguish crashes
+             * in packages which differ only by minor release number.
+             */
+            *last_dot = '\0';
+        }
+    }
+
+    g_autofree char *string_to_hash = g_strdup_printf("%s%s%s", package, executable, build_ids);
+    free(package);
+    free(executable);
+
+    log_debug("String to hash: %s", string_to_hash);
+
+    g_autofree char *checksum = g_compute_checksum_for_string(G_CHECKSUM_SHA1, string_to_hash, -1);
+
+    dd_save_text(dd, FILENAME_UUID, checksum);
+}
+
+void abrt_core_save_crash_function(struct dump_dir *dd, struct sr_core_stacktrace *stacktrace)
+{
+    struct sr_core_thread *thread = core_thread_from_core_stacktrace(stacktrace);
+
+    if (!thread)
+        return;
+
+    sr_normalize_core_thread(thread);
+
+    struct sr_core_frame *frame = thread->frames;
+    if (!frame)
+    {
+        log_info("Could not find any usable stack frame");
+        return;
+    }
+
+    if (frame->function_name)
+        dd_save_text(dd, FILENAME_CRASH_FUNCTION, frame->function_name);
+}
+
+char *abrt_core_dso_list_from_maps(const char *maps)
+{
+#ifdef HAVE_LIBRPM
+    if (rpmReadConfigFiles(NULL, NULL) != 0)
+    {
+        error_msg("Can't read RPM rc files");
+        return NULL;
+    }
+
+    /* We want to handle both /proc/PID/maps format:
+     *  4f200000-4f215000 r-xp 00000000 08:03 1835520   /usr/lib64/libz.so.1.2.7
+     * and Xorg backtrace format:
+     *  [ 86985.880] 9: /usr/lib64/libdrm.so.2 (drmHandleEvent+0xa3) [0x376b407513]
+     * To do that, we take only lines which have a / character,
+     * then for each line we start at first /, then remove everything after
+     * first whitespace.
+     */
+    g_autoptr(GHashTable) seen = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    GString *dso_list = g_string_new(NULL);
+    rpmts ts = rpmtsCreate();
+
+    for (const char *line = maps; *line != '\0'; )
+    {
+        const char *eol = strchrnul(line, '\n');
+        const char *slash = memchr(line, '/', eol - line);
+        if (slash != NULL)
+        {
+            const char *end = slash;
+            while (end < eol && !isspace(*end))
+                ++end;
+
+            char *path = g_strndup(slash, end - slash);
+            if (g_hash_table_add(seen, path))
+            {
+                rpmdbMatchIterator iter = rpmtsInitIterator(ts, RPMTAG_BASENAMES, path, 0);
+                Header header;
+                while ((header = rpmdbNextIterator(iter)) != NULL)
+                {
+                    const char *errmsg = NULL;
+                    g_autofree char *package = headerFormat(header,
+                            "%{NEVRA} (%|VENDOR?{%{VENDOR}}:{None}|) %{INSTALLTIME}", &errmsg);
+                    if (package == NULL)
+                    {
+                        error_msg("Can't get the package of '%s': %s", path, errmsg);
+                        continue;
+                    }
+                    g_string_append_printf(dso_list, "%s %s\n", path, package);
+                }
+                rpmdbFreeIterator(iter);
+            }
+        }
+
+        if (*eol == '\0')
+            break;
+        line = eol + 1;
+    }
+
+    rpmtsFree(ts);
+
+    if (dso_list->len == 0)
+    {
+        g_string_free(dso_list, TRUE);
+        return NULL;
+    }
+
+    return g_string_free(dso_list, FALSE);
+#else
+    return NULL;
+#endif
+}
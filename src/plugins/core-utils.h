@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_CORE_UTILS_H_
+#define _ABRT_CORE_UTILS_H_
+
+#include "libabrt.h"
+
+#include <satyr/core/stacktrace.h>
+
+#ifndef FILENAME_DSO_LIST
+#define FILENAME_DSO_LIST "dso_list"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Leaves only sizes and build ids of the output of 'eu-unstrip -n' */
+void abrt_core_trim_unstrip_output(char *result, const char *unstrip_n_output);
+
+/* Returns NULL if the text can't be parsed */
+struct sr_core_stacktrace *abrt_core_stacktrace_from_json(const char *json);
+
+/* Sorted unique build ids of the frames of the crash thread, one per line */
+char *abrt_core_build_ids_from_stacktrace(struct sr_core_stacktrace *stacktrace);
+
+/* Hashes package + executable + build_ids and saves it as FILENAME_UUID */
+void abrt_core_save_uuid(struct dump_dir *dd, const char *build_ids);
+
+/* Saves the function of the top frame of the crash thread as
+ * FILENAME_CRASH_FUNCTION, the crash thread is normalized */
+void abrt_core_save_crash_function(struct dump_dir *dd, struct sr_core_stacktrace *stacktrace);
+
+/* Takes the file names from the contents of a /proc/PID/maps file (or of
+ * a backtrace of Xorg) and returns the packages which own them in the
+ * format of dso_list, or NULL if none is owned by a package */
+char *abrt_core_dso_list_from_maps(const char *maps);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_CORE_UTILS_H_*/
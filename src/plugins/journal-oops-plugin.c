@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2014  ABRT team
+ * Copyright (C) 2014  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "journal-plugins.h"
+#include "oops-utils.h"
+
+/* Limit number of buffered lines */
+#define ABRT_JOURNAL_MAX_READ_LINES (1024 * 1024)
+
+/* Give systemd-journal one second to suck in all kernel's strings */
+#define ABRT_JOURNAL_OOPS_COLLECT_MS 1000
+
+/*
+ * Koops extractor
+ */
+
+struct koops_lines
+{
+    struct abrt_koops_line_info *lines_info;
+    size_t lines_info_count;
+    size_t lines_info_size;
+};
+
+/*
+ * Takes ownership of the line
+ */
+static void koops_lines_append(struct koops_lines *lines, char *line)
+{
+    if (lines->lines_info_count == lines->lines_info_size)
+    {
+        lines->lines_info_size = lines->lines_info_size ? lines->lines_info_size * 2 : 32;
+        lines->lines_info = g_realloc(lines->lines_info,
+                lines->lines_info_size * sizeof(lines->lines_info[0]));
+    }
+
+    char *orig_line = line;
+    struct abrt_koops_line_info *info = lines->lines_info + lines->lines_info_count;
+    info->level = abrt_koops_line_skip_level((const char **)&line);
+    abrt_koops_line_skip_jiffies((const char **)&line);
+
+    memmove(orig_line, line, strlen(line) + 1);
+
+    info->ptr = orig_line;
+
+    ++lines->lines_info_count;
+}
+
+static GList *koops_lines_extract_oopses(const struct abrt_koops_parser *parser, struct koops_lines *lines)
+{
+    GList *oops_list = NULL;
+    abrt_koops_parser_extract_oopses_from_lines(parser, &oops_list, lines->lines_info, lines->lines_info_count);
+
+    log_debug("Extracted: %d oopses", g_list_length(oops_list));
+
+    return oops_list;
+}
+
+static void koops_lines_clear(struct koops_lines *lines)
+{
+    for (size_t i = 0; i < lines->lines_info_count; ++i)
+        free(lines->lines_info[i].ptr);
+
+    free(lines->lines_info);
+    memset(lines, 0, sizeof(*lines));
+}
+
+GList *abrt_journal_extract_kernel_oops(abrt_journal_t *journal)
+{
+    struct koops_lines lines = { 0 };
+
+    do
+    {
+        char *line = abrt_journal_get_log_line(journal);
+        if (line == NULL)
+            error_msg_and_die(_("Cannot read journal data."));
+
+        koops_lines_append(&lines, line);
+    }
+    while (lines.lines_info_count < ABRT_JOURNAL_MAX_READ_LINES
+            && abrt_journal_next(journal) > 0);
+
+    struct abrt_koops_parser *parser = abrt_koops_parser_new();
+    GList *oops_list = koops_lines_extract_oopses(parser, &lines);
+    abrt_koops_parser_free(parser);
+    koops_lines_clear(&lines);
+
+    return oops_list;
+}
+
+/*
+ * Koops extractor end
+ */
+
+/*
+ * The plug-in starts collecting kernel messages when it sees a suspicious
+ * string and extracts oopses from the collected messages once the watch is
+ * idle and the collection period is over. The journal is never moved by the
+ * plug-in, so it can share the journal with other plug-ins.
+ */
+struct oops_plugin_data
+{
+    char *dump_location;
+    int oops_utils_flags;
+    /* Lives as long as the plug-in, so the patterns are compiled only once */
+    struct abrt_koops_parser *parser;
+
+    struct abrt_journal_watch_notify_strings notify_strings;
+
+    struct koops_lines lines;
+    /* Monotonic time of the first collected line in microseconds, 0 if
+     * nothing has been collected */
+    gint64 collecting_since;
+};
+
+static void oops_plugin_collect_line(abrt_journal_watch_t *watch, void *data)
+{
+    struct oops_plugin_data *oops_data = (struct oops_plugin_data *)data;
+
+    if (oops_data->lines.lines_info_count >= ABRT_JOURNAL_MAX_READ_LINES)
+        return;
+
+    char *line = abrt_journal_get_log_line(abrt_journal_watch_get_journal(watch));
+    if (line == NULL)
+        error_msg_and_die(_("Cannot read journal data."));
+
+    koops_lines_append(&oops_data->lines, line);
+
+    if (oops_data->collecting_since == 0)
+        oops_data->collecting_since = g_get_monotonic_time();
+}
+
+static void oops_plugin_callback(abrt_journal_watch_t *watch, void *data)
+{
+    struct oops_plugin_data *oops_data = (struct oops_plugin_data *)data;
+
+    if (oops_data->collecting_since != 0)
+        oops_plugin_collect_line(watch, data);
+    else
+        abrt_journal_watch_notify_strings(watch, &oops_data->notify_strings);
+}
+
+static bool oops_plugin_pending_callback(void *data)
+{
+    return ((struct oops_plugin_data *)data)->collecting_since != 0;
+}
+
+static void oops_plugin_flush_callback(void *data)
+{
+    struct oops_plugin_data *oops_data = (struct oops_plugin_data *)data;
+
+    if (oops_data->collecting_since == 0)
+        return;
+
+    GList *oopses = koops_lines_extract_oopses(oops_data->parser, &oops_data->lines);
+    koops_lines_clear(&oops_data->lines);
+    oops_data->collecting_since = 0;
+
+    abrt_oops_process_list(oopses, oops_data->dump_location,
+                           ABRT_JOURNAL_KOOPS_ANALYZER, oops_data->oops_utils_flags);
+
+    g_list_free_full(oopses, (GDestroyNotify)free);
+}
+
+static int oops_plugin_idle_callback(abrt_journal_watch_t *watch, void *data)
+{
+    struct oops_plugin_data *oops_data = (struct oops_plugin_data *)data;
+
+    if (oops_data->collecting_since == 0)
+        return -1;
+
+    const gint64 elapsed_ms = (g_get_monotonic_time() - oops_data->collecting_since) / 1000;
+    if (elapsed_ms < ABRT_JOURNAL_OOPS_COLLECT_MS)
+        return ABRT_JOURNAL_OOPS_COLLECT_MS - elapsed_ms;
+
+    oops_plugin_flush_callback(data);
+    return -1;
+}
+
+static GList *oops_plugin_suspicious_strings(void)
+{
+    GList *koops_strings = abrt_koops_suspicious_strings_list();
+
+    g_autofree char *oops_string_filter_regex = abrt_oops_string_filter_regex();
+    if (oops_string_filter_regex)
+    {
+        regex_t filter_re;
+        if (regcomp(&filter_re, oops_string_filter_regex, REG_NOSUB) != 0)
+            perror_msg_and_die(_("Failed to compile regex"));
+
+        GList *iter = koops_strings;
+        while(iter != NULL)
+        {
+            GList *next = g_list_next(iter);
+
+            const int reti = regexec(&filter_re, (const char *)iter->data, 0, NULL, 0);
+            if (reti == 0)
+                koops_strings = g_list_delete_link(koops_strings, iter);
+            else if (reti != REG_NOMATCH)
+            {
+                char msgbuf[100];
+                regerror(reti, &filter_re, msgbuf, sizeof(msgbuf));
+                error_msg_and_die("Regex match failed: %s", msgbuf);
+            }
+
+            iter = next;
+        }
+
+        regfree(&filter_re);
+    }
+
+    return koops_strings;
+}
+
+static void oops_plugin_data_free(struct oops_plugin_data *oops_data)
+{
+    if (oops_data == NULL)
+        return;
+
+    koops_lines_clear(&oops_data->lines);
+    abrt_koops_parser_free(oops_data->parser);
+    abrt_journal_watch_notify_strings_destroy(&oops_data->notify_strings);
+    g_list_free(oops_data->notify_strings.strings);
+    g_list_free(oops_data->notify_strings.blacklisted_strings);
+    free(oops_data->dump_location);
+    free(oops_data);
+}
+
+struct abrt_journal_watch_plugin *abrt_journal_oops_plugin_new(GList *journal_filters,
+        const char *dump_location, int oops_utils_flags)
+{
+    struct oops_plugin_data *oops_data = g_new0(struct oops_plugin_data, 1);
+    oops_data->dump_location = g_strdup(dump_location);
+    oops_data->oops_utils_flags = oops_utils_flags;
+    oops_data->parser = abrt_koops_parser_new();
+    oops_data->notify_strings.decorated_cb = oops_plugin_collect_line;
+    oops_data->notify_strings.decorated_cb_data = oops_data;
+    oops_data->notify_strings.strings = oops_plugin_suspicious_strings();
+    oops_data->notify_strings.blacklisted_strings = abrt_koops_suspicious_strings_blacklist();
+
+    struct abrt_journal_watch_plugin *plugin = g_new0(struct abrt_journal_watch_plugin, 1);
+    plugin->name = "kernel oops";
+    plugin->journal_filters = g_list_copy_deep(journal_filters, (GCopyFunc)g_strdup, NULL);
+    plugin->callback = oops_plugin_callback;
+    plugin->idle_callback = oops_plugin_idle_callback;
+    plugin->pending_callback = oops_plugin_pending_callback;
+    plugin->flush_callback = oops_plugin_flush_callback;
+    plugin->data = oops_data;
+    plugin->free_data = (GDestroyNotify)oops_plugin_data_free;
+
+    return plugin;
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2026  ABRT team
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#ifndef _ABRT_JOURNAL_PLUGINS_H_
+#define _ABRT_JOURNAL_PLUGINS_H_
+
+#include "abrt-journal.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sources of problems for struct abrt_journal_watch_dispatcher
+ *
+ * The constructors take a copy of the journal filters.
+ */
+
+/*
+ * Core dumps stored in journal by systemd-coredump
+ * (journal-core-plugin.c)
+ */
+enum {
+    ABRT_CORE_PRINT_STDOUT = 1 << 0,
+    ABRT_CORE_KEEP_COMPRESSED = 1 << 1,
+};
+
+#define ABRT_JOURNAL_CORE_DEFAULT_FILTER "SYSLOG_IDENTIFIER=systemd-coredump"
+
+struct abrt_journal_watch_plugin *abrt_journal_core_plugin_new(GList *journal_filters,
+                                                               const char *dump_location,
+                                                               int throttle,
+                                                               int run_flags);
+
+/*
+ * Creates an abrt problem from the current journal message
+ */
+int abrt_journal_dump_core(abrt_journal_t *journal, const char *dump_location, int run_flags);
+
+/*
+ * Kernel oopses
+ * (journal-oops-plugin.c, run_flags are ABRT_OOPS_* flags from oops-utils.h)
+ */
+#define ABRT_JOURNAL_OOPS_DEFAULT_FILTER "SYSLOG_IDENTIFIER=kernel"
+#define ABRT_JOURNAL_KOOPS_ANALYZER "abrt-journal-koops"
+
+struct abrt_journal_watch_plugin *abrt_journal_oops_plugin_new(GList *journal_filters,
+                                                               const char *dump_location,
+                                                               int oops_utils_flags);
+
+/*
+ * Extracts oopses from the current and all following messages
+ */
+GList *abrt_journal_extract_kernel_oops(abrt_journal_t *journal);
+
+/*
+ * Xorg crashes
+ * (journal-xorg-plugin.c, run_flags are ABRT_XORG_* flags from xorg-utils.h)
+ */
+#define ABRT_JOURNAL_XORG_CONF "xorg.conf"
+#define ABRT_JOURNAL_XORG_DEFAULT_FILTERS "_COMM=gdm-x-session, _COMM=gnome-shell"
+
+/*
+ * Returns the list of JournalFilters from xorg.conf or the default filters.
+ * The list and its items are malloced.
+ */
+GList *abrt_journal_xorg_conf_journal_filters(void);
+
+struct abrt_journal_watch_plugin *abrt_journal_xorg_plugin_new(GList *journal_filters,
+                                                               const char *dump_location,
+                                                               int xorg_utils_flags);
+
+/*
+ * Extracts Xorg crashes from the current and all following messages
+ */
+GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal);
+
+void abrt_xorg_process_list_of_crashes(GList *crashes, const char *dump_location, int flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*_ABRT_JOURNAL_PLUGINS_H_*/
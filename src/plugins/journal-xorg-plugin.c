@@ -0,0 +1,222 @@
+/*
+ * Copyright (C) 2015  ABRT team
+ * Copyright (C) 2015  RedHat Inc
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ */
+#include "libabrt.h"
+#include "journal-plugins.h"
+#include "xorg-utils.h"
+
+/* Limit number of buffered lines */
+#define ABRT_JOURNAL_MAX_READ_LINES (1024 * 1024)
+
+/* Give systemd-journal one second to suck in all crash strings */
+#define ABRT_JOURNAL_XORG_COLLECT_MS 1000
+
+void abrt_xorg_process_list_of_crashes(GList *crashes, const char *dump_location, int flags)
+{
+    if (crashes == NULL)
+        return;
+
+    GList *list;
+    for (list = crashes; list != NULL; list = list->next)
+    {
+        xorg_crash_info_create_dump_dir(list->data, dump_location, (flags & ABRT_XORG_WORLD_READABLE));
+
+        if (flags & ABRT_XORG_PRINT_STDOUT)
+            xorg_crash_info_print_crash(list->data);
+
+        if (flags & ABRT_XORG_THROTTLE_CREATION)
+            if (abrt_xorg_signaled_sleep(1) > 0)
+                break;
+    }
+
+    return;
+}
+
+GList *abrt_journal_xorg_conf_journal_filters(void)
+{
+    g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    log_notice("Loading settings from '%s'", ABRT_JOURNAL_XORG_CONF);
+    abrt_load_abrt_plugin_conf_file(ABRT_JOURNAL_XORG_CONF, settings);
+    log_debug("Loaded '%s'", ABRT_JOURNAL_XORG_CONF);
+
+    const char *conf_journal_filters = g_hash_table_lookup(settings, "JournalFilters");
+    if (!conf_journal_filters) {
+        conf_journal_filters = ABRT_JOURNAL_XORG_DEFAULT_FILTERS;
+    }
+
+    return libreport_parse_delimited_list(conf_journal_filters, ",");
+}
+
+/*
+ * Calls get_next_line for every line and parses backtraces which follow
+ * XORG_SEARCH_STRING lines.
+ */
+static GList *extract_xorg_crashes(char *(*get_next_line)(void *), void *data, char *first_line)
+{
+    GList *crash_info_list = NULL;
+
+    for (char *line = first_line; line != NULL; line = get_next_line(data))
+    {
+        char *p = skip_pfx(line);
+        if (strcmp(p, XORG_SEARCH_STRING) == 0)
+        {
+            struct xorg_crash_info *crash_info = process_xorg_bt(get_next_line, data);
+            if (crash_info)
+                crash_info_list = g_list_append(crash_info_list, crash_info);
+            else
+                log_warning(_("Failed to parse Backtrace from journal"));
+        }
+
+        free(line);
+    }
+
+    log_warning("Found crashes: %d", g_list_length(crash_info_list));
+
+    return crash_info_list;
+}
+
+GList *abrt_journal_extract_xorg_crashes(abrt_journal_t *journal)
+{
+    char *line = abrt_journal_get_log_line(journal);
+    if (line == NULL)
+        error_msg_and_die(_("Cannot read journal data."));
+
+    return extract_xorg_crashes(&abrt_journal_get_next_log_line, journal, line);
+}
+
+/*
+ * The plug-in starts collecting messages when it sees XORG_SEARCH_STRING and
+ * extracts crashes from the collected messages once the watch is idle and the
+ * collection period is over. The journal is never moved by the plug-in, so it
+ * can share the journal with other plug-ins.
+ */
+struct xorg_plugin_data
+{
+    char *dump_location;
+    int xorg_utils_flags;
+
+    struct abrt_journal_watch_notify_strings notify_strings;
+
+    GQueue lines;
+    /* Monotonic time of the first collected line in microseconds, 0 if
+     * nothing has been collected */
+    gint64 collecting_since;
+};
+
+static char *xorg_plugin_pop_line(void *data)
+{
+    return g_queue_pop_head((GQueue *)data);
+}
+
+static void xorg_plugin_collect_line(abrt_journal_watch_t *watch, void *data)
+{
+    struct xorg_plugin_data *xorg_data = (struct xorg_plugin_data *)data;
+
+    if (g_queue_get_length(&xorg_data->lines) >= ABRT_JOURNAL_MAX_READ_LINES)
+        return;
+
+    char *line = abrt_journal_get_log_line(abrt_journal_watch_get_journal(watch));
+    if (line == NULL)
+        error_msg_and_die(_("Cannot read journal data."));
+
+    g_queue_push_tail(&xorg_data->lines, line);
+
+    if (xorg_data->collecting_since == 0)
+        xorg_data->collecting_since = g_get_monotonic_time();
+}
+
+static void xorg_plugin_callback(abrt_journal_watch_t *watch, void *data)
+{
+    struct xorg_plugin_data *xorg_data = (struct xorg_plugin_data *)data;
+
+    if (xorg_data->collecting_since != 0)
+        xorg_plugin_collect_line(watch, data);
+    else
+        abrt_journal_watch_notify_strings(watch, &xorg_data->notify_strings);
+}
+
+static bool xorg_plugin_pending_callback(void *data)
+{
+    return ((struct xorg_plugin_data *)data)->collecting_since != 0;
+}
+
+static void xorg_plugin_flush_callback(void *data)
+{
+    struct xorg_plugin_data *xorg_data = (struct xorg_plugin_data *)data;
+
+    if (xorg_data->collecting_since == 0)
+        return;
+
+    GList *crashes = extract_xorg_crashes(xorg_plugin_pop_line, &xorg_data->lines,
+                                          xorg_plugin_pop_line(&xorg_data->lines));
+    xorg_data->collecting_since = 0;
+
+    abrt_xorg_process_list_of_crashes(crashes, xorg_data->dump_location, xorg_data->xorg_utils_flags);
+    g_list_free_full(crashes, (GDestroyNotify)xorg_crash_info_free);
+}
+
+static int xorg_plugin_idle_callback(abrt_journal_watch_t *watch, void *data)
+{
+    struct xorg_plugin_data *xorg_data = (struct xorg_plugin_data *)data;
+
+    if (xorg_data->collecting_since == 0)
+        return -1;
+
+    const gint64 elapsed_ms = (g_get_monotonic_time() - xorg_data->collecting_since) / 1000;
+    if (elapsed_ms < ABRT_JOURNAL_XORG_COLLECT_MS)
+        return ABRT_JOURNAL_XORG_COLLECT_MS - elapsed_ms;
+
+    xorg_plugin_flush_callback(data);
+
+    if (g_abrt_xorg_sleep_woke_up_on_signal > 0)
+        abrt_journal_watch_stop(watch);
+
+    return -1;
+}
+
+static void xorg_plugin_data_free(struct xorg_plugin_data *xorg_data)
+{
+    if (xorg_data == NULL)
+        return;
+
+    g_list_free_full(xorg_data->lines.head, free);
+    abrt_journal_watch_notify_strings_destroy(&xorg_data->notify_strings);
+    g_list_free(xorg_data->notify_strings.strings);
+    free(xorg_data->dump_location);
+    free(xorg_data);
+}
+
+struct abrt_journal_watch_plugin *abrt_journal_xorg_plugin_new(GList *journal_filters,
+        const char *dump_location, int xorg_utils_flags)
+{
+    struct xorg_plugin_data *xorg_data = g_new0(struct xorg_plugin_data, 1);
+    xorg_data->dump_location = g_strdup(dump_location);
+    xorg_data->xorg_utils_flags = xorg_utils_flags;
+    xorg_data->notify_strings.decorated_cb = xorg_plugin_collect_line;
+    xorg_data->notify_strings.decorated_cb_data = xorg_data;
+    xorg_data->notify_strings.strings = g_list_prepend(NULL, (gpointer)XORG_SEARCH_STRING);
+    g_queue_init(&xorg_data->lines);
+
+    struct abrt_journal_watch_plugin *plugin = g_new0(struct abrt_journal_watch_plugin, 1);
+    plugin->name = "Xorg";
+    plugin->journal_filters = g_list_copy_deep(journal_filters, (GCopyFunc)g_strdup, NULL);
+    plugin->callback = xorg_plugin_callback;
+    plugin->idle_callback = xorg_plugin_idle_callback;
+    plugin->pending_callback = xorg_plugin_pending_callback;
+    plugin->flush_callback = xorg_plugin_flush_callback;
+    plugin->data = xorg_data;
+    plugin->free_data = (GDestroyNotify)xorg_plugin_data_free;
+
+    return plugin;
+}
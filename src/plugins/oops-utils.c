@@ -22,7 +22,96 @@
 #include "oops-utils.h"
 #include "libabrt.h"
 
-int g_abrt_oops_sleep_woke_up_on_signal;
+/*
+ * A storm of the same oops must not end up in a storm of problem directories.
+ * Oopses are grouped by their hash, every group is saved in a single problem
+ * directory whose FILENAME_COUNT is the number of oopses in the group.
+ */
+struct oops_group
+{
+    /* Borrowed from the list of oopses */
+    char *oops;
+    unsigned count;
+};
+
+/* The problem directory created for an oops hash */
+struct oops_dump_record
+{
+    char *path;
+    time_t dumped;
+};
+
+/* Prune the records of expired hashes when there are more than this */
+#define OOPS_DUMP_RECORDS_PRUNE_SIZE 256
+
+/* oops hash -> struct oops_dump_record, lives as long as the process, so
+ * log watchers recognize storms spread over more lists of oopses */
+static GHashTable *s_dumped_oopses;
+
+static void oops_dump_record_free(struct oops_dump_record *record)
+{
+    free(record->path);
+    free(record);
+}
+
+static void oops_dump_records_prune(time_t now)
+{
+    if (g_hash_table_size(s_dumped_oopses) < OOPS_DUMP_RECORDS_PRUNE_SIZE)
+        return;
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, s_dumped_oopses);
+    while (g_hash_table_iter_next(&iter, NULL, &value))
+    {
+        const struct oops_dump_record *record = (const struct oops_dump_record *)value;
+        if (now - record->dumped >= ABRT_OOPS_SAME_HASH_INTERVAL)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
+/*
+ * Returns the oops hash or, if the oops cannot be hashed, the whole oops, so
+ * at least exactly the same oopses are grouped.
+ */
+static char *oops_group_key(const char *oops)
+{
+    /* The first line is the kernel version */
+    const char *koops_bt = strchr(oops, '\n');
+    koops_bt = koops_bt ? koops_bt + 1 : oops;
+
+    char *hash = abrt_koops_hash_str(koops_bt);
+    return hash ? hash : g_strdup(koops_bt);
+}
+
+/*
+ * Adds the occurrences to the problem directory created by an earlier list of
+ * oopses. Returns false if the directory no longer exists, e.g. because
+ * the user deleted it.
+ */
+static bool oops_dump_dir_add_occurrences(const char *path, unsigned occurrences, time_t now)
+{
+    struct dump_dir *dd = dd_opendir(path, DD_FAIL_QUIETLY_ENOENT);
+    if (dd == NULL)
+        return false;
+
+    /* abrtd has not set the count yet if the directory has not been processed */
+    g_autofree char *count_str = dd_load_text_ext(dd, FILENAME_COUNT,
+            DD_LOAD_TEXT_RETURN_NULL_ON_FAILURE | DD_FAIL_QUIETLY_ENOENT);
+    unsigned long count = count_str ? strtoul(count_str, NULL, 10) : 0;
+    if (count == 0)
+        count = 1;
+
+    g_autofree char *new_count_str = g_strdup_printf("%lu", count + occurrences);
+    dd_save_text(dd, FILENAME_COUNT, new_count_str);
+
+    g_autofree char *last_ocr = g_strdup_printf("%lu", (long)now);
+    dd_save_text(dd, FILENAME_LAST_OCCURRENCE, last_ocr);
+
+    dd_close(dd);
+
+    return true;
+}
 
 int abrt_oops_process_list(GList *oops_list, const char *dump_location, const char *analyzer, int flags)
 {
@@ -64,46 +153,91 @@ int abrt_oops_process_list(GList *oops_list, const char *dump_location, const ch
         }
     }
 
-    /* If we are run by a log watcher, this delays log rescan
-     * (because log watcher waits to us to terminate)
-     * and possibly prevents dreaded "abrt storm".
-     */
-    int unreported_cnt = oops_cnt - ABRT_OOPS_MAX_DUMPED_COUNT;
-    if (g_abrt_oops_sleep_woke_up_on_signal <= 0 &&
-            (unreported_cnt > 0 && (flags & ABRT_OOPS_THROTTLE_CREATION)))
-    {
-        /* Quadratic throttle time growth, but careful to not overflow in "n*n" */
-        int n = unreported_cnt > 30 ? 30 : unreported_cnt;
-        n = n * n;
-        if (n > 9)
-            log_warning(_("Sleeping for %d seconds"), n);
-        abrt_oops_signaled_sleep(n); /* max 15 mins */
-    }
-
     return errors;
 }
 
 /* returns number of errors */
 unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location, const char *analyzer, int flags)
 {
-    const int oops_cnt = g_list_length(oops_list);
-    unsigned countdown = ABRT_OOPS_MAX_DUMPED_COUNT; /* do not report hundreds of oopses */
+    /* Group identical oopses, keep the order of their first occurrences */
+    g_autoptr(GHashTable) groups = g_hash_table_new_full(g_str_hash, g_str_equal, free, free);
+    g_autoptr(GPtrArray) keys = g_ptr_array_new();
+    for (GList *oops = oops_list; oops != NULL; oops = oops->next)
+    {
+        char *key = oops_group_key((char *)oops->data);
+        struct oops_group *group = g_hash_table_lookup(groups, key);
+        if (group != NULL)
+        {
+            ++group->count;
+            free(key);
+            continue;
+        }
+
+        group = g_new(struct oops_group, 1);
+        group->oops = (char *)oops->data;
+        group->count = 1;
+        g_hash_table_insert(groups, key, group);
+        g_ptr_array_add(keys, key);
+    }
+
+    log_notice("Found %u distinct oopses in %u oopses", keys->len, g_list_length(oops_list));
 
-    log_notice("Saving %u oopses as problem dirs", oops_cnt >= countdown ? countdown : oops_cnt);
+    const time_t t = time(NULL);
+
+    if ((flags & ABRT_OOPS_THROTTLE_CREATION))
+    {
+        if (s_dumped_oopses == NULL)
+            s_dumped_oopses = g_hash_table_new_full(g_str_hash, g_str_equal, free,
+                                                    (GDestroyNotify)oops_dump_record_free);
+        else
+            oops_dump_records_prune(t);
+    }
 
-    g_autofree char *cmdline_str = libreport_xmalloc_fopen_fgetline_fclose("/proc/cmdline");
-    g_autofree char *fips_enabled = libreport_xmalloc_fopen_fgetline_fclose("/proc/sys/crypto/fips_enabled");
-    g_autofree char *proc_modules = libreport_xmalloc_open_read_close("/proc/modules", /*maxsize:*/ NULL);
-    g_autofree char *suspend_stats = libreport_xmalloc_open_read_close("/sys/kernel/debug/suspend_stats", /*maxsize:*/ NULL);
+    g_autofree char *cmdline_str = NULL;
+    g_autofree char *fips_enabled = NULL;
+    g_autofree char *proc_modules = NULL;
+    g_autofree char *suspend_stats = NULL;
+    bool system_info_loaded = false;
 
-    time_t t = time(NULL);
     const char *iso_date = libreport_iso_date_string(&t);
 
     pid_t my_pid = getpid();
-    unsigned idx = 0;
+    unsigned countdown = ABRT_OOPS_MAX_DUMPED_COUNT; /* do not report hundreds of oopses */
     unsigned errors = 0;
-    for (GList *oops = oops_list; oops != NULL; oops = oops->next, ++idx)
+    for (unsigned idx = 0; idx < keys->len; ++idx)
     {
+        const char *key = (const char *)g_ptr_array_index(keys, idx);
+        struct oops_group *group = g_hash_table_lookup(groups, key);
+
+        struct oops_dump_record *record = NULL;
+        if ((flags & ABRT_OOPS_THROTTLE_CREATION))
+        {
+            record = g_hash_table_lookup(s_dumped_oopses, key);
+            if (record != NULL
+                && t - record->dumped < ABRT_OOPS_SAME_HASH_INTERVAL
+                && oops_dump_dir_add_occurrences(record->path, group->count, t))
+            {
+                log_notice("Added %u occurrences to '%s'", group->count, record->path);
+                continue;
+            }
+        }
+
+        if (countdown == 0)
+        {
+            log_notice("Not saving %u oopses, too many problem dirs have been created", group->count);
+            continue;
+        }
+        --countdown;
+
+        if (!system_info_loaded)
+        {
+            cmdline_str = libreport_xmalloc_fopen_fgetline_fclose("/proc/cmdline");
+            fips_enabled = libreport_xmalloc_fopen_fgetline_fclose("/proc/sys/crypto/fips_enabled");
+            proc_modules = libreport_xmalloc_open_read_close("/proc/modules", /*maxsize:*/ NULL);
+            suspend_stats = libreport_xmalloc_open_read_close("/sys/kernel/debug/suspend_stats", /*maxsize:*/ NULL);
+            system_info_loaded = true;
+        }
+
         char base[sizeof("oops-YYYY-MM-DD-hh:mm:ss-%lu-%lu") + 2 * sizeof(long)*3];
         sprintf(base, "oops-%s-%lu-%lu", iso_date, (long)my_pid, (long)idx);
         g_autofree char *path = g_build_filename(dump_location ? dump_location : "", base, NULL);
@@ -117,7 +251,9 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
         if (dd)
         {
             dd_create_basic_files(dd, /*no uid*/(uid_t)-1L, NULL);
-            abrt_oops_save_data_in_dump_dir(dd, (char *)oops->data, proc_modules);
+            /* abrt_oops_save_data_in_dump_dir() modifies the oops */
+            g_autofree char *oops = g_strdup(group->oops);
+            abrt_oops_save_data_in_dump_dir(dd, oops, proc_modules);
             dd_save_text(dd, FILENAME_ABRT_VERSION, VERSION);
             dd_save_text(dd, FILENAME_ANALYZER, "abrt-oops");
             dd_save_text(dd, FILENAME_TYPE, "Kerneloops");
@@ -129,20 +265,45 @@ unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location,
                 dd_save_text(dd, "fips_enabled", fips_enabled);
             if (suspend_stats)
                 dd_save_text(dd, "suspend_stats", suspend_stats);
+            if (group->count > 1)
+            {
+                /* abrtd keeps the count of a new problem if it is set */
+                g_autofree char *count_str = g_strdup_printf("%u", group->count);
+                dd_save_text(dd, FILENAME_COUNT, count_str);
+                g_autofree char *last_ocr = g_strdup_printf("%lu", (long)t);
+                dd_save_text(dd, FILENAME_LAST_OCCURRENCE, last_ocr);
+            }
             if ((flags & ABRT_OOPS_WORLD_READABLE))
                 dd_set_no_owner(dd);
             dd_close(dd);
-            abrt_notify_new_path(path);
+
+            if ((flags & ABRT_OOPS_THROTTLE_CREATION))
+            {
+                /* abrtd deletes the new directory if it is a duplicate of an
+                 * older problem, follow the occurrences there */
+                g_autofree char *message = NULL;
+                if (abrt_notify_new_path_with_response(path, &message) == 303
+                    && message != NULL && message[0] == '/')
+                {
+                    log_notice("'%s' is a duplicate of '%s'", path, message);
+                    free(path);
+                    path = g_steal_pointer(&message);
+                }
+
+                if (record == NULL)
+                {
+                    record = g_new0(struct oops_dump_record, 1);
+                    g_hash_table_insert(s_dumped_oopses, g_strdup(key), record);
+                }
+                free(record->path);
+                record->path = g_steal_pointer(&path);
+                record->dumped = t;
+            }
+            else
+                abrt_notify_new_path(path);
         }
         else
             errors++;
-
-        if (--countdown == 0)
-            break;
-
-        if (dd && (flags & ABRT_OOPS_THROTTLE_CREATION))
-            if (abrt_oops_signaled_sleep(1) > 0)
-                break;
     }
 
     return errors;
@@ -276,21 +437,6 @@ void abrt_oops_save_data_in_dump_dir(struct dump_dir *dd, char *oops, const char
         dd_save_text(dd, FILENAME_REASON, second_line);
 }
 
-int abrt_oops_signaled_sleep(int seconds)
-{
-    sigset_t set;
-    sigemptyset(&set);
-    sigaddset(&set, SIGTERM);
-    sigaddset(&set, SIGINT);
-    sigaddset(&set, SIGHUP);
-
-    struct timespec timeout;
-    timeout.tv_sec = seconds;
-    timeout.tv_nsec = 0;
-
-    return g_abrt_oops_sleep_woke_up_on_signal = sigtimedwait(&set, NULL, &timeout);
-}
-
 char *abrt_oops_string_filter_regex(void)
 {
     g_autoptr(GHashTable) settings = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
@@ -17,12 +17,17 @@
 
 #include "libabrt.h"
 
-/* How many problem dirs to create at most?
- * Also causes cooldown sleep with -t if exceeded -
- * useful when called from a log watcher.
+/* How many problem dirs to create at most from one list of oopses?
+ * Identical oopses are counted as one.
  */
 #define ABRT_OOPS_MAX_DUMPED_COUNT  5
 
+/* With ABRT_OOPS_THROTTLE_CREATION, an oops with the same hash as an oops
+ * saved less than this many seconds ago does not create a new problem dir
+ * but it is added to the occurrences of the existing one.
+ */
+#define ABRT_OOPS_SAME_HASH_INTERVAL (60 * 60)
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -33,12 +38,9 @@ enum {
     ABRT_OOPS_PRINT_STDOUT      = 1 << 2,
 };
 
-extern int g_abrt_oops_sleep_woke_up_on_signal;
-
 int abrt_oops_process_list(GList *oops_list, const char *dump_location, const char *analyzer, int flags);
 unsigned abrt_oops_create_dump_dirs(GList *oops_list, const char *dump_location, const char *analyzer, int flags);
 void abrt_oops_save_data_in_dump_dir(struct dump_dir *dd, char *oops, const char *proc_modules);
-int abrt_oops_signaled_sleep(int seconds);
 char *abrt_oops_string_filter_regex(void);
 
 #ifdef __cplusplus
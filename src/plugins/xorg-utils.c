@@ -137,10 +137,10 @@ void xorg_crash_info_create_dump_dir(struct xorg_crash_info *crash_info, const c
     abrt_notify_new_path(path);
 }
 
-char *xorg_get_next_line_from_fd(void *fd)
+char *xorg_get_next_line_from_reader(void *reader)
 {
-    FILE *f = (FILE *)fd;
-    return libreport_xmalloc_fgetline(f);
+    const char *line = abrt_line_reader_next_str((struct abrt_line_reader *)reader, NULL);
+    return line ? g_strdup(line) : NULL;
 }
 
 
@@ -75,13 +75,13 @@ char *skip_pfx(char *str);
 void xorg_crash_info_print_crash(struct xorg_crash_info *crash_info);
 
 /*
- * Get next line from given stream (FILE *)
+ * Get next line from given line reader (struct abrt_line_reader *)
  * Use as wrapper for reading function
  *
- * @param fd open FILE * as void *
- * @returns malloced and unlimited line without railing \n
+ * @param reader line reader as void *
+ * @returns malloced line without trailing \n
  */
-char *xorg_get_next_line_from_fd(void *fd);
+char *xorg_get_next_line_from_reader(void *reader);
 
 /*
  * Process Xorg Backtrace
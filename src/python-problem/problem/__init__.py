@@ -39,6 +39,13 @@ PREFETCH_FIELDS = [
     'dmesg',
 ]
 
+# items loaded for all problems at once by list()
+LIST_FIELDS = [
+    'type', 'reason', 'component', 'executable', 'time', 'count',
+    'uid', 'username', 'reported_to', 'not-reportable', 'cmdline',
+    'package',
+]
+
 PROBLEM_TYPES = {
     'JAVA': JAVA,
     'SELINUX': SELINUX,
@@ -67,6 +74,8 @@ class Problem(object):
         self._proxy = None
         self._probdir = None
         self._id = None
+        # items loaded by list(), served instead of fetching them once
+        self._prefetched = dict()
 
         self.type = typ
         if analyzer is None:
@@ -110,7 +119,10 @@ class Problem(object):
 
         # try to fetch the item
         if self._persisted:
-            val = self._proxy.get_item(self._probdir, attr)
+            if attr in self._prefetched:
+                val = self._prefetched.pop(attr)
+            else:
+                val = self._proxy.get_item(self._probdir, attr)
             self._data[attr] = val
 
         if val is None:
@@ -340,7 +352,8 @@ class Unknown(Problem):
         super(Unknown, self).__init__('libreport', reason)
 
 
-def list(auth=False, __proxy=proxies.get_proxy()):
+def list(auth=False, __proxy=proxies.get_proxy(), components=None,
+         executables=None, since=None, not_reported=False):
     ''' Return the list of the problems
 
     Use ``auth=True`` if authentication should be attempted.
@@ -348,12 +361,28 @@ def list(auth=False, __proxy=proxies.get_proxy()):
     If authentication via polkit fails, function behaves
     as if ``auth=False`` was specified (only users problems are
     returned).
+
+    ``components``, ``executables``, ``since`` (UNIX time stamp of the
+    last occurrence) and ``not_reported`` let the service leave out
+    problems that do not match. Proxies which cannot filter problems
+    return all of them, so callers have to filter the list too.
     '''
     fun = __proxy.list
     if auth:
         fun = __proxy.list_all
 
-    return [tools.problemify(prob, __proxy) for prob in fun()]
+    options = tools.list_options(components, executables, since,
+                                 not_reported)
+
+    prefetched = __proxy.get_items(None, LIST_FIELDS, auth=auth,
+                                   options=options)
+    if prefetched is None:
+        # the proxy cannot load many problems at once, items are fetched
+        # when they are accessed
+        return [tools.problemify(prob, __proxy) for prob in fun()]
+
+    return [tools.problemify(prob, __proxy, data)
+            for prob, data in prefetched.items()]
 
 
 def get(identifier, auth=False, __proxy=proxies.get_proxy()):
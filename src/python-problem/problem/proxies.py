@@ -1,10 +1,14 @@
 import os
 import logging
+import collections
 import report
 
 import problem
 import problem.config
 
+# seconds the user has to answer the polkit prompt
+AUTHORIZATION_TIMEOUT = 60
+
 
 class DBusProxy(object):
     __instance = None
@@ -12,6 +16,8 @@ class DBusProxy(object):
     def __init__(self, dbus):
         self._proxy = None
         self._iface = None
+        self._p2_bus = None
+        self._polkit_agent = None
         self.dbus = dbus
         self.connected = False
         self.connect()
@@ -72,6 +78,121 @@ class DBusProxy(object):
 
         return str(val[name])
 
+    def get_items(self, dump_dirs, names, auth=False, options=None):
+        '''
+        Return values of ``names`` for all ``dump_dirs`` at once
+
+        Uses a single GetProblemsInfo call of the Problems2 interface
+        instead of one GetInfo call per item. ``options`` are GetProblems
+        options filtering the problems on the service side. If
+        ``dump_dirs`` is None, all problems visible to the caller are
+        returned, so no separate call listing the problems is needed.
+
+        Returns a dictionary indexed by dump directories in the order
+        returned by the service or None if the call failed. Directories
+        which could not be loaded are left out.
+        '''
+        options = dict(options or {})
+        # 0x1 - include problems of other users
+        options['flags'] = self.dbus.Int32(0x1 if auth else 0x0)
+
+        try:
+            bus = self._problems2_bus()
+            if auth and not self._authorize_session(bus):
+                # the legacy interface asks polkit by itself
+                return None
+
+            p2 = bus.get_object(
+                'org.freedesktop.problems', '/org/freedesktop/Problems2')
+            iface = self.dbus.Interface(p2, 'org.freedesktop.Problems2')
+
+            info = iface.GetProblemsInfo([], names + ['Directory'],
+                                         options)
+        except self.dbus.exceptions.DBusException as e:
+            logging.debug('Unable to get problems info: {0}'.format(e))
+            return None
+
+        wanted = None if dump_dirs is None else set(dump_dirs)
+        result = collections.OrderedDict()
+        for elements in info.values():
+            dump_dir = str(elements.get('Directory', ''))
+            if not dump_dir or (wanted is not None and dump_dir not in wanted):
+                continue
+
+            result[dump_dir] = dict((str(name), str(value))
+                                    for name, value in elements.items()
+                                    if name != 'Directory')
+
+        return result
+
+    def _problems2_bus(self):
+        '''
+        Return the connection used for the Problems2 interface
+
+        Problems2 sessions belong to connections and the result of their
+        authorization arrives as a signal, hence the connection is private
+        and has a main loop.
+        '''
+        if self._p2_bus is None:
+            from dbus.mainloop.glib import DBusGMainLoop
+            self._p2_bus = self.dbus.SystemBus(private=True,
+                                               mainloop=DBusGMainLoop())
+
+        return self._p2_bus
+
+    def _authorize_session(self, bus):
+        '''
+        Authorize the Problems2 session of ``bus`` to see problems of all users
+
+        Without it, the service silently leaves out problems of other users.
+        Returns True if the session is authorized.
+        '''
+        from gi.repository import GLib
+
+        p2 = self.dbus.Interface(
+            bus.get_object('org.freedesktop.problems',
+                           '/org/freedesktop/Problems2'),
+            'org.freedesktop.Problems2')
+        session_proxy = bus.get_object('org.freedesktop.problems',
+                                       p2.GetSession())
+        properties = self.dbus.Interface(session_proxy,
+                                         'org.freedesktop.DBus.Properties')
+        if properties.Get('org.freedesktop.Problems2.Session', 'IsAuthorized'):
+            return True
+
+        self._register_polkit_agent()
+
+        loop = GLib.MainLoop()
+        status = []
+
+        def authorization_changed(value):
+            # 1 - the request has been accepted, the result follows
+            if value != 1:
+                status.append(value)
+                loop.quit()
+
+        def timed_out():
+            logging.debug('Authorization of Problems2 session timed out')
+            loop.quit()
+            return False
+
+        match = session_proxy.connect_to_signal('AuthorizationChanged',
+                                                authorization_changed)
+        try:
+            session = self.dbus.Interface(session_proxy,
+                                          'org.freedesktop.Problems2.Session')
+            result = session.Authorize({})
+            if result > 0 and not status:
+                timeout = GLib.timeout_add_seconds(AUTHORIZATION_TIMEOUT,
+                                                   timed_out)
+                loop.run()
+                if status:
+                    GLib.source_remove(timeout)
+        finally:
+            match.remove()
+
+        return result == 0 or status[-1:] == [0]
+
     def set_item(self, dump_dir, name, value):
         return self._dbus_call('SetElement', dump_dir, name, str(value))
 
@@ -90,8 +211,8 @@ class DBusProxy(object):
     def list(self):
         return [str(prob) for prob in self._dbus_call('GetProblems')]
 
-    def list_all(self):
-        if problem.config.HAVE_POLKIT:
+    def _register_polkit_agent(self):
+        if problem.config.HAVE_POLKIT and self._polkit_agent is None:
             import gi
             gi.require_version('Polkit', '1.0')
             gi.require_version('PolkitAgent', '1.0')
@@ -104,6 +225,10 @@ class DBusProxy(object):
             agent.register(PolkitAgent.RegisterFlags.RUN_IN_THREAD, subject,
                            '/org/freedesktop/PolicyKit1/AuthenticationAgent',
                            None)
+            self._polkit_agent = agent
+
+    def list_all(self):
+        self._register_polkit_agent()
         return [str(prob) for prob in self._dbus_call('GetAllProblems')]
 
 
@@ -133,6 +258,11 @@ class SocketProxy(object):
     def get_item(self, *args):
         raise NotImplementedError
 
+    def get_items(self, *args, **kwargs):
+        # Problems can only be created via the socket, callers fall back to
+        # get_item()
+        return None
+
     def set_item(self, *args):
         raise NotImplementedError
 
@@ -191,6 +321,10 @@ class FsProxy(object):
         ddir.close()
         return val
 
+    def get_items(self, dump_dirs, names, auth=False, options=None):
+        # Nothing to save, items are read directly from the disk
+        return None
+
     def set_item(self, dump_dir, name, value):
         ddir = self._open_ddir(dump_dir)
         ddir.save_text(name, str(value))
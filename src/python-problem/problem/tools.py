@@ -1,12 +1,16 @@
 import problem
 
 
-def problemify(probdir, proxy):
+def problemify(probdir, proxy, data=None):
     by_typ = dict(zip(problem.PROBLEM_TYPES.values(),
                       problem.PROBLEM_TYPES.keys()))
 
-    typ = proxy.get_item(probdir, 'type')
-    reason = proxy.get_item(probdir, 'reason')
+    if data is not None:
+        typ = data.get('type')
+        reason = data.get('reason')
+    else:
+        typ = proxy.get_item(probdir, 'type')
+        reason = proxy.get_item(probdir, 'reason')
 
     if typ not in by_typ:
         class_name = 'Unknown'
@@ -18,4 +22,36 @@ def problemify(probdir, proxy):
     prob._persisted = True
     prob._proxy = proxy
 
+    if data is not None:
+        # items missing in the prefetched data do not exist
+        for name in problem.LIST_FIELDS:
+            prob._prefetched[name] = data.get(name)
+
     return prob
+
+
+def list_options(components=None, executables=None, since=None,
+                 not_reported=False):
+    '''
+    Return GetProblems options filtering problems on the service side
+    '''
+    options = dict()
+    if not (components or executables or since is not None or not_reported):
+        return options
+
+    try:
+        import dbus
+    except ImportError:
+        # only DBusProxy filters problems
+        return options
+
+    if components:
+        options['components'] = dbus.Array(components, signature='s')
+    if executables:
+        options['executables'] = dbus.Array(executables, signature='s')
+    if since is not None:
+        options['since'] = dbus.Int64(int(float(since)))
+    if not_reported:
+        options['not-reported'] = dbus.Boolean(True)
+
+    return options
@@ -10,6 +10,7 @@ os.environ["PATH"] = "{0}:{1}".format(os.path.abspath(".."), os.environ["PATH"])
 import unittest
 
 from base import ProblematicTestCase
+from util import FakeProxy
 
 import problem
 
@@ -32,6 +33,55 @@ class ListTestCase(ProblematicTestCase):
 
         prob.delete()
 
+    def test_list_prefetched(self):
+        prob = self.create_problem()
+        prob.add_current_process_data()
+        ident = prob.save()
+
+        def fail(*args, **kwargs):
+            raise AssertionError('prefetched problems must not be listed or read again')
+
+        proxy = FakeProxy()
+        proxy.list = fail
+        proxy.list_all = fail
+        proxy.get_item = fail
+
+        listed = [p for p in problem.list(False, proxy) if p._probdir == ident]
+        assert len(listed) == 1
+        assert listed[0].reason == prob.reason
+        assert listed[0].executable == prob.executable
+        assert not hasattr(listed[0], 'component')
+
+        prob.delete()
+
+    def test_list_fallback(self):
+        prob = self.create_problem()
+        prob.add_current_process_data()
+        ident = prob.save()
+
+        proxy = FakeProxy()
+        proxy.get_items = lambda *args, **kwargs: None
+
+        listed = [p for p in problem.list(False, proxy) if p._probdir == ident]
+        assert len(listed) == 1
+        assert listed[0].executable == prob.executable
+
+        prob.delete()
+
+    def test_socket_proxy_get_items(self):
+        assert problem.proxies.SocketProxy().get_items(None, ['type']) is None
+
+    def test_refetch_persisted(self):
+        prob = self.create_problem()
+        prob.add_current_process_data()
+        ident = prob.save()
+
+        prob2 = problem.tools.problemify(ident, self.proxy)
+        prob2._data['executable'] = 'stale'
+        assert prob2.executable == prob.executable
+
+        prob.delete()
+
 if __name__ == '__main__':
     logging.basicConfig(level=logging.DEBUG)
     unittest.main()
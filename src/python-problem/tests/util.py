@@ -14,6 +14,16 @@ class FakeProxy(object):
         except KeyError:
             return None
 
+    def get_items(self, dump_dirs, names, auth=False, options=None):
+        if dump_dirs is None:
+            dump_dirs = self.data.keys()
+
+        return dict((dump_dir, dict((name, self.data[dump_dir][name])
+                                    for name in names
+                                    if name in self.data[dump_dir]))
+                    for dump_dir in dump_dirs
+                    if dump_dir in self.data)
+
     def set_item(self, dump_dir, name, value):
         self.data[dump_dir][name] = value
 
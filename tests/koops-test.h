@@ -49,3 +49,22 @@ static inline char *fread_full(const char *filenamep)
 
         return koops_bt;
 }
+
+/* Reads the oopses from the output of abrt-dump-oops -o saved in a .right file */
+static inline GList *fread_expected_oopses(const char *filenamep)
+{
+        g_autofree char *expected = fread_full(filenamep);
+        GList *oops_list = NULL;
+
+        const char *oops = strstr(expected, "\nVersion: ");
+        while (oops)
+        {
+                oops += strlen("\nVersion: ");
+                const char *next = strstr(oops, "\nVersion: ");
+                oops_list = g_list_append(oops_list,
+                        next ? g_strndup(oops, next - oops) : g_strdup(oops));
+                oops = next;
+        }
+
+        return oops_list;
+}
@@ -0,0 +1,62 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import time
+import dbus
+
+import abrt_p2_testing
+from abrt_p2_testing import (create_problem, Problems2Entry, BUS_NAME)
+
+
+class TestFindProblemByElement(abrt_p2_testing.TestCase):
+    """FindProblemByElementInTimeRange of the old interface answers from an
+    index which must follow the modifications done via Problems2.
+    """
+
+    def setUp(self):
+        self.p2_entry_path = create_problem(self,
+                                            self.root_p2,
+                                            bus=self.root_bus)
+        self.p2e = Problems2Entry(self.root_bus, self.p2_entry_path)
+        self.problem_dir = self.p2e.getproperty("ID")
+
+        problems_proxy = self.root_bus.get_object(BUS_NAME,
+                                                  '/org/freedesktop/problems')
+        self.problems = dbus.Interface(
+                                problems_proxy,
+                                dbus_interface='org.freedesktop.problems')
+
+    def tearDown(self):
+        if self.p2_entry_path is not None:
+            self.root_p2.DeleteProblems([self.p2_entry_path])
+
+    def find(self, element, value):
+        return self.problems.FindProblemByElementInTimeRange(
+                                element, value, 0, int(time.time()) + 1, True)
+
+    def test_save_and_delete_elements(self):
+        # The first query builds the index
+        self.assertNotIn(self.problem_dir, self.find("package", "p2-foo-1"))
+
+        self.p2e.SaveElements({"package": "p2-foo-1"}, 0)
+        self.assertIn(self.problem_dir, self.find("package", "p2-foo-1"))
+
+        self.p2e.SaveElements({"package": "p2-foo-2"}, 0)
+        self.assertNotIn(self.problem_dir, self.find("package", "p2-foo-1"))
+        self.assertIn(self.problem_dir, self.find("package", "p2-foo-2"))
+
+        self.p2e.DeleteElements(["package"])
+        self.assertNotIn(self.problem_dir, self.find("package", "p2-foo-2"))
+
+    def test_delete_problems(self):
+        self.p2e.SaveElements({"package": "p2-bar-1"}, 0)
+        self.assertIn(self.problem_dir, self.find("package", "p2-bar-1"))
+
+        self.root_p2.DeleteProblems([self.p2_entry_path])
+        self.p2_entry_path = None
+
+        self.assertNotIn(self.problem_dir, self.find("package", "p2-bar-1"))
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestFindProblemByElement)
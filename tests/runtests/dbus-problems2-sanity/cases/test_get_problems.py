@@ -1,10 +1,12 @@
 #!/usr/bin/python3
 # vim: set makeprg=python3-flake8\ %
 
+import os
 import time
 
 import abrt_p2_testing
-from abrt_p2_testing import (wait_for_task_status)
+from abrt_p2_testing import (create_problem, wait_for_task_status,
+                             Problems2Entry)
 
 
 class TestGetProblems(abrt_p2_testing.TestCase):
@@ -61,6 +63,35 @@ class TestGetProblems(abrt_p2_testing.TestCase):
         new_problems = self.p2.GetProblems(0x1 | 0x2, dict())
         self.assertEquals(0, len(new_problems))
 
+    def test_get_locked_problem(self):
+        p2e_path = create_problem(self, self.p2)
+        p2e = Problems2Entry(self.bus, p2e_path)
+        reason = p2e.getproperty("Reason")
+
+        # libreport locks problem directories by a symbolic link to the PID
+        # of the owner of the lock
+        lock_path = os.path.join(p2e.getproperty("ID"), ".lock")
+        euid = os.geteuid()
+        os.seteuid(0)
+        try:
+            os.symlink(str(os.getpid()), lock_path)
+        finally:
+            os.seteuid(euid)
+
+        try:
+            problems = self.p2.GetProblems(0, dict())
+            self.assertIn(p2e_path, problems)
+
+            self.assertEqual(reason, p2e.getproperty("Reason"))
+        finally:
+            os.seteuid(0)
+            try:
+                os.unlink(lock_path)
+            finally:
+                os.seteuid(euid)
+
+            self.p2.DeleteProblems([p2e_path])
+
 
 if __name__ == "__main__":
     abrt_p2_testing.main(TestGetProblems)
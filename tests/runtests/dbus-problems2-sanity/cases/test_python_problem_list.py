@@ -0,0 +1,48 @@
+#!/usr/bin/python3
+# vim: set makeprg=python3-flake8\ %
+
+import dbus
+import problem
+import problem.proxies
+
+import abrt_p2_testing
+from abrt_p2_testing import (create_problem,
+                             start_polkit_agent,
+                             Problems2Entry)
+
+
+class TestPythonProblemList(abrt_p2_testing.TestCase):
+    """problem.list(auth=True) reads the problems through the Problems2
+    interface, which leaves out problems of other users unless the session
+    of the caller's connection is authorized.
+    """
+
+    def setUp(self):
+        self.p2_entry_root_path = create_problem(self,
+                                                 self.root_p2,
+                                                 bus=self.root_bus,
+                                                 wait=True)
+        p2e = Problems2Entry(self.root_bus, self.p2_entry_root_path)
+        self.problem_dir = str(p2e.getproperty("ID"))
+
+        self.proxy = problem.proxies.DBusProxy(dbus)
+        # The test agent answers instead of a text prompt
+        self.proxy._register_polkit_agent = lambda: None
+
+    def tearDown(self):
+        self.root_p2.DeleteProblems([self.p2_entry_root_path])
+
+    def listed(self, auth):
+        return [p._probdir for p in problem.list(auth, self.proxy)]
+
+    def test_list_foreign_problems(self):
+        self.assertNotIn(self.problem_dir, self.listed(False))
+
+        bus_name = self.proxy._problems2_bus().get_unique_name()
+        with start_polkit_agent(self.root_bus, bus_name) as pk_agent:
+            pk_agent.set_replies([True])
+            self.assertIn(self.problem_dir, self.listed(True))
+
+
+if __name__ == "__main__":
+    abrt_p2_testing.main(TestPythonProblemList)
@@ -0,0 +1,117 @@
+#!/bin/bash
+# vim: dict=/usr/share/beakerlib/dictionary.vim cpt=.,w,b,u,t,i,k
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   runtest.sh of oops-storm
+#   Description: a storm of the same kernel oops ends up in a single problem directory with the right count
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+#
+#   Copyright (c) 2026 Red Hat, Inc. All rights reserved.
+#
+#   This program is free software: you can redistribute it and/or
+#   modify it under the terms of the GNU General Public License as
+#   published by the Free Software Foundation, either version 3 of
+#   the License, or (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be
+#   useful, but WITHOUT ANY WARRANTY; without even the implied
+#   warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+#   PURPOSE.  See the GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program. If not, see http://www.gnu.org/licenses/.
+#
+# ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+. /usr/share/beakerlib/beakerlib.sh
+. ../aux/lib.sh
+
+TEST="oops-storm"
+PACKAGE="abrt"
+EXAMPLES_PATH="../../examples"
+
+function assert_single_oops_dir
+{
+    rlAssertEquals "A single problem directory" "_$(ls -d $ABRT_CONF_DUMP_LOCATION/oops* | wc -l)" "_1"
+    get_crash_path
+    rlAssertEquals "The problem directory counts all oopses" "_$(cat $crash_PATH/count)" "_$1"
+}
+
+rlJournalStart
+    rlPhaseStartSetup
+        load_abrt_conf
+        LANG=""
+        export LANG
+        check_prior_crashes
+
+        TmpDir=$(mktemp -d)
+        installed_kernel="$( rpm -q kernel | tail -n1 )"
+        sed "s/3.0.0-1.fc16.i686/$installed_kernel/" \
+            $EXAMPLES_PATH/oops5.test > \
+            $TmpDir/oops5.test
+
+        for i in $(seq 20); do
+            cat $TmpDir/oops5.test
+        done > $TmpDir/storm.test
+
+        for i in $(seq 5); do
+            cat $TmpDir/oops5.test
+        done > $TmpDir/shower.test
+
+        pushd $TmpDir
+    rlPhaseEnd
+
+    rlPhaseStartTest "Identical oopses are grouped"
+        prepare
+
+        rlRun "abrt-dump-oops storm.test -xD 2>&1 | grep 'abrt-dump-oops: Found oopses: 20'" 0 "Found 20 oopses"
+        wait_for_hooks
+
+        assert_single_oops_dir 20
+    rlPhaseEnd
+
+    rlPhaseStartTest "abrtd adds the count of a duplicate"
+        prepare
+
+        rlRun "abrt-dump-oops storm.test -xD 2>&1 | grep 'abrt-dump-oops: Found oopses: 20'" 0 "Found 20 oopses"
+        wait_for_hooks
+
+        assert_single_oops_dir 40
+    rlPhaseEnd
+
+    rlPhaseStartTest "Repeated oopses are added to the surviving directory"
+        rlRun "journalctl --flush"
+
+        rlRun "ABRT_DUMP_JOURNAL_OOPS_DEBUG_FILTER=\"SYSLOG_IDENTIFIER=abrt_test\" setsid abrt-dump-journal-oops -vvv -e -f -t -xD >watcher.log 2>&1 &"
+        rlRun "ABRT_DUMPER_PID=$!"
+        rlRun "sleep 2"
+
+        # The first shower creates a new directory which abrtd merges into
+        # the existing one, the watcher must follow it
+        prepare
+        rlRun "logger -t abrt_test -f shower.test"
+        rlRun "journalctl --flush"
+        rlRun "sleep 2"
+        wait_for_hooks
+
+        assert_single_oops_dir 45
+
+        rlRun "logger -t abrt_test -f shower.test"
+        rlRun "journalctl --flush"
+        rlRun "sleep 2"
+
+        rlAssertGrep "Added [0-9]* occurrences to '$crash_PATH'" watcher.log
+        assert_single_oops_dir 50
+
+        rlRun "kill -TERM -$ABRT_DUMPER_PID"
+    rlPhaseEnd
+
+    rlPhaseStartCleanup
+        rlBundleLogs abrt watcher.log
+        remove_problem_directory
+        rlRun "popd"
+        rlRun "rm -r $TmpDir" 0 "Removing tmp directory"
+    rlPhaseEnd
+    rlJournalPrintText
+rlJournalEnd